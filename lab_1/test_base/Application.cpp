@@ -7,38 +7,87 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <map>
 
 /* Asserts if the return was false and lunches debug break */
 #define ASSERT(x) if (!(x)) raise(SIGTRAP);
 
-#define GLCall(x) GLClearError();\
-	x;\
-	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+/* Release builds (NDEBUG) check nothing, GLCall(x) is only x */
+#ifndef NDEBUG
 
+/* 1 runs the debug callback inside the call that caused the message, so the call site is exact and
+	errors break right there, 0 lets the driver report later without slowing every call down */
+#define GL_DEBUG_SYNCHRONOUS 1
 
-/* Keep reading and clearing OpenGL error flags */
-/* A more modern approach is glDebugMessageCallback */
-static void GLClearError()
+/* Only remembers which call is being made, the driver reports errors to GLDebugMessage() */
+#define GLCall(x) do { glCallFunction = #x; glCallFile = __FILE__; glCallLine = __LINE__; x; glCallFunction = nullptr; } while (0)
+
+/* The call GLCall is making, nullptr outside of one */
+static const char* glCallFunction = nullptr;
+static const char* glCallFile = nullptr;
+static int glCallLine = 0;
+
+/* Times every message was seen from every call site, each is printed only the first time */
+static std::map<std::string, unsigned int> glMessagesSeen;
+
+/* The driver calls this for every debug message, instead of us polling glGetError around every call */
+static void APIENTRY GLDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
 {
-	while (glGetError() != GL_NO_ERROR)
-		{	
-		}
+	bool sited = GL_DEBUG_SYNCHRONOUS && glCallFunction != nullptr;
+	std::string key = std::to_string(id) + ":" + (sited ? std::string(glCallFile) + ":" + std::to_string(glCallLine) : "");
+	if (++glMessagesSeen[key] > 1)
+		return;
+
+	std::cout << "[OpenGL " << (type == GL_DEBUG_TYPE_ERROR ? "ERROR" : "MESSAGE") << "] (" << id << ") " << message;
+	if (sited)
+		std::cout << " from function: " << glCallFunction << " in file " << glCallFile << " at line " << glCallLine;
+	std::cout << std::endl;
+
+	if (sited && type == GL_DEBUG_TYPE_ERROR)
+		ASSERT(false);
 }
 
-/* Keep reading errors and display them */
-/* In order to search for an error code convert to hex and look in glew.h */
-static bool GLLogCall(const char* function, const char* file, int line)
+/* Turn the debug output on, false when the context has no KHR_debug */
+static bool GLEnableDebugOutput()
 {
-	
-	while ( GLenum currentError = glGetError() )
+	if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug)
 		{
-			std::cout << "[OpenGL ERROR] (" << currentError << ") from function: " 
-				<< function << " in file " << file << " at line " << line << std::endl;
+			std::cout << "No KHR_debug, OpenGL errors are only checked once per frame" << std::endl;
 			return false;
 		}
+	glEnable(GL_DEBUG_OUTPUT);
+	if (GL_DEBUG_SYNCHRONOUS)
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(GLDebugMessage, nullptr);
+	/* Notifications are only chatter */
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
 	return true;
 }
 
+/* Without KHR_debug, read the error flags once a frame instead of around every call */
+static void GLCheckFrame()
+{
+	while (GLenum currentError = glGetError())
+		{
+			std::cout << "[OpenGL ERROR] (" << currentError << ") during the frame" << std::endl;
+		}
+}
+
+#else
+
+#define GLCall(x) x
+
+static bool GLEnableDebugOutput()
+{
+	return true;
+}
+
+static void GLCheckFrame()
+{
+}
+
+#endif
+
 /* position data for the buffer */
 /* There were memory duplications index buffer solves this */
 float positions[] =
@@ -238,6 +287,11 @@ int main(void)
 	if (!glfwInit())
 		return -1;
 
+#ifndef NDEBUG
+	/* A debug context reports more to GLDebugMessage() */
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
+
 	/* Create a windowed mode window and its OpenGL context */
 	window = glfwCreateWindow(800, 600, "Hello World", NULL, NULL);
 	if (!window)
@@ -256,6 +310,7 @@ int main(void)
 		}
 	/* After this point we can use all the OpenGL functionality */
 	std::cout << glGetString(GL_VERSION) << std::endl;
+	bool debugOutput = GLEnableDebugOutput();
 
 	/* Define the data outside the loop, updates can happen in loop */
 	/* Define OpenGL buffers */
@@ -304,22 +359,21 @@ int main(void)
 			/* Simple legacy-Immidiade mode OpenGL */
 			//legacy_triangles();
 
-			/* Always clear errors before calling an openGL function */
-			/* Called from macro above */
-			//GLClearError();
-
 			/* Issue a draw call for the above buffer */
 			/* glDrawArrays when you don't have index buffer */
 			/* glDrawElements when you have index buffer */
 			/* If something changes the amount of data to be drawn */ 
 			//glDrawArrays(GL_TRIANGLES, 0, 6);
 
-			/* Calling the macro in order to clear and check for errors */
+			/* Calling the macro so an error is reported with this call */
 			GLCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr));
 			//glDrawElements(GL_TRIANGLES, 6, GL_INT, nullptr);
 
 			/* A Shader is a program that runs on the GPU gets the data from buffer ( GPU VRAM ) */
 	
+			if (!debugOutput)
+				GLCheckFrame();
+
 			/* Swap front and back buffers */
 			glfwSwapBuffers(window);
 	
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <cmath>
-#include <signal.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <chrono>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -10,12 +14,42 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+/* Only this include expands the implementation, headers below get the declarations */
+#undef STB_IMAGE_IMPLEMENTATION
 #include "camera.h"
 #include "shader_s.h"
+#include "shader_cache.h"
+#include "uniform_buffer.h"
+#include "exhibit.h"
+#include "render_queue.h"
+#include "texture_loader.h"
+#include "texture_cache.h"
+#include "asset_pack.h"
+#include "instance_buffer.h"
+#include "geometry_manager.h"
+#include "stream_ring.h"
+#include "frustum.h"
+#include "portal_visibility.h"
+#include "occlusion_culler.h"
+#include "clustered_lights.h"
+#include "light_culler.h"
+#include "deferred_renderer.h"
+#include "indirect_renderer.h"
+#include "headless_context.h"
+#include "camera_path.h"
+#include "benchmark_stats.h"
+#include "gpu_profiler.h"
+#include "cpu_profiler.h"
+#include "gl_debug.h"
+#include "profiler_overlay.h"
 #include "filesystem.h"
 
-#define NR_POINT_LIGHTS 5
+/* Corridor segments drawn unless "--segments N" asks for a longer hall */
 #define NUM_OF_CUBES 5
+/* Distance between two corridor segments, each one is a unit cube scaled up to this size */
+#define SEGMENT_LENGTH 4.0f
+/* Time step of a benchmark frame, the same on every run whatever the real frame rate */
+#define BENCHMARK_DELTA_TIME (1.0f / 60.0f)
 
 // TODO Now
 /* TODO make button prompts in order to change stuff on the exhibits
@@ -32,37 +66,6 @@
 // TODO make code more clean
 // TODO update windows implementation
 
-/* Asserts if the return was false and lunches debug break */
-#define ASSERT(x) if (!(x)) raise(SIGTRAP);
-
-#define GLCall(x) GLClearError();\
-	x;\
-	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
-
-
-/* Keep reading and clearing OpenGL error flags */
-/* A more modern approach is glDebugMessageCallback */
-static void GLClearError()
-{
-	while (glGetError() != GL_NO_ERROR)
-		{	
-		}
-}
-
-/* Keep reading errors and display them */
-/* In order to search for an error code convert to hex and look in glew.h */
-static bool GLLogCall(const char* function, const char* file, int line)
-{
-	
-	while ( GLenum currentError = glGetError() )
-		{
-			std::cout << "[OpenGL ERROR] (" << currentError << ") from function: " 
-				<< function << " in file " << file << " at line " << line << std::endl;
-			return false;
-		}
-	return true;
-}
-
 /* Tell GLFW we want to call this function on every window resize by registering it */
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
@@ -73,11 +76,80 @@ void processInput(GLFWwindow *window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 
-unsigned int loadTexture(const char *path);
+
+/* Uniform handles, resolved once from the shaders uniform table before the render loop */
+/* Projection, view and the lights come from the uniform buffers in uniform_buffer.h */
+struct TransformUniforms
+{
+	GLint model;
+};
+
+/* Exhibit 7 and 8 single light with a material */
+struct LitCubeUniforms : TransformUniforms
+{
+	struct
+	{
+		GLint position;
+		GLint ambient;
+		GLint diffuse;
+		GLint specular;
+	} light;
+	struct
+	{
+		GLint ambient;
+		GLint diffuse;
+		GLint specular;
+		GLint shininess;
+	} material;
+};
+
+TransformUniforms getTransformUniforms(const Shader &shader);
+LitCubeUniforms getLitCubeUniforms(const Shader &shader);
+
+/* What the light and material switch of exhibit 7 and 8 needs */
+struct LitCubeSettings
+{
+	LitCubeUniforms uniforms;
+	glm::vec3 lightPosition;
+	/* Ambient of the 3rd state as a fraction of the diffuse colour */
+	float fixedAmbientStrength;
+};
+
+/* Light and material of exhibit 7 and 8 in one interaction state */
+struct LitCubeParameters
+{
+	glm::vec3 lightAmbient;
+	glm::vec3 lightDiffuse;
+	glm::vec3 lightSpecular;
+	glm::vec3 materialAmbient;
+	glm::vec3 materialDiffuse;
+	glm::vec3 materialSpecular;
+	float shininess;
+};
+
+LitCubeParameters getLitCubeParameters(const LitCubeSettings &settings, int state, double time);
+
+/* Exhibit::prepare hook of exhibit 7 and 8, prepareData points to a LitCubeSettings */
+void setLitCubeUniforms(const Exhibit &exhibit, int state, double time);
+/* Exhibit::prepareIndirect hook of the same exhibits */
+void setLitCubeIndirect(const Exhibit &exhibit, int state, double time, IndirectObject &object);
+
+/* Print the average CPU time of the exhibit submission in one drawing mode */
+void reportExhibitTiming(int indirect, double milliseconds, unsigned int frames, size_t draws, size_t batched);
+
+LightBlock makeCorridorLights(glm::vec3 dirAmbient, glm::vec3 dirDiffuse, glm::vec3 dirSpecular, glm::vec3 pointLightTint);
+/* White point lights at the given positions, for ClusteredLights */
+std::vector<PointLightBlock> makePointLights(const glm::vec3 *pointLightPositions, unsigned int count);
 
 /* function that autodetects the max resolution*/
 void get_resolution();
 
+/* Initialize GLFW, open the fullscreen window and load OpenGL through it, NULL when any of it failed */
+GLFWwindow* createWindow();
+
+/* Seconds since start, from GLFW with a window and from the headless context without one */
+double frameClock();
+
 /* const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720; */
 
@@ -102,57 +174,143 @@ int interact_2_exhibit = 0;
 int interact_2b_exhibit = 0;
 int interact_3_exhibit = 0;
 int interact_4_exhibit = 0;
+/* M switches the exhibits between one draw each and a single multi draw indirect, see IndirectRenderer */
+int indirect_draw = 0;
+/* O switches the Hi-Z occlusion test of the indirect batch, see OcclusionCuller */
+int occlusion_culling = 1;
+/* "--deferred" lights the corridor from a G-buffer instead of while drawing it, see DeferredRenderer */
+int deferred_shading = 0;
+/* P or "--profile" times the passes and exhibits on the GPU and shows them over the scene, see GpuProfiler */
+int gpu_profiling = 0;
+/* I prints the culling, light, state change and streaming counters of the frame once, a headless run prints those of its last frame */
+int print_stats = 0;
+/* "--gl-debug" asks for a debug context and prints the driver's messages, "--gl-debug-sync" (2) as they happen, see GLDebugOutput */
+int gl_debug = 0;
+/* "--headless WIDTHxHEIGHT" draws into a framebuffer object without a window or display server, see HeadlessContext */
+int headless = 0;
+HeadlessContext headlessContext;
+/* "--benchmark file.path" flies the camera along a CameraPath and measures every frame, see BenchmarkStats */
+int benchmark = 0;
 
 int main(int argc, char const *argv[])
 {
-	/* Initialize the library */
-	if( !glfwInit() )
+	/* The cells and portals of the museum come from museum.scene, "--scene file" reads another one and
+		"--segments N" builds a straight corridor of N cells instead. Every cell is one corridor segment,
+		all of them drawn by the same three instanced calls */
+	const char *scenePath = "museum.scene";
+	unsigned int generatedSegments = 0;
+	/* Headless runs stop on their own after "--frames N" frames, "--output file.ppm" saves the last one.
+		A benchmark renders "--warmup N" frames at the start of its path, then measures "--frames N" along it
+		and writes the statistics to "--benchmark-output file.json" */
+	unsigned int frameCount = 0;
+	const char *outputPath = NULL;
+	CameraPath benchmarkPath;
+	const char *benchmarkPathName = "";
+	unsigned int warmupFrames = 10;
+	const char *benchmarkOutput = "benchmark.json";
+	/* The GPU profiler's rolling averages are appended to "--profile-csv file.csv" while it runs */
+	const char *profileCSV = NULL;
+	/* "--trace FIRST:LAST" records the CPU scopes of those frames into "--trace-output file.json", see CpuProfiler */
+	unsigned int traceFirst = 0;
+	unsigned int traceLast = 0;
+	bool trace = false;
+	const char *traceOutput = "trace.json";
+	for (int i = 1; i + 1 < argc; i++)
 		{
-			fprintf( stderr, "Failed to initialize GLFW\n" );
-			getchar();
-			return -1;
+			if (strcmp(argv[i], "--segments") == 0 && atoi(argv[i + 1]) > 0)
+				generatedSegments = atoi(argv[i + 1]);
+			if (strcmp(argv[i], "--scene") == 0)
+				scenePath = argv[i + 1];
+			if (strcmp(argv[i], "--headless") == 0 && sscanf(argv[i + 1], "%ux%u", &SCR_WIDTH, &SCR_HEIGHT) == 2 && SCR_WIDTH > 0 && SCR_HEIGHT > 0)
+				headless = 1;
+			if (strcmp(argv[i], "--frames") == 0 && atoi(argv[i + 1]) > 0)
+				frameCount = atoi(argv[i + 1]);
+			if (strcmp(argv[i], "--output") == 0)
+				outputPath = argv[i + 1];
+			if (strcmp(argv[i], "--benchmark") == 0)
+				{
+					if (!benchmarkPath.load(argv[i + 1]))
+						return -1;
+					benchmark = 1;
+					benchmarkPathName = argv[i + 1];
+				}
+			if (strcmp(argv[i], "--warmup") == 0)
+				{
+					char *end;
+					long warmup = strtol(argv[i + 1], &end, 10);
+					if (end == argv[i + 1] || *end != '\0' || warmup < 0 || warmup > 1000000)
+						{
+							std::cout << "Benchmark: --warmup takes a number of frames, not " << argv[i + 1] << std::endl;
+							return -1;
+						}
+					warmupFrames = (unsigned int)warmup;
+				}
+			if (strcmp(argv[i], "--benchmark-output") == 0)
+				benchmarkOutput = argv[i + 1];
+			if (strcmp(argv[i], "--profile-csv") == 0)
+				profileCSV = argv[i + 1];
+			if (strcmp(argv[i], "--trace") == 0 && sscanf(argv[i + 1], "%u:%u", &traceFirst, &traceLast) == 2 && traceFirst <= traceLast)
+				trace = true;
+			if (strcmp(argv[i], "--trace-output") == 0)
+				traceOutput = argv[i + 1];
 		}
-
-	/* Adding extra openGL options and version */
-	glfwWindowHint(GLFW_SAMPLES, 256);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-	/* We don't want the old OpenGL */
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);  
-
-	/* Auto retrieve and select primary monitors max resolution */
-	get_resolution();
-
-	/* Create a window in full screen and set its OpenGL context */
-	GLFWwindow* window = glfwCreateWindow( SCR_WIDTH, SCR_HEIGHT, "Computer Graphics Course-OpenGL Project", glfwGetPrimaryMonitor(), NULL);
-	if( window == NULL )
+	/* Frames the render loop stops after, 0 runs until the window is closed */
+	unsigned int frameLimit = 0;
+	if (benchmark)
+		frameLimit = warmupFrames + (frameCount > 0 ? frameCount : 600);
+	else if (headless)
+		frameLimit = frameCount > 0 ? frameCount : 60;
+	CPU_PROFILE_THREAD("main");
+	if (trace)
+		CPU_PROFILE_CAPTURE(traceFirst, traceLast, traceOutput);
+	SceneDescription scene;
+	if (generatedSegments > 0)
+		scene = makeCorridorScene(generatedSegments, SEGMENT_LENGTH);
+	else if (!loadScene(scenePath, scene) || scene.cells.empty())
 		{
-			fprintf( stderr, "Failed to open GLFW window.\n" );
-			glfwTerminate();
-			return -1;
+			std::cout << "Scene: can not use " << scenePath << ", building a corridor of " << NUM_OF_CUBES << " segments" << std::endl;
+			scene = makeCorridorScene(NUM_OF_CUBES, SEGMENT_LENGTH);
+		}
+	unsigned int corridorSegments = (unsigned int)scene.cells.size();
+	/* "--indirect" starts with the exhibits on the indirect path, "--deferred" picks deferred shading for the whole run,
+		"--profile" starts with the GPU profiler on, "--gl-debug" and "--gl-debug-sync" turn on driver messages */
+	for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--indirect") == 0)
+				indirect_draw = 1;
+			if (strcmp(argv[i], "--deferred") == 0)
+				deferred_shading = 1;
+			if (strcmp(argv[i], "--profile") == 0)
+				gpu_profiling = 1;
+			if (strcmp(argv[i], "--gl-debug") == 0 && gl_debug == 0)
+				gl_debug = 1;
+			if (strcmp(argv[i], "--gl-debug-sync") == 0)
+				gl_debug = 2;
 		}
-	
-	/* Make the window's context current */
-	glfwMakeContextCurrent(window);
-
-	/* Tell GLFW we want to call this function on every window resize by registering it */
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
-	/* Set the callback functions to be called on every mouse event */
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
-
-	/* Tell GLFW to capture our mouse */
-  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);	
 
-	/* Glad: load all OpenGL function pointers */
-	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	/* Either a window on the primary monitor or, with "--headless", a context of its own and an offscreen framebuffer */
+	GLFWwindow* window = NULL;
+	if (headless)
 		{
-			std::cout << "Failed to initialize GLAD" << std::endl;
-			return -1;
+			if (!headlessContext.create(gl_debug != 0))
+				return -1;
+			if (!gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress))
+				{
+					std::cout << "Failed to initialize GLAD" << std::endl;
+					return -1;
+				}
+			headlessContext.createFramebuffer(SCR_WIDTH, SCR_HEIGHT);
+		}
+	else
+		{
+			window = createWindow();
+			if (window == NULL)
+				return -1;
 		}
 	/* After this point we can use all the OpenGL functionality */
 	std::cout << glGetString(GL_VERSION) << std::endl;
+	if (gl_debug)
+		GLDebugOutput::enable(gl_debug == 2);
 
 	/* The vertex shader each input variable is also known as a vertex attribute*/
 	unsigned int nrAttributes;
@@ -185,35 +343,65 @@ int main(int argc, char const *argv[])
 	/* SHADER HERE */
 	/* Build and compile our shader program */
 
-	/* Corridor shader */
-  Shader wall_Shader("wall_shader.vs", "wall_shader.fs");
-	Shader floor_Shader("floor_shader.vs", "floor_shader.fs");
-	Shader celling_Shader("celling_shader.vs", "celling_shader.fs");
+	/* Programs built from the same sources are compiled once and shared, so the exhibits below
+		that reuse a pair of files all refer to one program. Linked programs are kept in program_cache/
+		so the next launch can skip compiling */
+	/* Shaders and textures packed by "make pack" come from one mapped file, anything it does not hold
+		is read from its own file as before. Declared first so it outlives everything that points into it */
+	AssetPack assets;
+	if (assets.open("assets.pak"))
+		std::cout << "Asset pack: " << assets.size() << " files mapped from assets.pak" << std::endl;
+	else
+		std::cout << "Asset pack: assets.pak not found, reading loose files" << std::endl;
+
+	ShaderCache shaderCache("program_cache", &assets);
 
-	Shader lampShader("lamp.vs", "lamp.fs");
+	/* Corridor shader, lit by the clustered point lights so they are built with the grid size */
+	std::string clusterDefines = ClusteredLights::defines();
+  Shader &wall_Shader = shaderCache.get("wall_shader.vs", "wall_shader.fs", nullptr, clusterDefines);
+	Shader &floor_Shader = shaderCache.get("floor_shader.vs", "floor_shader.fs", nullptr, clusterDefines);
+	Shader &celling_Shader = shaderCache.get("celling_shader.vs", "celling_shader.fs", nullptr, clusterDefines);
+	/* Lists the point lights reaching every cluster */
+	Shader &cluster_assignShader = shaderCache.getCompute("cluster_assign.comp", clusterDefines);
+	/* The same surfaces on the deferred path, written to the G-buffer and lit in one pass over the window */
+	Shader &gbuffer_corridorShader = shaderCache.get("wall_shader.vs", "gbuffer_corridor.fs");
+	Shader &deferred_lightingShader = shaderCache.get("deferred_lighting.vs", "deferred_lighting.fs", nullptr, clusterDefines);
+	/* Text and bars of the GPU profiler, in window pixels */
+	Shader &profiler_overlayShader = shaderCache.get("profiler_overlay.vs", "profiler_overlay.fs");
+
+	Shader &lampShader = shaderCache.get("lamp.vs", "lamp.fs");
 
 	/* exhibits shader */
-	Shader exhibit_triangleShader("triangle.vs", "triangle.fs");
-	Shader exhibit_squareShader("triangle.vs", "triangle.fs");
+	Shader &exhibit_triangleShader = shaderCache.get("triangle.vs", "triangle.fs");
+	Shader &exhibit_squareShader = shaderCache.get("triangle.vs", "triangle.fs");
 
-	Shader exhibit_triangleColourShader("triangle.vs", "triangle.fs");
-	Shader exhibit_triangleColourRotationShader("triangle.vs", "triangle.fs");
+	Shader &exhibit_triangleColourShader = shaderCache.get("triangle.vs", "triangle.fs");
+	Shader &exhibit_triangleColourRotationShader = shaderCache.get("triangle.vs", "triangle.fs");
 
-	Shader exhibit_squareTextureShader("exhibit_5_texture.vs", "exhibit_5_texture.fs");
-	Shader exhibit_cubeTextureShader("exhibit_5_texture.vs", "exhibit_5_texture.fs");
+	Shader &exhibit_squareTextureShader = shaderCache.get("exhibit_5_texture.vs", "exhibit_5_texture.fs");
+	Shader &exhibit_cubeTextureShader = shaderCache.get("exhibit_5_texture.vs", "exhibit_5_texture.fs");
 
-	Shader exhibit_cubeMultyLightColourShader("exhibit_7_light_colour.vs", "exhibit_7_light_colour.fs");
-	Shader exhibit_7_lamp("lamp.vs", "lamp.fs" );
+	Shader &exhibit_cubeMultyLightColourShader = shaderCache.get("exhibit_7_light_colour.vs", "exhibit_7_light_colour.fs");
+	Shader &exhibit_7_lamp = shaderCache.get("lamp.vs", "lamp.fs");
 
 	/* exhibit explanation shader */
-	Shader exhibit_explanationShader("square.vs", "square.fs");
-	Shader exhibit_explanation2Shader("square.vs", "square.fs");
-	Shader exhibit_explanation3Shader("square.vs", "square.fs");
-	Shader exhibit_explanation4Shader("square.vs", "square.fs");
-	Shader exhibit_explanation5Shader("square.vs", "square.fs");
-	Shader exhibit_explanation6Shader("square.vs", "square.fs");
-	Shader exhibit_explanation7Shader("square.vs", "square.fs");
-	Shader exhibit_explanation8Shader("square.vs", "square.fs");
+	Shader &exhibit_explanationShader = shaderCache.get("square.vs", "square.fs");
+	Shader &exhibit_explanation2Shader = shaderCache.get("square.vs", "square.fs");
+	Shader &exhibit_explanation3Shader = shaderCache.get("square.vs", "square.fs");
+	Shader &exhibit_explanation4Shader = shaderCache.get("square.vs", "square.fs");
+	Shader &exhibit_explanation5Shader = shaderCache.get("square.vs", "square.fs");
+	Shader &exhibit_explanation6Shader = shaderCache.get("square.vs", "square.fs");
+	Shader &exhibit_explanation7Shader = shaderCache.get("square.vs", "square.fs");
+	Shader &exhibit_explanation8Shader = shaderCache.get("square.vs", "square.fs");
+
+	/* Every exhibit at once on the indirect path */
+	Shader &exhibit_indirectShader = shaderCache.get("exhibit_indirect.vs", "exhibit_indirect.fs");
+	/* Occluder depth, its Hi-Z pyramid and the test of the indirect batch against it */
+	Shader &depth_prepassShader = shaderCache.get("depth_prepass.vs", "depth_prepass.fs");
+	Shader &hiz_downsampleShader = shaderCache.getCompute("hiz_downsample.comp");
+	Shader &occlusion_cullShader = shaderCache.getCompute("occlusion_cull.comp");
+
+	shaderCache.printStats();
 
 	/* Set up vertex data (and buffer(s)) and configure vertex attributes */
 
@@ -443,21 +631,6 @@ int main(int argc, char const *argv[])
 			glm::vec3( -1.9f,  0.0f,  -14.5f)
 		};
 
-	/* World space positions of our cubes */
-	glm::vec3 cubePositions[] = 
-		{
-			glm::vec3( 0.0f,  0.0f,  0.0f),
-			glm::vec3( 0.0f,  0.0f, -4.0f),
-			glm::vec3( 0.0f,  0.0f, -8.0f),
-			glm::vec3( 0.0f,  0.0f, -12.0f),
-			glm::vec3( 0.0f,  0.0f, -16.0f),
-			glm::vec3( 0.0f,  0.0f, -20.0f),
-			glm::vec3( 0.0f,  0.0f, -24.0f),
-			glm::vec3( 0.0f,  0.0f, -28.0f),
-			glm::vec3( 0.0f,  0.0f, -32.0f),
-			glm::vec3( 0.0f,  0.0f, -36.0f),
-			glm::vec3( 0.0f,  0.0f, -40.0f)
-		};
 	/* Positions of the point lights */
 	glm::vec3 pointLightPositions[] = 
 		{
@@ -474,372 +647,509 @@ int main(int argc, char const *argv[])
 			glm::vec3( 0.0f,  1.85f, -42.0f),
 
 		};
+	/* Only the lamps hanging inside the scene light it, a short museum ends before the last ones */
+	std::vector<glm::vec3> sceneLightPositions;
+	for (size_t i = 0; i < sizeof(pointLightPositions) / sizeof(pointLightPositions[0]); i++)
+		if (sceneContains(scene, pointLightPositions[i]))
+			sceneLightPositions.push_back(pointLightPositions[i]);
+	unsigned int pointLightCount = (unsigned int)sceneLightPositions.size();
 	/* Vertext Buffer Object, Vertex Array Object, Element Buffer Objects */
 	/* VAO points attributes to positons in the VBO according to the stride as well as an EBO */
 	/* EBO is a buffer, just like a vertex buffer object, that stores indices that OpenGL uses to decide what vertices to draw */
 
-	/* Wall buffer preparation and initialization */
-
-	unsigned int wall_VBO, wall_VAO;
-	glGenVertexArrays(1, &wall_VAO);
-	glGenBuffers(1, &wall_VBO);
-
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).*/
-	glBindVertexArray(wall_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, wall_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wall_vertices), wall_vertices, GL_STATIC_DRAW);
-
-	/* We have to specify how OpenGL should interpret the vertex data before rendering */
-	/* Position attribute */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	/* Normal attribute */
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-	/* Texture coord attribute */
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-
-	/* Note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind */
-	glBindBuffer(GL_ARRAY_BUFFER, 0); 
-
-	/* Floor buffer preparation and initialization */
-
-	unsigned int floor_VBO, floor_VAO;
-	glGenVertexArrays(1, &floor_VAO);
-	glGenBuffers(1, &floor_VBO);
-
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).*/
-	glBindVertexArray(floor_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, floor_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(floor_vertices), floor_vertices, GL_STATIC_DRAW);
-
-	/* We have to specify how OpenGL should interpret the vertex data before rendering */
-	/* Position attribute */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	/* Normal attribute */
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-	/* Texture coord attribute */
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-
-	/* Note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind */
-	glBindBuffer(GL_ARRAY_BUFFER, 0); 
-
-	/* Celling buffer preparation and initialization */
-
-	unsigned int celling_VBO, celling_VAO;
-	glGenVertexArrays(1, &celling_VAO);
-	glGenBuffers(1, &celling_VBO);
-
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).*/
-	glBindVertexArray(celling_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, celling_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(celling_vertices), celling_vertices, GL_STATIC_DRAW);
-
-	/* We have to specify how OpenGL should interpret the vertex data before rendering */
-	/* Position attribute */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	/* Normal attribute */
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
-
-	/* Texture coord attribute */
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-  glEnableVertexAttribArray(2);
-
-	/* Note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind */
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	
-	/* Spot light sources buffer preparation and initialization */
-
-	/* Second, configure the light's VAO (VBO stays the same; the vertices are the same for the light object which is also a 3D cube) */
-	unsigned int lightVAO;
-	glGenVertexArrays(1, &lightVAO);
-	glBindVertexArray(lightVAO);
-
-	/* We only need to bind to the celling_VBO (to link it with glVertexAttribPointer), no need to fill it; the VBO's data already contains all we need (it's already bound, but we do it again for educational purposes) */
-	glBindBuffer(GL_ARRAY_BUFFER, celling_VBO);
-	/* Note that we update the lamp's position attribute's stride to reflect the updated buffer data */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	/* Exhibit explenations ( and general squares that need textures ) buffer preparation and initialization */
-
-	unsigned int exhibit_explenations_VBO, exhibit_explenations_VAO, exhibit_explenations_EBO;
-	glGenVertexArrays(1, &exhibit_explenations_VAO);
-	glGenBuffers(1, &exhibit_explenations_VBO);
-	glGenBuffers(1, &exhibit_explenations_EBO);
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).*/
-	glBindVertexArray(exhibit_explenations_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, exhibit_explenations_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(square_vertices_texture), square_vertices_texture, GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, exhibit_explenations_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(square_vertices_indices), square_vertices_indices, GL_STATIC_DRAW);
-
-	/* We have to specify how OpenGL should interpret the vertex data before rendering */
-	/* Position attribute */
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	/* Texture coord attribute */
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	/* Note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind */
-	glBindBuffer(GL_ARRAY_BUFFER, 0); 
-
-	/* You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-			VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary. */
-	glBindVertexArray(0); 
-
-	/* Exhibit 1 basic triangle buffer preparation and initialization */
-
-	unsigned int exhibit_1_VBO, exhibit_1_VAO;
-	glGenVertexArrays(1, &exhibit_1_VAO);
-	glGenBuffers(1, &exhibit_1_VBO);
-
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s). */
-	glBindVertexArray(exhibit_1_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, exhibit_1_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(square_triangle_vertices), square_triangle_vertices, GL_DYNAMIC_DRAW);
-
-	/* Position attribute */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	/* Colour attribute */
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-  
-	glBindVertexArray(0);
-
-	/* Exhibit 2 basic square ( as well as any square shape ) buffer preparation and initialization */
-
-	unsigned int exhibit_2_VBO, exhibit_2_VAO, exhibit_2_EBO;
-	glGenVertexArrays(1, &exhibit_2_VAO);
-	glGenBuffers(1, &exhibit_2_VBO);
-	glGenBuffers(1, &exhibit_2_EBO);
-
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s). */
-	glBindVertexArray(exhibit_2_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, exhibit_2_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(square_vertices), square_vertices, GL_DYNAMIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, exhibit_2_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(square_vertices_indices), square_vertices_indices, GL_DYNAMIC_DRAW);
-
-	/* Position attribute */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	/* Colour attribute */
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);	
-
-	/* Note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind */
-	glBindBuffer(GL_ARRAY_BUFFER, 0); 
-
-	glBindVertexArray(0);
-
-	/* Exhibit 3 basic triangle with colour interpolation buffer preparation and initialization */
-
-	unsigned int exhibit_3_VBO, exhibit_3_VAO;
-	glGenVertexArrays(1, &exhibit_3_VAO);
-	glGenBuffers(1, &exhibit_3_VBO);
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s). */
-	glBindVertexArray(exhibit_3_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, exhibit_3_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(square_triangle_vertices_colour), square_triangle_vertices_colour, GL_DYNAMIC_DRAW);
-
-	/* Position attribute */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	/* Colour attribute */
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-  
-	glBindVertexArray(0);
-
-	/* Exhibit 6 cube with texture buffer preparation and initialization */
-
-	unsigned int exhibit_6_VBO, exhibit_6_VAO;
-	glGenVertexArrays(1, &exhibit_6_VAO);
-	glGenBuffers(1, &exhibit_6_VBO);
-
-	/* Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).*/
-	glBindVertexArray(exhibit_6_VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, exhibit_6_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(texture_cube_vertices), texture_cube_vertices, GL_STATIC_DRAW);
-
-	/* We have to specify how OpenGL should interpret the vertex data before rendering */
-	/* Position attribute */
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	/* Texture coord attribute */
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	/* Note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind */
-	glBindBuffer(GL_ARRAY_BUFFER, 0); 
-
-	/* You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-			VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary. */
-	glBindVertexArray(0); 
-
-	/* Exhibit 7 cube with basic lighting and revolving colours buffer preparation and initialization */
-
-	unsigned int exhibit_7_VBO, exhibit_7_VAO;
-	glGenVertexArrays(1, &exhibit_7_VAO);
-	glGenBuffers(1, &exhibit_7_VBO);
-
-	/*Bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).*/
-	glBindBuffer(GL_ARRAY_BUFFER, exhibit_7_VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(normals_cube_vertices), normals_cube_vertices, GL_STATIC_DRAW);
-
-	glBindVertexArray(exhibit_7_VAO);
+	/* Every mesh with the same vertex layout shares one VBO, EBO and VAO, the geometry manager hands out
+		where in those buffers each mesh is. Drawing a mesh binds its format's VAO and passes the offsets on */
+	GeometryManager geometry;
+
+	/* Position, normal and texture coords: the corridor */
+	VertexAttribute surfaceAttributes[] = { { 0, 3, 0 }, { 1, 3, 3 }, { 2, 2, 6 } };
+	int surfaceFormat = geometry.addFormat(8, surfaceAttributes, 3);
+	/* Position and a vec3 at location 1: the colour of the triangle shader or the normal of the lit cube */
+	VertexAttribute colourAttributes[] = { { 0, 3, 0 }, { 1, 3, 3 } };
+	int colourFormat = geometry.addFormat(6, colourAttributes, 2);
+	/* Position and texture coords: the textured exhibits and the explanations */
+	VertexAttribute textureAttributes[] = { { 0, 3, 0 }, { 1, 2, 3 } };
+	int textureFormat = geometry.addFormat(5, textureAttributes, 2);
+
+	/* Corridor surfaces */
+	GeometryHandle wall_geometry = geometry.add(surfaceFormat, wall_vertices, 12);
+	GeometryHandle floor_geometry = geometry.add(surfaceFormat, floor_vertices, 6);
+	GeometryHandle celling_geometry = geometry.add(surfaceFormat, celling_vertices, 6);
+	unsigned int corridor_VAO = geometry.vertexArray(surfaceFormat);
+
+	/* Exhibits, the vertices of 1 and 2 are streamed with the colour of their interaction state, their handles
+		only place the indices */
+	GeometryHandle exhibit_1_geometry = geometry.add(colourFormat, square_triangle_vertices, 3);
+	GeometryHandle exhibit_2_geometry = geometry.add(colourFormat, square_vertices, 4, square_vertices_indices, 6);
+	GeometryHandle exhibit_3_geometry = geometry.add(colourFormat, square_triangle_vertices_colour, 3);
+	GeometryHandle exhibit_7_geometry = geometry.add(colourFormat, normals_cube_vertices, 36);
+	GeometryHandle exhibit_explenations_geometry = geometry.add(textureFormat, square_vertices_texture, 4, square_vertices_indices, 6);
+	GeometryHandle exhibit_6_geometry = geometry.add(textureFormat, texture_cube_vertices, 36);
+
+	/* Corridor segments, one model matrix per scene cell. Walls, floor and celling share the same placement,
+		so they all read their per instance matrices from one storage buffer */
+	std::vector<glm::mat4> segmentModels(corridorSegments);
+	for (unsigned int i = 0; i < corridorSegments; i++)
+		{
+			/* place the unit segment in the middle of its cell */
+			segmentModels[i] = glm::translate(glm::mat4(1.0f), (scene.cells[i].min + scene.cells[i].max) * 0.5f);
+			/* enlarge the cube to fill the cell */
+			segmentModels[i] = glm::scale(segmentModels[i], scene.cells[i].max - scene.cells[i].min);
+		}
+	InstanceBuffer corridorInstances;
+	corridorInstances.upload(segmentModels);
+	/* The segments drawn this frame, in cell order */
+	std::vector<GLuint> drawnSegments;
+	drawnSegments.reserve(corridorSegments);
 
-	/* We have to specify how OpenGL should interpret the vertex data before rendering */
-	/* Position attribute */
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	/* Normal attribute */
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-  glEnableVertexAttribArray(1);
+	/* Spot light sources are drawn with the celling quad, the lamp shader only reads the position */
 
-	/* You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-			VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary. */
-	glBindVertexArray(0); 
-	
 	/* Load textures (we now use a utility function to keep the code more organized) */
+	/* Images are decoded on worker threads, until one is uploaded its texture shows a gray placeholder */
+	TextureLoader textureLoader;
+	/* The same file, or the same image under another name, is loaded once and shared */
+	TextureCache textureCache(textureLoader, &assets);
+	/* Every file below read and hashed on worker threads at once, the acquire() calls then only look them up */
+	static const char *textureFiles[] = {
+		"gray.jpg", "Wooden_Wall.jpg", "celling2.jpg",
+		"exhibit_explenation_1_red.jpg", "exhibit_explenation_1_green.jpg", "exhibit_explenation_1_blue.jpg",
+		"exhibit_explenation_2_red.jpg", "exhibit_explenation_2_green.jpg", "exhibit_explenation_2_blue.jpg",
+		"exhibit_explenation_3.jpg", "exhibit_explenation_4.jpg", "exhibit_explenation_5.jpg", "exhibit_explenation_5_swap.jpg",
+		"exhibit_explenation_6.jpg", "exhibit_explenation_6_swap.jpg", "exhibit_explenation_7.jpg", "exhibit_explenation_8.jpg",
+		"exhibit_explenation_8_case1.jpg", "exhibit_explenation_8_case2.jpg", "opengl.png", "container2.png", "awesomeface.jpg"
+	};
+	textureCache.prefetch(textureFiles, sizeof(textureFiles) / sizeof(textureFiles[0]));
+
 	/* Load textures for the wall */
-  unsigned int diffuseMap_wall = loadTexture(FileSystem::getPath("gray.jpg").c_str());
-	unsigned int specularMap_wall = loadTexture(FileSystem::getPath("gray.jpg").c_str());
+  unsigned int diffuseMap_wall = textureCache.acquire("gray.jpg");
+	unsigned int specularMap_wall = textureCache.acquire("gray.jpg");
 
 	/* Load textures for the floor*/
-	unsigned int diffuseMap_floor = loadTexture(FileSystem::getPath("Wooden_Wall.jpg").c_str());
-	unsigned int specularMap_floor = loadTexture(FileSystem::getPath("Wooden_Wall.jpg").c_str());
+	unsigned int diffuseMap_floor = textureCache.acquire("Wooden_Wall.jpg");
+	unsigned int specularMap_floor = textureCache.acquire("Wooden_Wall.jpg");
 
 	/* Load textures for the celling */
-	unsigned int diffuseMap_celling = loadTexture(FileSystem::getPath("celling2.jpg").c_str());
-	unsigned int specularMap_celling = loadTexture(FileSystem::getPath("celling2.jpg").c_str());
+	unsigned int diffuseMap_celling = textureCache.acquire("celling2.jpg");
+	unsigned int specularMap_celling = textureCache.acquire("celling2.jpg");
 
 	/* Load textures for explenations */
 	/* Texture of the 1st explenation changes to reflect code changes */
-	unsigned int text_texture_1_red = loadTexture(FileSystem::getPath("exhibit_explenation_1_red.jpg").c_str());
-	unsigned int text_texture_1_green = loadTexture(FileSystem::getPath("exhibit_explenation_1_green.jpg").c_str());
-	unsigned int text_texture_1_blue = loadTexture(FileSystem::getPath("exhibit_explenation_1_blue.jpg").c_str());
+	unsigned int text_texture_1_red = textureCache.acquire("exhibit_explenation_1_red.jpg");
+	unsigned int text_texture_1_green = textureCache.acquire("exhibit_explenation_1_green.jpg");
+	unsigned int text_texture_1_blue = textureCache.acquire("exhibit_explenation_1_blue.jpg");
 
-	unsigned int text_texture_2_red = loadTexture(FileSystem::getPath("exhibit_explenation_2_red.jpg").c_str());
-	unsigned int text_texture_2_green = loadTexture(FileSystem::getPath("exhibit_explenation_2_green.jpg").c_str());
-	unsigned int text_texture_2_blue = loadTexture(FileSystem::getPath("exhibit_explenation_2_blue.jpg").c_str());
+	unsigned int text_texture_2_red = textureCache.acquire("exhibit_explenation_2_red.jpg");
+	unsigned int text_texture_2_green = textureCache.acquire("exhibit_explenation_2_green.jpg");
+	unsigned int text_texture_2_blue = textureCache.acquire("exhibit_explenation_2_blue.jpg");
 
-	unsigned int text_texture_3 = loadTexture(FileSystem::getPath("exhibit_explenation_3.jpg").c_str());
-	unsigned int text_texture_4 = loadTexture(FileSystem::getPath("exhibit_explenation_4.jpg").c_str());
+	unsigned int text_texture_3 = textureCache.acquire("exhibit_explenation_3.jpg");
+	unsigned int text_texture_4 = textureCache.acquire("exhibit_explenation_4.jpg");
 
-	unsigned int text_texture_5 = loadTexture(FileSystem::getPath("exhibit_explenation_5.jpg").c_str());
-	unsigned int text_texture_5_swap = loadTexture(FileSystem::getPath("exhibit_explenation_5_swap.jpg").c_str());
+	unsigned int text_texture_5 = textureCache.acquire("exhibit_explenation_5.jpg");
+	unsigned int text_texture_5_swap = textureCache.acquire("exhibit_explenation_5_swap.jpg");
 
-	unsigned int text_texture_6 = loadTexture(FileSystem::getPath("exhibit_explenation_6.jpg").c_str());
-	unsigned int text_texture_6_swap = loadTexture(FileSystem::getPath("exhibit_explenation_6_swap.jpg").c_str());
+	unsigned int text_texture_6 = textureCache.acquire("exhibit_explenation_6.jpg");
+	unsigned int text_texture_6_swap = textureCache.acquire("exhibit_explenation_6_swap.jpg");
 
-	unsigned int text_texture_7 = loadTexture(FileSystem::getPath("exhibit_explenation_7.jpg").c_str());
-	unsigned int text_texture_8 = loadTexture(FileSystem::getPath("exhibit_explenation_8.jpg").c_str());
-	unsigned int text_texture_8_case1 = loadTexture(FileSystem::getPath("exhibit_explenation_8_case1.jpg").c_str());
-	unsigned int text_texture_8_case2 = loadTexture(FileSystem::getPath("exhibit_explenation_8_case2.jpg").c_str());
+	unsigned int text_texture_7 = textureCache.acquire("exhibit_explenation_7.jpg");
+	unsigned int text_texture_8 = textureCache.acquire("exhibit_explenation_8.jpg");
+	unsigned int text_texture_8_case1 = textureCache.acquire("exhibit_explenation_8_case1.jpg");
+	unsigned int text_texture_8_case2 = textureCache.acquire("exhibit_explenation_8_case2.jpg");
 
 
-	unsigned int openGL_logo = loadTexture(FileSystem::getPath("opengl.png").c_str());
+	unsigned int openGL_logo = textureCache.acquire("opengl.png");
 
 	/* Load textures for exhibit 5 square  with texture */
-	unsigned int exhibit_5_texture_1 = loadTexture(FileSystem::getPath("container2.png").c_str());
-	unsigned int exhibit_5_texture_2 = loadTexture(FileSystem::getPath("awesomeface.jpg").c_str());
+	unsigned int exhibit_5_texture_1 = textureCache.acquire("container2.png");
+	unsigned int exhibit_5_texture_2 = textureCache.acquire("awesomeface.jpg");
 
 	/* Shader configuration set the textures */
 	/* Shader for the walls */
 	wall_Shader.use();
 	wall_Shader.setInt("material.diffuseMap_wall", 0);
 	wall_Shader.setInt("material.specularMap_wall", 1);	
+	wall_Shader.setFloat("material.shininess", 32.0f);
 
 	/* Shader for the floor */
 	floor_Shader.use();
 	floor_Shader.setInt("material.diffuseMap_floor",0);
 	floor_Shader.setInt("material.specularMap_floor",1);
+	floor_Shader.setFloat("material.shininess", 32.0f);
 
 	/* Shader for the celling */
 	celling_Shader.use();
 	celling_Shader.setInt("material.diffuseMap_celling",0);
 	celling_Shader.setInt("material.specularMap_celling",1);
+	celling_Shader.setFloat("material.shininess", 32.0f);
 
+	/* Every explanation panel shares one program, text on unit 0 and the logo on unit 1 */
 	exhibit_explanationShader.use();
-	exhibit_explanationShader.setInt("text_texture_1", 0);
+	exhibit_explanationShader.setInt("text_texture", 0);
 	exhibit_explanationShader.setInt("openGL_logo", 1);
 
-	exhibit_explanation2Shader.use();
-	exhibit_explanation2Shader.setInt("text_texture_2", 0);
-	exhibit_explanation2Shader.setInt("openGL_logo", 1);
-
-	exhibit_explanation3Shader.use();
-	exhibit_explanation3Shader.setInt("text_texture_3", 0);
-	exhibit_explanation3Shader.setInt("openGL_logo", 1);
-
-	exhibit_explanation4Shader.use();
-	exhibit_explanation4Shader.setInt("text_texture_4", 0);
-	exhibit_explanation4Shader.setInt("openGL_logo", 1);
-	
-	exhibit_explanation5Shader.use();
-	exhibit_explanation5Shader.setInt("text_texture_5", 0);
-	exhibit_explanation5Shader.setInt("openGL_logo", 1);
-
-	exhibit_explanation6Shader.use();
-	exhibit_explanation6Shader.setInt("text_texture_6", 0);
-	exhibit_explanation6Shader.setInt("openGL_logo", 1); 
-
-	exhibit_explanation7Shader.use();
-	exhibit_explanation7Shader.setInt("text_texture_7", 0);
-	exhibit_explanation7Shader.setInt("openGL_logo", 1); 
-
-	exhibit_explanation8Shader.use();
-	exhibit_explanation8Shader.setInt("text_texture_8", 0);
-	exhibit_explanation8Shader.setInt("openGL_logo", 1); 
-
+	/* Exhibit 5 and 6 share one program */
 	exhibit_squareTextureShader.use();
 	exhibit_squareTextureShader.setInt("exhibit_5_texture_1", 0);
 	exhibit_squareTextureShader.setInt("exhibit_5_texture_2", 1);
 
-	exhibit_cubeTextureShader.use();
-	exhibit_cubeTextureShader.setInt("exhibit_5_texture_1", 0);
-	exhibit_cubeTextureShader.setInt("exhibit_5_texture_2", 1);
+	/* Uniform buffers */
+	/* Projection, view and camera position are shared by every program, written once per frame */
+	UniformBuffer cameraUBO(sizeof(CameraBlock));
+	cameraUBO.bind(CAMERA_UBO_BINDING);
+
+	/* The corridor lights do not move, so they are written once here. Each surface has its own
+		light colours, so every shader reads its own aligned range of the same buffer */
+	GLsizeiptr lightBlockStride = UniformBuffer::alignedSize(sizeof(LightBlock));
+	UniformBuffer lightsUBO(3 * lightBlockStride);
+
+	LightBlock wallLights = makeCorridorLights(glm::vec3(0.1f), glm::vec3(0.1f), glm::vec3(0.1f), glm::vec3(1.0f));
+	LightBlock floorLights = makeCorridorLights(glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(0.1f));
+	LightBlock cellingLights = makeCorridorLights(glm::vec3(0.05f), glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(1.0f));
+
+	lightsUBO.update(0 * lightBlockStride, sizeof(LightBlock), &wallLights);
+	lightsUBO.update(1 * lightBlockStride, sizeof(LightBlock), &floorLights);
+	lightsUBO.update(2 * lightBlockStride, sizeof(LightBlock), &cellingLights);
+
+	lightsUBO.bindRange(WALL_LIGHTS_UBO_BINDING, 0 * lightBlockStride, sizeof(LightBlock));
+	lightsUBO.bindRange(FLOOR_LIGHTS_UBO_BINDING, 1 * lightBlockStride, sizeof(LightBlock));
+	lightsUBO.bindRange(CELLING_LIGHTS_UBO_BINDING, 2 * lightBlockStride, sizeof(LightBlock));
+
+	/* The point lights themselves are shared by the three surfaces and binned into clusters every frame */
+	ClusteredLights clusteredLights(cluster_assignShader);
+	std::vector<PointLightBlock> pointLights = makePointLights(sceneLightPositions.data(), pointLightCount);
+	clusteredLights.setLights(pointLights.data(), pointLightCount);
+	clusteredLights.printStats();
+	/* Which of them touch the view and which touch each drawn segment is worked out on the CPU first */
+	LightCuller lightCuller;
+	lightCuller.setLights(pointLights.data(), pointLightCount);
+
+	/* Its G-buffer is only allocated once the deferred path draws */
+	DeferredRenderer deferredRenderer(gbuffer_corridorShader, deferred_lightingShader);
+
+	/* Resolve every uniform the render loop touches, after this point no names are hashed per frame */
+	TransformUniforms lampUniforms = getTransformUniforms(lampShader);
+
+	/* Exhibit 7 and 8 share a shader and light, only the ambient of the 3rd state differs */
+	LitCubeSettings exhibit_7_lighting;
+	exhibit_7_lighting.uniforms = getLitCubeUniforms(exhibit_cubeMultyLightColourShader);
+	exhibit_7_lighting.lightPosition = glm::vec3(1.2f,  1.0f, -15.0f);
+	exhibit_7_lighting.fixedAmbientStrength = 0.5f;
+
+	LitCubeSettings exhibit_8_lighting = exhibit_7_lighting;
+	exhibit_8_lighting.fixedAmbientStrength = 0.2f;
+
+	/* Exhibit meshes */
+	Mesh exhibit_3_mesh = makeMesh(geometry, exhibit_3_geometry);
+	Mesh exhibit_explenations_mesh = makeMesh(geometry, exhibit_explenations_geometry);
+	Mesh exhibit_6_mesh = makeMesh(geometry, exhibit_6_geometry);
+	Mesh exhibit_7_mesh = makeMesh(geometry, exhibit_7_geometry);
+
+	/* Vertex colours of exhibit 1 and 2 for each press of E and R: red, green, blue */
+	float exhibit_1_vertices[3][18] = 
+		{
+			{
+				// positions         // colors
+				0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,  // bottom right
+				-0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,  // bottom left
+				0.0f,  0.5f, 0.0f,  1.0f, 0.0f, 0.0f   // top 
+			},
+			{
+				0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,
+				-0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,
+				0.0f,  0.5f, 0.0f,  0.0f, 1.0f, 0.0f
+			},
+			{
+				0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f,
+				-0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f,
+				0.0f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f
+			}
+		};
+	float exhibit_2_vertices[3][24] = 
+		{
+			{
+				// positions         // colors
+				0.5f,  0.5f, 0.0f,  1.0f, 0.0f, 0.0f, // top right
+				0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f, // bottom right
+				-0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,// bottom left
+				-0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f // top left 
+			},
+			{
+				0.5f,  0.5f, 0.0f,  0.0f, 1.0f, 0.0f,
+				0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,
+				-0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,
+				-0.5f,  0.5f, 0.0f,   0.0f, 1.0f, 0.0f
+			},
+			{
+				0.5f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f,
+				0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f,
+				-0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f,
+				-0.5f,  0.5f, 0.0f,   0.0f, 0.0f, 1.0f
+			}
+		};
+
+	/* Everything written per frame goes through one persistently mapped ring: the vertices of exhibit 1 and 2,
+		copied only when their colour state changes, the objects and commands of the indirect batch, the light lists
+		and the profiler overlay */
+	StreamRing streamRing;
+	DynamicVertices exhibit_1_dynamic = makeDynamicVertices(streamRing, sizeof(exhibit_1_vertices[0]), 6 * sizeof(float));
+	DynamicVertices exhibit_2_dynamic = makeDynamicVertices(streamRing, sizeof(exhibit_2_vertices[0]), 6 * sizeof(float));
+	for (int state = 0; state < 3; state++)
+		{
+			exhibit_1_dynamic.states[state] = exhibit_1_vertices[state];
+			exhibit_2_dynamic.states[state] = exhibit_2_vertices[state];
+		}
+	streamRing.create(IndirectRenderer::frameBytes() + LightCuller::frameBytes(corridorSegments, pointLightCount) + InstanceBuffer::frameBytes(corridorSegments)
+		+ ProfilerOverlay::frameBytes());
+	unsigned int streamColourVAO = streamRing.makeVertexArray(colourAttributes, 2, geometry.indexBuffer(colourFormat));
+	Mesh exhibit_1_mesh = makeStreamedMesh(streamColourVAO, exhibit_1_geometry);
+	Mesh exhibit_2_mesh = makeStreamedMesh(streamColourVAO, exhibit_2_geometry);
+
+	/* GPU time of every pass and exhibit, drawn over the scene while it runs */
+	GpuProfiler gpuProfiler;
+	if (profileCSV != NULL)
+		gpuProfiler.openCSV(profileCSV);
+	ProfilerOverlay profilerOverlay(profiler_overlayShader, streamRing);
+
+	/* The same meshes once more in the merged buffers of the indirect path, converted to one vertex layout.
+		Exhibit 1 and 2 get a copy per colour state so the indirect path never rewrites vertices. Exhibit 5 and 6
+		have none, their textures can not be layers of the panels' array, and always go through the render queue */
+	IndirectRenderer indirectRenderer(geometry, streamRing);
+	indirectRenderer.setProgram(exhibit_indirectShader);
+	/* Walls, floor and celling are the occluders, the batch is tested against them on the GPU */
+	OcclusionCuller occlusionCuller(depth_prepassShader, hiz_downsampleShader, occlusion_cullShader);
+	IndirectVertexFormat indirectColourFormat = { 6, -1, -1, 3 };
+	IndirectVertexFormat indirectTextureFormat = { 5, -1, 3, -1 };
+	IndirectVertexFormat indirectNormalFormat = { 6, 3, -1, -1 };
+	int exhibit_1_indirect[3];
+	int exhibit_2_indirect[3];
+	for (int state = 0; state < 3; state++)
+		{
+			exhibit_1_indirect[state] = indirectRenderer.addMesh(exhibit_1_vertices[state], 3, indirectColourFormat);
+			exhibit_2_indirect[state] = indirectRenderer.addMesh(exhibit_2_vertices[state], 4, indirectColourFormat, square_vertices_indices, 6);
+		}
+	int exhibit_3_indirect = indirectRenderer.addMesh(square_triangle_vertices_colour, 3, indirectColourFormat);
+	int exhibit_explenations_indirect = indirectRenderer.addMesh(square_vertices_texture, 4, indirectTextureFormat, square_vertices_indices, 6);
+	int exhibit_7_indirect = indirectRenderer.addMesh(normals_cube_vertices, 36, indirectNormalFormat);
+	geometry.printStats();
+
+	/* The exhibit table, the render queue sorts it by state every frame. Adding an exhibit only takes a new record */
+	std::vector<Exhibit> exhibits;
+	Exhibit exhibit;
+
+	/* Exhibit 1 triangle, E changes its colour */
+	exhibit = makeExhibit("exhibit 1", exhibit_1_mesh, exhibit_triangleShader, exhibitsPositions[0], 90.0f, 1.25f);
+	exhibit.interaction = &interact_1_exhibit;
+	exhibit.vertices = &exhibit_1_dynamic;
+	exhibit.indirectMaterial = INDIRECT_VERTEX_COLOUR;
+	for (int state = 0; state < 3; state++)
+		exhibit.indirectMesh[state] = exhibit_1_indirect[state];
+	exhibits.push_back(exhibit);
+
+	/* Exhibit 2 square, R changes its colour and Q toggles wireframe */
+	exhibit = makeExhibit("exhibit 2", exhibit_2_mesh, exhibit_squareShader, exhibitsPositions[1], 90.0f, 1.25f);
+	exhibit.interaction = &interact_2_exhibit;
+	exhibit.wireframe = &interact_2b_exhibit;
+	exhibit.vertices = &exhibit_2_dynamic;
+	exhibit.indirectMaterial = INDIRECT_VERTEX_COLOUR;
+	for (int state = 0; state < 3; state++)
+		exhibit.indirectMesh[state] = exhibit_2_indirect[state];
+	exhibits.push_back(exhibit);
+
+	/* Exhibit 3 triangle with colour interpolation */
+	exhibit = makeExhibit("exhibit 3", exhibit_3_mesh, exhibit_triangleColourShader, exhibitsPositions[4], 90.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_3_indirect, INDIRECT_VERTEX_COLOUR);
+	exhibits.push_back(exhibit);
+
+	/* Exhibit 4 the same triangle rotating */
+	exhibit = makeExhibit("exhibit 4", exhibit_3_mesh, exhibit_triangleColourRotationShader, exhibitsPositions[5], 0.0f, 1.25f);
+	exhibit.spin = 90.0f;
+	setExhibitIndirect(exhibit, exhibit_3_indirect, INDIRECT_VERTEX_COLOUR);
+	exhibits.push_back(exhibit);
+
+	/* Exhibit 5 square with 2 textures, T swaps them */
+	exhibit = makeExhibit("exhibit 5", exhibit_explenations_mesh, exhibit_squareTextureShader, exhibitsPositions[8], 90.0f, 1.25f);
+	exhibit.interaction = &interact_3_exhibit;
+	setExhibitTextures(exhibit, 0, exhibit_5_texture_1, exhibit_5_texture_2);
+	setExhibitTextures(exhibit, 1, exhibit_5_texture_2, exhibit_5_texture_1);
+	exhibits.push_back(exhibit);
+
+	/* Exhibit 6 rotating cube with the same textures */
+	exhibit = makeExhibit("exhibit 6", exhibit_6_mesh, exhibit_cubeTextureShader, exhibitsPositions[9], 0.0f, 0.75f);
+	exhibit.spin = 90.0f;
+	exhibit.interaction = &interact_3_exhibit;
+	setExhibitTextures(exhibit, 0, exhibit_5_texture_1, exhibit_5_texture_2);
+	setExhibitTextures(exhibit, 1, exhibit_5_texture_2, exhibit_5_texture_1);
+	exhibits.push_back(exhibit);
+
+	/* Exhibit 7 cube with basic lighting, Y changes the light and material */
+	exhibit = makeExhibit("exhibit 7", exhibit_7_mesh, exhibit_cubeMultyLightColourShader, exhibitsPositions[12], 0.0f, 0.75f);
+	exhibit.interaction = &interact_4_exhibit;
+	exhibit.prepare = setLitCubeUniforms;
+	exhibit.prepareData = &exhibit_7_lighting;
+	setExhibitIndirect(exhibit, exhibit_7_indirect, INDIRECT_LIT);
+	exhibit.prepareIndirect = setLitCubeIndirect;
+	exhibits.push_back(exhibit);
+
+	/* The light source of exhibit 7 and 8 */
+	exhibit = makeExhibit("exhibit 7 lamp", exhibit_7_mesh, exhibit_7_lamp, exhibit_7_lighting.lightPosition, 0.0f, 0.2f);
+	setExhibitIndirect(exhibit, exhibit_7_indirect, INDIRECT_WHITE);
+	exhibits.push_back(exhibit);
+
+	/* Exhibit 8 the same cube rotating */
+	exhibit = makeExhibit("exhibit 8", exhibit_7_mesh, exhibit_cubeMultyLightColourShader, exhibitsPositions[13], 0.0f, 0.75f);
+	exhibit.spin = 90.0f;
+	exhibit.interaction = &interact_4_exhibit;
+	exhibit.prepare = setLitCubeUniforms;
+	exhibit.prepareData = &exhibit_8_lighting;
+	setExhibitIndirect(exhibit, exhibit_7_indirect, INDIRECT_LIT);
+	exhibit.prepareIndirect = setLitCubeIndirect;
+	exhibits.push_back(exhibit);
+
+	/* Explanations, the text texture follows the interaction state of their exhibit */
+	exhibit = makeExhibit("explanation 1", exhibit_explenations_mesh, exhibit_explanationShader, exhibitsPositions[3], 90.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	exhibit.interaction = &interact_1_exhibit;
+	setExhibitTextures(exhibit, 0, text_texture_1_red, openGL_logo);
+	setExhibitTextures(exhibit, 1, text_texture_1_green, openGL_logo);
+	setExhibitTextures(exhibit, 2, text_texture_1_blue, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	exhibit = makeExhibit("explanation 2", exhibit_explenations_mesh, exhibit_explanation2Shader, exhibitsPositions[2], 270.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	exhibit.interaction = &interact_2_exhibit;
+	setExhibitTextures(exhibit, 0, text_texture_2_red, openGL_logo);
+	setExhibitTextures(exhibit, 1, text_texture_2_green, openGL_logo);
+	setExhibitTextures(exhibit, 2, text_texture_2_blue, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	exhibit = makeExhibit("explanation 3", exhibit_explenations_mesh, exhibit_explanation3Shader, exhibitsPositions[7], 90.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	setExhibitTextures(exhibit, 0, text_texture_3, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	exhibit = makeExhibit("explanation 4", exhibit_explenations_mesh, exhibit_explanation4Shader, exhibitsPositions[6], 270.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	setExhibitTextures(exhibit, 0, text_texture_4, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	exhibit = makeExhibit("explanation 5", exhibit_explenations_mesh, exhibit_explanation5Shader, exhibitsPositions[11], 90.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	exhibit.interaction = &interact_3_exhibit;
+	setExhibitTextures(exhibit, 0, text_texture_5, openGL_logo);
+	setExhibitTextures(exhibit, 1, text_texture_5_swap, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	exhibit = makeExhibit("explanation 6", exhibit_explenations_mesh, exhibit_explanation6Shader, exhibitsPositions[10], 270.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	exhibit.interaction = &interact_3_exhibit;
+	setExhibitTextures(exhibit, 0, text_texture_6, openGL_logo);
+	setExhibitTextures(exhibit, 1, text_texture_6_swap, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	exhibit = makeExhibit("explanation 7", exhibit_explenations_mesh, exhibit_explanation7Shader, exhibitsPositions[15], 90.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	setExhibitTextures(exhibit, 0, text_texture_7, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	exhibit = makeExhibit("explanation 8", exhibit_explenations_mesh, exhibit_explanation8Shader, exhibitsPositions[14], 270.0f, 1.25f);
+	setExhibitIndirect(exhibit, exhibit_explenations_indirect, INDIRECT_TEXTURED);
+	exhibit.interaction = &interact_4_exhibit;
+	setExhibitTextures(exhibit, 0, text_texture_8, openGL_logo);
+	setExhibitTextures(exhibit, 1, text_texture_8_case1, openGL_logo);
+	setExhibitTextures(exhibit, 2, text_texture_8_case2, openGL_logo);
+	exhibits.push_back(exhibit);
+
+	/* Every text panel is the same size and format, so the batch takes them as layers of one array texture
+		with the logo mixed over them. The array is made once they are all loaded */
+	for (size_t i = 0; i < exhibits.size(); i++)
+		if (exhibits[i].indirectMaterial == INDIRECT_TEXTURED)
+			for (int state = 0; state < EXHIBIT_MAX_STATES; state++)
+				if (exhibits[i].textures[state][0] != 0)
+					indirectRenderer.addLayer(exhibits[i].textures[state][0]);
+	indirectRenderer.setOverlay(openGL_logo);
+
+	/* Bounding spheres tested against the view frustum every frame, nothing outside it is submitted.
+		Exhibits only turn about their origin, so their spheres never move */
+	SphereSet exhibitBounds;
+	for (size_t i = 0; i < exhibits.size(); i++)
+		exhibitBounds.add(exhibits[i].position, exhibitBoundingRadius(exhibits[i]));
+	SphereSet segmentBounds;
+	float segmentRadius = glm::max(wall_geometry.radius, glm::max(floor_geometry.radius, celling_geometry.radius));
+	for (unsigned int i = 0; i < corridorSegments; i++)
+		{
+			glm::vec3 size = scene.cells[i].max - scene.cells[i].min;
+			segmentBounds.add(glm::vec3(segmentModels[i][3]), segmentRadius * glm::max(size.x, glm::max(size.y, size.z)));
+		}
+	SphereSet lampBounds;
+	for (unsigned int i = 0; i < pointLightCount; i++)
+		lampBounds.add(sceneLightPositions[i], celling_geometry.radius * 0.2f);
+
+	/* On top of the frustum, only what is in a cell seen through a chain of portals is drawn.
+		Segment i is cell i, exhibits and lamps belong to every cell their sphere reaches into */
+	PortalVisibility portals;
+	portals.build(scene);
+	std::vector<int> exhibitCells(exhibits.size());
+	for (size_t i = 0; i < exhibits.size(); i++)
+		exhibitCells[i] = portals.addObject(exhibits[i].position, exhibitBoundingRadius(exhibits[i]));
+	std::vector<int> lampCells(pointLightCount);
+	for (unsigned int i = 0; i < pointLightCount; i++)
+		lampCells[i] = portals.addObject(sceneLightPositions[i], celling_geometry.radius * 0.2f);
+	/* Exhibit draws go through the queue, the cache drops the binds that would not change anything */
+	RenderQueue renderQueue;
+	GLStateCache stateCache;
+
+	/* gl_DrawID needs GL 4.6, without it the exhibits stay on the immediate path */
+	if (indirect_draw && !IndirectRenderer::supported())
+		{
+			std::cout << "Multi draw indirect needs OpenGL 4.6, drawing the exhibits one by one" << std::endl;
+			indirect_draw = 0;
+		}
+	if (!OcclusionCuller::supported())
+		occlusion_culling = 0;
+	/* Exhibit submission time summed since the last report, and the mode it was measured in */
+	double exhibitMilliseconds = 0.0;
+	unsigned int exhibitFrames = 0;
+	int exhibitMode = indirect_draw;
+	/* Draw calls of the last frame, and exhibits in its multi draw */
+	size_t exhibitDraws = 0;
+	size_t exhibitBatched = 0;
 
 	/* Uncomment this call to draw in wireframe polygons. */
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	BenchmarkStats benchmarkStats;
 	/* render loop */
-	while (!glfwWindowShouldClose(window))
+	unsigned int frame = 0;
+	while (frameLimit > 0 ? frame < frameLimit : !glfwWindowShouldClose(window))
 		{
+			CPU_PROFILE_FRAME(frame);
+			CPU_PROFILE_SCOPE("frame");
 			/* Per-frame time logic */
-			/* Calculate the new deltaTime value */
-			float currentFrame = glfwGetTime();
+			/* Calculate the new deltaTime value, a benchmark steps it by a fixed amount */
+			float currentFrame = benchmark ? frame * BENCHMARK_DELTA_TIME : frameClock();
 			deltaTime = currentFrame - lastFrame;
 			lastFrame = currentFrame;
-			/* Input */
-			processInput(window);
+			/* Input, a benchmark follows its path instead and a headless run has none */
+			if (benchmark)
+				{
+					unsigned int measured = frame > warmupFrames ? frame - warmupFrames : 0;
+					benchmarkPath.apply(camera, frameLimit - warmupFrames > 1 ? (float)measured / (frameLimit - warmupFrames - 1) : 0.0f);
+					if (frame >= warmupFrames)
+						benchmarkStats.beginFrame();
+				}
+			else if (!headless)
+				processInput(window);
+
+			/* Upload the textures decoded since the last frame, the panels go into the batch's array once they are all in */
+			if (textureLoader.update() && indirect_draw)
+				indirectRenderer.buildLayers();
+			textureCache.reportWhenLoaded();
+
+			/* Wait, if need be, until the GPU is done with the ring region this frame writes */
+			streamRing.beginFrame();
+			gpuProfiler.setEnabled(gpu_profiling != 0);
+			gpuProfiler.beginFrame();
+			gpuProfiler.begin("frame");
 
 			/* Render here */
 			/* State setting function */
@@ -850,1396 +1160,302 @@ int main(int argc, char const *argv[])
 			/* Clear the screens colour and depth buffer */
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); 
 
-			/* Exhibit 1 triangle matrix set */
-
-			/* Use the shader in order to set the Vertext Array Object and other attributes */
-			exhibit_triangleShader.use();
-			/* Bind the VAO to the shader */
-      glBindVertexArray(exhibit_1_VAO);
+			/* Camera data for every program, uploaded once instead of once per shader */
+			CameraBlock cameraBlock;
+			const float nearPlane = 0.1f;
+			const float farPlane = 100.0f;
+			cameraBlock.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, nearPlane, farPlane);
+			cameraBlock.view = camera.GetViewMatrix();
+			cameraBlock.viewPos = camera.Position;
+			cameraUBO.update(0, sizeof(CameraBlock), &cameraBlock);
+
+			/* Cull everything against the planes of this frame's camera before any of it is submitted */
+			Frustum frustum;
+			frustum.extract(cameraBlock.projection * cameraBlock.view);
+			exhibitBounds.cull(frustum);
+			lampBounds.cull(frustum);
+			segmentBounds.cull(frustum);
+			portals.update(camera.Position, frustum);
+			size_t exhibitsDrawn = 0;
+			for (size_t i = 0; i < exhibits.size(); i++)
+				{
+					exhibitBounds.visible[i] &= portals.objectVisible(exhibitCells[i]);
+					exhibitsDrawn += exhibitBounds.visible[i];
+				}
+			size_t lampsDrawn = 0;
+			for (unsigned int i = 0; i < pointLightCount; i++)
+				{
+					lampBounds.visible[i] &= portals.objectVisible(lampCells[i]);
+					lampsDrawn += lampBounds.visible[i];
+				}
+			/* The corridor stays one instanced call per surface over only the segments in view and reached through
+				portals, their indices go to the ring and every instance looks its matrix up through them */
+			drawnSegments.clear();
+			for (unsigned int i = 0; i < corridorSegments; i++)
+				if (segmentBounds.visible[i] && portals.visible[i])
+					drawnSegments.push_back(i);
+			unsigned int segmentsDrawn = (unsigned int)drawnSegments.size();
+			corridorInstances.setDrawn(streamRing, drawnSegments);
+
+			/* Only the point lights reaching into the view are binned into clusters, and every drawn segment gets
+				the list of those reaching it. Both go out before anything lit is drawn */
+			lightCuller.cull(frustum);
+			lightCuller.buildObjectLists(segmentBounds, drawnSegments);
+			lightCuller.upload(streamRing);
+			clusteredLights.update(cameraBlock.projection, nearPlane, farPlane, SCR_WIDTH, SCR_HEIGHT, lightCuller.visibleCount());
+			gpuProfiler.begin("cluster assign");
+			clusteredLights.assign();
+			gpuProfiler.end();
+
+			/* On the deferred path the corridor goes into the G-buffer and is lit once per pixel before anything else
+				is drawn, the forward draws further down then skip it */
+			unsigned int forwardSegments = segmentsDrawn;
+			if (deferred_shading)
+				{
+					forwardSegments = 0;
+					gpuProfiler.begin("G-buffer");
+					deferredRenderer.resize(SCR_WIDTH, SCR_HEIGHT);
+					deferredRenderer.beginGeometry();
+					glBindVertexArray(corridor_VAO);
+					if (segmentsDrawn > 0)
+						{
+							deferredRenderer.setSurface(GBUFFER_WALL);
+							glActiveTexture(GL_TEXTURE0);
+							glBindTexture(GL_TEXTURE_2D, diffuseMap_wall);
+							glActiveTexture(GL_TEXTURE1);
+							glBindTexture(GL_TEXTURE_2D, specularMap_wall);
+							glDrawArraysInstanced(GL_TRIANGLES, wall_geometry.baseVertex, wall_geometry.vertexCount, segmentsDrawn);
 
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_triangleShader.setMat4("projection", projection);
+							deferredRenderer.setSurface(GBUFFER_FLOOR);
+							glActiveTexture(GL_TEXTURE0);
+							glBindTexture(GL_TEXTURE_2D, diffuseMap_floor);
+							glActiveTexture(GL_TEXTURE1);
+							glBindTexture(GL_TEXTURE_2D, specularMap_floor);
+							glDrawArraysInstanced(GL_TRIANGLES, floor_geometry.baseVertex, floor_geometry.vertexCount, segmentsDrawn);
 
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			glm::mat4 view = camera.GetViewMatrix();
-			exhibit_triangleShader.setMat4("view", view);
+							deferredRenderer.setSurface(GBUFFER_CELLING);
+							glActiveTexture(GL_TEXTURE0);
+							glBindTexture(GL_TEXTURE_2D, diffuseMap_celling);
+							glActiveTexture(GL_TEXTURE1);
+							glBindTexture(GL_TEXTURE_2D, specularMap_celling);
+							glDrawArraysInstanced(GL_TRIANGLES, celling_geometry.baseVertex, celling_geometry.vertexCount, segmentsDrawn);
+						}
+					deferredRenderer.endGeometry();
+					gpuProfiler.end();
+					gpuProfiler.begin("deferred lighting");
+					deferredRenderer.light(cameraBlock.projection * cameraBlock.view);
+					gpuProfiler.end();
+				}
 
-			/* World transformation */
-			glm::mat4 exhibit_a_model = glm::mat4(1.0f);
-			exhibit_triangleShader.setMat4("model", exhibit_a_model);
+			/* CPU cost of the exhibit submission is averaged per mode, so pressing M gives a direct comparison */
+			if (indirect_draw != exhibitMode)
+				{
+					reportExhibitTiming(exhibitMode, exhibitMilliseconds, exhibitFrames, exhibitDraws, exhibitBatched);
+					exhibitMilliseconds = 0.0;
+					exhibitFrames = 0;
+					exhibitMode = indirect_draw;
+				}
 
-			/* Reset the model matrix in order to perform translation and rotation operations */
-			exhibit_a_model = glm::mat4(1.0f);
+			/* Exhibits and their explanations. On the indirect path every exhibit the batch can express goes into one
+				multi draw, the rest go through the queue, sorted by program, VAO, textures and then front to back */
+			std::chrono::steady_clock::time_point exhibitStart = std::chrono::steady_clock::now();
+			double exhibitTime = benchmark ? currentFrame : frameClock();
+			renderQueue.clear();
+			indirectRenderer.clear();
+			indirectRenderer.setOcclusionCuller(NULL);
+			/* The corridor surfaces go into the occluder depth first, depth only and with the same segment run
+				as the lit draws below. The render queue drops the cache's shadow state afterwards */
+			if (indirect_draw && occlusion_culling && segmentsDrawn > 0)
+				{
+					gpuProfiler.begin("occluders and Hi-Z");
+					occlusionCuller.resize(SCR_WIDTH, SCR_HEIGHT);
+					occlusionCuller.beginOccluders();
+					glBindVertexArray(corridor_VAO);
+					glDrawArraysInstanced(GL_TRIANGLES, wall_geometry.baseVertex, wall_geometry.vertexCount, segmentsDrawn);
+					glDrawArraysInstanced(GL_TRIANGLES, floor_geometry.baseVertex, floor_geometry.vertexCount, segmentsDrawn);
+					glDrawArraysInstanced(GL_TRIANGLES, celling_geometry.baseVertex, celling_geometry.vertexCount, segmentsDrawn);
+					occlusionCuller.endOccluders();
+					gpuProfiler.end();
+					indirectRenderer.setOcclusionCuller(&occlusionCuller);
+				}
+			for (size_t i = 0; i < exhibits.size(); i++)
+				{
+					if (!exhibitBounds.visible[i])
+						continue;
+					if (!indirect_draw || !indirectRenderer.push(exhibits[i], exhibitTime))
+						renderQueue.push(exhibits[i], exhibitTime, camera.Position);
+				}
+			renderQueue.sort();
+			gpuProfiler.begin("exhibits");
+			renderQueue.submit(stateCache, exhibitTime, &gpuProfiler);
+			gpuProfiler.begin("indirect batch");
+			indirectRenderer.submit(stateCache);
+			gpuProfiler.end();
+			gpuProfiler.end();
+
+			std::chrono::duration<double, std::milli> exhibitElapsed = std::chrono::steady_clock::now() - exhibitStart;
+			exhibitMilliseconds += exhibitElapsed.count();
+			exhibitFrames++;
+			exhibitDraws = renderQueue.packets.size();
+			exhibitBatched = indirectRenderer.size();
+			/* Not in a benchmark, the print would land inside the measured frame */
+			if (exhibitFrames == 120 && !benchmark)
+				{
+					reportExhibitTiming(exhibitMode, exhibitMilliseconds, exhibitFrames, exhibitDraws, exhibitBatched);
+					exhibitMilliseconds = 0.0;
+					exhibitFrames = 0;
+				}
 
-			/* Prepair the translation matrix to translate "move" the object in its place in the hallway */
-			exhibit_a_model = glm::translate(exhibit_a_model, exhibitsPositions[0]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			float angle = (float) glm::radians(90.0f);
-			/* Prapair a rotation matrix to rotate the exhibit to face the wall */
-			exhibit_a_model = glm::rotate(exhibit_a_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			/* be sure to activate shader when setting uniforms/drawing objects */
+			wall_Shader.use();
+			
+			/* bind diffuse map */
+      glActiveTexture(GL_TEXTURE0);
+    	glBindTexture(GL_TEXTURE_2D, diffuseMap_wall);
+			/* bind specular map */
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, specularMap_wall);	
 
-			/* Scale the exhibit */
-			exhibit_a_model = glm::scale(exhibit_a_model, glm::vec3(1.25f)); 
-			/* Pass the matrix with all the build in operations to the shader */
-			exhibit_triangleShader.setMat4("model", exhibit_a_model);
+			/* walls, floor, celling and lamps all live in the corridor VAO, so it is bound once */
+			glBindVertexArray(corridor_VAO);
 
-			/* Change the exhibits colour based on button press */
-			switch (interact_1_exhibit)
+			/* every drawn segment in one call, the model matrices come from corridorInstances through drawnSegments */
+			if (forwardSegments > 0)
 				{
-					case 0:
-						{
-							/* Exhibits vertices */
-							float square_triangle_vertices[] = 
-								{
-									// positions         // colors
-									0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,  // bottom right
-									-0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,  // bottom left
-									0.0f,  0.5f, 0.0f,  1.0f, 0.0f, 0.0f   // top 
-								};
-
-							glBindBuffer(GL_ARRAY_BUFFER, exhibit_1_VBO);
-							glBufferData(GL_ARRAY_BUFFER, sizeof(square_triangle_vertices), square_triangle_vertices, GL_DYNAMIC_DRAW);	
-						}
-					break;
+					gpuProfiler.begin("walls");
+					glDrawArraysInstanced(GL_TRIANGLES, wall_geometry.baseVertex, wall_geometry.vertexCount, forwardSegments);
+					gpuProfiler.end();
+				}
 
-					case 1:
-						{
-							/* Exhibits vertices */
-							float square_triangle_vertices[] = 
-								{
-									// positions         // colors
-									0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,  // bottom right
-									-0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,  // bottom left
-									0.0f,  0.5f, 0.0f,  0.0f, 1.0f, 0.0f   // top 
-								};
-
-							glBindBuffer(GL_ARRAY_BUFFER, exhibit_1_VBO);
-							glBufferData(GL_ARRAY_BUFFER, sizeof(square_triangle_vertices), square_triangle_vertices, GL_DYNAMIC_DRAW);	
-						}
-					break;
+			/* activate shader */
+			floor_Shader.use();
 
-					case 2:
-						{
-							/* Exhibits vertices */
-							float square_triangle_vertices[] = 
-								{
-									// positions         // colors
-									0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f,  // bottom right
-									-0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f,  // bottom left
-									0.0f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f   // top 
-								};
-
-							glBindBuffer(GL_ARRAY_BUFFER, exhibit_1_VBO);
-							glBufferData(GL_ARRAY_BUFFER, sizeof(square_triangle_vertices), square_triangle_vertices, GL_DYNAMIC_DRAW);	
-						}
-					break;	
+      glActiveTexture(GL_TEXTURE0);
+    	glBindTexture(GL_TEXTURE_2D, diffuseMap_floor);
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, specularMap_floor);
 
-					default:
-						break;
-			}
+			if (forwardSegments > 0)
+				{
+					gpuProfiler.begin("floor");
+					glDrawArraysInstanced(GL_TRIANGLES, floor_geometry.baseVertex, floor_geometry.vertexCount, forwardSegments);
+					gpuProfiler.end();
+				}
 
-			glDrawArrays(GL_TRIANGLES, 0, 3);		
+			/* activate shader */
+			celling_Shader.use();
 
-			/* Exhibit 2 square matrix set */
+      glActiveTexture(GL_TEXTURE0);
+    	glBindTexture(GL_TEXTURE_2D, diffuseMap_celling);
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, specularMap_celling);
 
-			exhibit_squareShader.use();
+			if (forwardSegments > 0)
+				{
+					gpuProfiler.begin("celling");
+					glDrawArraysInstanced(GL_TRIANGLES, celling_geometry.baseVertex, celling_geometry.vertexCount, forwardSegments);
+					gpuProfiler.end();
+				}
 
-      glBindVertexArray(exhibit_2_VAO);
+			/* also draw the lamp objects */
+			gpuProfiler.begin("lamps");
+			lampShader.use();
 
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_squareShader.setMat4("projection", projection);
+			/* many smaller cubes, a matrix built and uploaded for each */
+			{
+				CPU_PROFILE_SCOPE("lamp matrices");
+				for (unsigned int i = 0; i < pointLightCount; i++)
+					{
+						if (!lampBounds.visible[i])
+							continue;
+						glm::mat4 lamp_model = glm::mat4(1.0f);
+						lamp_model = glm::translate(lamp_model, sceneLightPositions[i]);
+						/* Make it a smaller cube */
+						lamp_model = glm::scale(lamp_model, glm::vec3(0.2f)); 
+						lampShader.setMat4(lampUniforms.model, lamp_model);
+						glDrawArrays(GL_TRIANGLES, celling_geometry.baseVertex, celling_geometry.vertexCount);
+					}
+			}
+			gpuProfiler.end();
 
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_squareShader.setMat4("view", view);
+			/* The profile of the frames so far goes over everything else, outside of the frame scope */
+			gpuProfiler.end();
+			if (gpuProfiler.isEnabled())
+				profilerOverlay.draw(gpuProfiler, SCR_WIDTH, SCR_HEIGHT);
+			gpuProfiler.endFrame();
 
-			/* World transformation */
-			glm::mat4 exhibit_b_model = glm::mat4(1.0f);
-			exhibit_squareShader.setMat4("model", exhibit_b_model);
+			/* The frame's draws are all issued, fence its ring region */
+			streamRing.endFrame();
 
-			exhibit_b_model = glm::mat4(1.0f);
+			/* The counters of this frame, on request only so nothing is printed inside a measured frame */
+			if (print_stats || (headless && !benchmark && frame + 1 == frameLimit))
+				{
+					size_t frameDrawn = exhibitsDrawn + segmentsDrawn + lampsDrawn;
+					size_t total = exhibitBounds.size() + segmentBounds.size() + lampBounds.size();
+					const StateChangeStats &stats = stateCache.stats;
+					std::cout << "Frame " << frame << " statistics" << std::endl;
+					std::cout << "  Frustum culling: " << frameDrawn << " drawn, " << total - frameDrawn << " culled (exhibits "
+						<< exhibitsDrawn << "/" << exhibitBounds.size() << ", segments " << segmentsDrawn << "/" << segmentBounds.size()
+						<< ", lamps " << lampsDrawn << "/" << lampBounds.size() << "), cells " << portals.visibleCells() << "/" << portals.size()
+						<< " seen from cell " << portals.currentCell() << " through " << portals.portalsFollowed() << " portals"
+						<< (portals.overBudget() ? ", out of portal steps so the rest was flooded" : "") << std::endl;
+					std::cout << "  Light culling: " << lightCuller.visibleCount() << "/" << clusteredLights.size() << " point lights in view, "
+						<< lightCuller.averageObjectLights() << " per drawn segment" << std::endl;
+					std::cout << "  Occlusion culling: " << occlusionCuller.culledObjects() << " of " << occlusionCuller.culledOf()
+						<< " batched exhibits hidden behind the corridor" << std::endl;
+					std::cout << "  State changes: " << stats.issued() << " issued, " << stats.avoided() << " avoided"
+						<< " (programs " << stats.programsAvoided << ", VAOs " << stats.vertexArraysAvoided
+						<< ", textures " << stats.texturesAvoided << ", other " << stats.otherAvoided << ")" << std::endl;
+					/* In steady state every uniform goes through a handle, so this should be zero */
+					std::cout << "  Uniform name lookups: " << Shader::frameLookups() << std::endl;
+					std::cout << "  Stream ring: " << streamRing.stalledFrames() << " frames waited for the GPU so far, peak "
+						<< streamRing.peakBytes() << " bytes per region" << std::endl;
+					print_stats = 0;
+				}
+			Shader::resetFrameLookups();
+			stateCache.resetStats();
 
-			exhibit_b_model = glm::translate(exhibit_b_model, exhibitsPositions[1]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f);
-			exhibit_b_model = glm::rotate(exhibit_b_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			/* glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.) */
+			if (!headless)
+				{
+					{
+						CPU_PROFILE_SCOPE("glfwSwapBuffers");
+						glfwSwapBuffers(window);
+					}
+					CPU_PROFILE_SCOPE("glfwPollEvents");
+					glfwPollEvents();
+				}
+			else if (frame + 1 == frameLimit && outputPath != NULL && headlessContext.writePPM(outputPath))
+				std::cout << "Headless: frame " << frame << " written to " << outputPath << std::endl;
+			if (benchmark && frame >= warmupFrames)
+				benchmarkStats.endFrame();
+			frame++;
+		}
 
-			/* Scale the exhibit */
-			exhibit_b_model = glm::scale(exhibit_b_model, glm::vec3(1.25f)); 
-			exhibit_squareShader.setMat4("model", exhibit_b_model);
+	CPU_PROFILE_FINISH();
+	GLDebugOutput::printSummary();
+	if (benchmark)
+		{
+			benchmarkStats.finish();
+			benchmarkStats.print();
+			/* The path and the renderer name are not ours, they are escaped and may be any length */
+			std::string settings = "\"path\": " + BenchmarkStats::jsonString(benchmarkPathName)
+				+ ", \"renderer\": " + BenchmarkStats::jsonString((const char *)glGetString(GL_RENDERER))
+				+ ", \"width\": " + std::to_string(SCR_WIDTH) + ", \"height\": " + std::to_string(SCR_HEIGHT)
+				+ ", \"headless\": " + std::to_string(headless) + ", \"indirect\": " + std::to_string(indirect_draw)
+				+ ", \"deferred\": " + std::to_string(deferred_shading) + ", \"segments\": " + std::to_string(corridorSegments)
+				+ ", \"warmup\": " + std::to_string(warmupFrames) + ", \"delta_time\": " + std::to_string(BENCHMARK_DELTA_TIME);
+			benchmarkStats.writeJSON(benchmarkOutput, settings);
+		}
 
-			/* Change the polygon draw mode from normal rasterasation (GL_FILL) to wireframe mode (GL_LINE) */
-			switch (interact_2b_exhibit)
-				{
-					case 0:
-						{
-							glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);				
-						}
-					break;
-
-					case 1:
-						{
-							glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);				
-						}
-					break;
-			
-					default:
-					break;
-			}
-
-			/* Change the exhibits colour based on button press */
-			/* As well as the colour of the source code in the description by changing the description texture */
-			switch (interact_2_exhibit)
-				{
-					case 0:
-						{
-							float square_vertices[] = 
-								{
-									// positions         // colors
-									0.5f,  0.5f, 0.0f,  1.0f, 0.0f, 0.0f, // top right
-									0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f, // bottom right
-									-0.5f, -0.5f, 0.0f,  1.0f, 0.0f, 0.0f,// bottom left
-									-0.5f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f // top left 
-								};
-							glBindBuffer(GL_ARRAY_BUFFER, exhibit_2_VBO);
-							glBufferData(GL_ARRAY_BUFFER, sizeof(square_vertices), square_vertices, GL_DYNAMIC_DRAW);
-						}
-					break;
-
-					case 1:
-						{
-							float square_vertices[] = 
-								{
-									// positions         // colors
-									0.5f,  0.5f, 0.0f,  0.0f, 1.0f, 0.0f, // top right
-									0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f, // bottom right
-									-0.5f, -0.5f, 0.0f,  0.0f, 1.0f, 0.0f,// bottom left
-									-0.5f,  0.5f, 0.0f,   0.0f, 1.0f, 0.0f // top left 
-								};
-							glBindBuffer(GL_ARRAY_BUFFER, exhibit_2_VBO);
-							glBufferData(GL_ARRAY_BUFFER, sizeof(square_vertices), square_vertices, GL_DYNAMIC_DRAW);
-						}
-					break;
-
-					case 2:
-						{
-							float square_vertices[] = 
-								{
-									// positions         // colors
-									0.5f,  0.5f, 0.0f,  0.0f, 0.0f, 1.0f, // top right
-									0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f, // bottom right
-									-0.5f, -0.5f, 0.0f,  0.0f, 0.0f, 1.0f,// bottom left
-									-0.5f,  0.5f, 0.0f,   0.0f, 0.0f, 1.0f // top left 
-								};
-							glBindBuffer(GL_ARRAY_BUFFER, exhibit_2_VBO);
-							glBufferData(GL_ARRAY_BUFFER, sizeof(square_vertices), square_vertices, GL_DYNAMIC_DRAW);
-						}
-					break;	
-
-					default:
-						break;
-			}
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-			/* Exhibit 3 triangle matrix set */
-
-			exhibit_triangleColourShader.use();
-      glBindVertexArray(exhibit_3_VAO);
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_triangleColourShader.setMat4("projection", projection);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_triangleColourShader.setMat4("view", view);
-
-			/* World transformation */
-			glm::mat4 exhibit_c_model = glm::mat4(1.0f);
-			exhibit_triangleColourShader.setMat4("model", exhibit_c_model);
-
-			exhibit_c_model = glm::mat4(1.0f);
-
-			exhibit_c_model = glm::translate(exhibit_c_model, exhibitsPositions[4]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f);
-			exhibit_c_model = glm::rotate(exhibit_c_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_c_model = glm::scale(exhibit_c_model, glm::vec3(1.25f)); 
-			exhibit_triangleColourShader.setMat4("model", exhibit_c_model);
-      
-			glDrawArrays(GL_TRIANGLES, 0, 3);		
-
-			/* Exhibit 4 triangle matrix set */
-
-			exhibit_triangleColourRotationShader.use();
-      glBindVertexArray(exhibit_3_VAO);
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_triangleColourRotationShader.setMat4("projection", projection);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_triangleColourRotationShader.setMat4("view", view);
-
-			/* World transformation */
-			glm::mat4 exhibit_d_model = glm::mat4(1.0f);
-			exhibit_triangleColourRotationShader.setMat4("model", exhibit_d_model);
-
-			exhibit_d_model = glm::mat4(1.0f);
-
-			exhibit_d_model = glm::translate(exhibit_d_model, exhibitsPositions[5]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) (glm::radians(90.0f) * (float)glfwGetTime());
-			exhibit_d_model = glm::rotate(exhibit_d_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_d_model = glm::scale(exhibit_d_model, glm::vec3(1.25f)); 
-			exhibit_triangleColourRotationShader.setMat4("model", exhibit_d_model);
-      
-			glDrawArrays(GL_TRIANGLES, 0, 3);		
-
-			/* Exhibit 5 square texture*/
-
-			/* Bind Texture */
-			exhibit_squareTextureShader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-			/* Change textures here */
-			switch (interact_3_exhibit)
-				{
-					case 0:
-					{ 
-						exhibit_squareTextureShader.use();
-						exhibit_squareTextureShader.setInt("exhibit_5_texture_1", 0);
-						exhibit_squareTextureShader.setInt("exhibit_5_texture_2", 1);
-					}
-					break;
-
-					case 1:
-					{
-						exhibit_squareTextureShader.use();
-						exhibit_squareTextureShader.setInt("exhibit_5_texture_2", 0);
-						exhibit_squareTextureShader.setInt("exhibit_5_texture_1", 1);
-					}
-					break;
-			
-					default:
-						break;
-				}
-
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, exhibit_5_texture_1);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, exhibit_5_texture_2);
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_squareTextureShader.setMat4("projection", projection);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_squareTextureShader.setMat4("view", view);
-
-			/* World transformation */
-			glm::mat4 exhibit_e_model = glm::mat4(1.0f);
-			exhibit_squareTextureShader.setMat4("model", exhibit_e_model);
-
-			exhibit_e_model = glm::mat4(1.0f);
-
-			exhibit_e_model = glm::translate(exhibit_e_model, exhibitsPositions[8]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f);
-			exhibit_e_model = glm::rotate(exhibit_e_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_e_model = glm::scale(exhibit_e_model, glm::vec3(1.25f)); 
-			exhibit_squareTextureShader.setMat4("model", exhibit_e_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);	
-
-			/* Exhibit 6 cube texture*/	
-
-			exhibit_cubeTextureShader.use();
-      glBindVertexArray(exhibit_6_VAO);
-
-			/* Change textures here */
-			switch (interact_3_exhibit)
-				{
-					case 0:
-					{ 
-						exhibit_cubeTextureShader.use();
-						exhibit_cubeTextureShader.setInt("exhibit_5_texture_1", 0);
-						exhibit_cubeTextureShader.setInt("exhibit_5_texture_2", 1);
-					}
-					break;
-
-					case 1:
-					{
-						exhibit_cubeTextureShader.use();
-						exhibit_cubeTextureShader.setInt("exhibit_5_texture_2", 0);
-						exhibit_cubeTextureShader.setInt("exhibit_5_texture_1", 1);
-					}
-					break;
-			
-					default:
-						break;
-				}
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, exhibit_5_texture_1);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, exhibit_5_texture_2);
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_cubeTextureShader.setMat4("projection", projection);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_cubeTextureShader.setMat4("view", view);
-
-			/* World transformation */
-			glm::mat4 exhibit_f_model = glm::mat4(1.0f);
-			exhibit_cubeTextureShader.setMat4("model", exhibit_f_model);
-
-			exhibit_f_model = glm::mat4(1.0f);
-
-			exhibit_f_model = glm::translate(exhibit_f_model, exhibitsPositions[9]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f) * (float)glfwGetTime();
-			exhibit_f_model = glm::rotate(exhibit_f_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_f_model = glm::scale(exhibit_f_model, glm::vec3(0.75f)); 
-			exhibit_cubeTextureShader.setMat4("model", exhibit_f_model);
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-
-			/* Exhibit 7 cube with basic lighting and revolving colours */
-
-			exhibit_cubeMultyLightColourShader.use();
-			/* Set a new local to the exhibit light source */
-			glm::vec3 light_pos_exhibit_7(1.2f,  1.0f, -15.0f);
-
-			exhibit_cubeMultyLightColourShader.setVec3("light.position", light_pos_exhibit_7);
-			exhibit_cubeMultyLightColourShader.setVec3("viewPos", camera.Position);
-
-			/* Light properties */
-			glm::vec3 lightColor;
-			glm::vec3 diffuseColor;
-			glm::vec3 ambientColor;
-			switch (interact_4_exhibit)
-				{
-					/* Change colour and material properties based on the sin of the current time */
-					case 0:
-						{
-							lightColor.x = sin(glfwGetTime() * 2.0f);
-							lightColor.y = sin(glfwGetTime() * 0.7f);
-							lightColor.z = sin(glfwGetTime() * 1.3f);
-							/* Decrease the influence */
-							diffuseColor = lightColor   * glm::vec3(0.5f); 
-							/* Low influence */
-							ambientColor = diffuseColor * glm::vec3(0.2f); 
-							
-							/* light properties */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient", ambientColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", diffuseColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 1.0f, 0.5f, 0.31f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 1.0f, 0.5f, 0.31f);
-
-							/* Specular lighting doesn't have full effect on this object's material */
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.5f, 0.5f, 0.5f); 
-
-							/* Keep the shininess at 32 */
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);		
-						}
-					break;
-					/* Set the colour and material properties to a set level */
-					case 1:
-						{
-							lightColor.x = 2.0f;
-							lightColor.y = 1.0f;
-							lightColor.z = 0.5f;
-
-							/* light properties */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient",	lightColor); 
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", lightColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 0.0f, 0.1f, 0.06f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 0.0f, 0.50980392f, 0.50980392f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.50196078f, 0.50196078f, 0.50196078f);
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);
-						}
-					break;
-					case 2:
-						{
-							lightColor.x = 0.5f;
-							lightColor.y = 1.0f;
-							lightColor.z = 2.0f;
-
-							/* Decrease the influence */
-							diffuseColor = lightColor   * glm::vec3(0.5f); 
-							/* Low influence */
-							ambientColor = diffuseColor * glm::vec3(0.5f); 
-							
-							/* light properties */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient", ambientColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", diffuseColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 0.5f, 0.5f, 0.5f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 0.0f, 0.1f, 0.06f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 0.0f, 0.50980392f, 0.50980392f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.50196078f, 0.50196078f, 0.50196078f);
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);
-						}
-					break;
-					default:
-						{
-							lightColor.x = sin(glfwGetTime() * 2.0f);
-							lightColor.y = sin(glfwGetTime() * 0.7f);
-							lightColor.z = sin(glfwGetTime() * 1.3f);
-							/* Decrease the influence */
-							diffuseColor = lightColor   * glm::vec3(0.5f); 
-							/* Low influence */
-							ambientColor = diffuseColor * glm::vec3(0.2f); 
-							
-							/* light properties */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient", ambientColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", diffuseColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 1.0f, 0.5f, 0.31f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 1.0f, 0.5f, 0.31f);
-
-							/* Specular lighting doesn't have full effect on this object's material */
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.5f, 0.5f, 0.5f); 
-
-							/* Keep the shininess at 32 */
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);	
-						}
-					break;
-			}	
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			view = camera.GetViewMatrix();
-			exhibit_cubeMultyLightColourShader.setMat4("projection", projection);
-			exhibit_cubeMultyLightColourShader.setMat4("view", view);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-
-			/* World transformation */
-			glm::mat4 exhibit_g_model = glm::mat4(1.0f);
-			exhibit_cubeMultyLightColourShader.setMat4("model", exhibit_g_model);
-
-			exhibit_g_model = glm::mat4(1.0f);
-
-			exhibit_g_model = glm::translate(exhibit_g_model, exhibitsPositions[12]);
-			/* Scale the exhibit */
-			exhibit_g_model = glm::scale(exhibit_g_model, glm::vec3(0.75f)); 
-			exhibit_cubeMultyLightColourShader.setMat4("model", exhibit_g_model); 
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-
-			exhibit_7_lamp.use();
-			exhibit_7_lamp.setMat4("projection", projection);
-			exhibit_7_lamp.setMat4("view", view);
-
-			glm::mat4 lamp_model2 = glm::mat4(1.0f);
-			lamp_model2 = glm::translate(lamp_model2, light_pos_exhibit_7);
-			/* Make the cube smaller */
-			lamp_model2 = glm::scale(lamp_model2, glm::vec3(0.2f)); 
-			exhibit_7_lamp.setMat4("model", lamp_model2);
-
-			glBindVertexArray(exhibit_7_VAO);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-
-			/* Exhibit 8 cube with basic lighting and revolving colours rotating*/
-
-			exhibit_cubeMultyLightColourShader.use(); 
-			/* Set a new local to the exhibit light source */
-			light_pos_exhibit_7 = glm::vec3(1.2f,  1.0f, -15.0f);
-
-			/* Pass a new local to the exhibit light source to the shader in order to do light calculations */
-			exhibit_cubeMultyLightColourShader.setVec3("light.position", light_pos_exhibit_7);
-			/* Pass the current camera position in order to culculate each fragment colour from that prespective */
-			exhibit_cubeMultyLightColourShader.setVec3("viewPos", camera.Position);
-
-			/* Light properties */
-			switch (interact_4_exhibit)
-				{
-					/* Change colour and material properties based on the sin of the current time */
-					case 0 :
-						{
-							lightColor.x = sin(glfwGetTime() * 2.0f);
-							lightColor.y = sin(glfwGetTime() * 0.7f);
-							lightColor.z = sin(glfwGetTime() * 1.3f);
-							/* Decrease the influence */
-							diffuseColor = lightColor   * glm::vec3(0.5f); 
-							/* Low influence */
-							ambientColor = diffuseColor * glm::vec3(0.2f); 
-							
-							/* light properties */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient", ambientColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", diffuseColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 1.0f, 0.5f, 0.31f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 1.0f, 0.5f, 0.31f);
-
-							/* Specular lighting doesn't have full effect on this object's material */
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.5f, 0.5f, 0.5f); 
-
-							/* Keep the shininess at 32 */
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);		
-						}
-					break;
-					/* Set the colour and material properties to a set level */
-					case 1:
-						{
-							lightColor.x = 2.0f;
-							lightColor.y = 1.0f;
-							lightColor.z = 0.5f;
-
-							/* light properties */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient",	lightColor); 
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", lightColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 0.0f, 0.1f, 0.06f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 0.0f, 0.50980392f, 0.50980392f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.50196078f, 0.50196078f, 0.50196078f);
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);
-						}
-					break;
-					case 2:
-						{
-							lightColor.x = 0.5f;
-							lightColor.y = 1.0f;
-							lightColor.z = 2.0f;
-
-							/* Decrease the influence */
-							diffuseColor = lightColor   * glm::vec3(0.5f); 
-							/* Low influence */
-							ambientColor = diffuseColor * glm::vec3(0.2f); 
-							
-							/* light properties */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient", ambientColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", diffuseColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 0.5f, 0.5f, 0.5f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 0.0f, 0.1f, 0.06f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 0.0f, 0.50980392f, 0.50980392f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.50196078f, 0.50196078f, 0.50196078f);
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);
-						}
-					break;
-					default:
-						{
-							lightColor.x = sin(glfwGetTime() * 2.0f);
-							lightColor.y = sin(glfwGetTime() * 0.7f);
-							lightColor.z = sin(glfwGetTime() * 1.3f);
-							/* Decrease the influence */
-							diffuseColor = lightColor   * glm::vec3(0.5f); 
-							/* Low influence */
-							ambientColor = diffuseColor * glm::vec3(0.2f); 
-							
-							/*  To fill the struct we still have to set the individual uniforms, but this time
-									prefixed with the struct’s name: */
-							exhibit_cubeMultyLightColourShader.setVec3("light.ambient", ambientColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.diffuse", diffuseColor);
-							exhibit_cubeMultyLightColourShader.setVec3("light.specular", 1.0f, 1.0f, 1.0f);
-
-							/* Material properties */
-							exhibit_cubeMultyLightColourShader.setVec3("material.ambient", 1.0f, 0.5f, 0.31f);
-							exhibit_cubeMultyLightColourShader.setVec3("material.diffuse", 1.0f, 0.5f, 0.31f);
-
-							/* Specular lighting doesn't have full effect on this object's material */
-							exhibit_cubeMultyLightColourShader.setVec3("material.specular", 0.5f, 0.5f, 0.5f); 
-
-							/* Keep the shininess at 32 */
-							exhibit_cubeMultyLightColourShader.setFloat("material.shininess", 32.0f);	
-						}
-					break;
-			}	
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			/* Camera/view transformation */
-			view = camera.GetViewMatrix();
-			exhibit_cubeMultyLightColourShader.setMat4("projection", projection);
-			exhibit_cubeMultyLightColourShader.setMat4("view", view);
-
-			/* World transformation */
-			glm::mat4 exhibit_h_model = glm::mat4(1.0f);
-			exhibit_cubeMultyLightColourShader.setMat4("model", exhibit_h_model);
-
-			exhibit_h_model = glm::mat4(1.0f);
-
-			exhibit_h_model = glm::translate(exhibit_h_model, exhibitsPositions[13]);
-
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f) * (float)glfwGetTime();
-			exhibit_h_model = glm::rotate(exhibit_h_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_h_model = glm::scale(exhibit_h_model, glm::vec3(0.75f)); 
-
-			exhibit_cubeMultyLightColourShader.setMat4("model", exhibit_h_model); 
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-
-
-			/* Exhibit explanation */
-
-			/* Bind Texture */
-			exhibit_explanationShader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-			/* Change the exhibits explenation based on button press the changed code reflex the change in the source code */
-			switch (interact_1_exhibit)
-				{
-					case 0:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_1_red);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;
-
-					case 1:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_1_green);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;
-
-					case 2:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_1_blue);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;	
-
-					default:
-						break;
-			}
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanationShader.setMat4("projection", projection);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanationShader.setMat4("view", view);
-
-			/* World transformation */
-			glm::mat4 exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanationShader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[3]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanationShader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);			
-
-			/* Exhibit 2 explanation */
-
-			/* Bind Texture */
-			exhibit_explanation2Shader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-			/* Change the exhibits colour based on button press */
-			/* As well as the colour of the source code in the description by changing the description texture */
-			switch (interact_2_exhibit)
-				{
-					case 0:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_2_red);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;
-
-					case 1:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_2_green);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;
-
-					case 2:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_2_blue);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;	
-
-					default:
-						break;
-			}
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanation2Shader.setMat4("projection", projection);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanation2Shader.setMat4("view", view);
-
-			/* World transformation */
-			exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanation2Shader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[2]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(270.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanation2Shader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);		
-
-			/* Exhibit 3 explanation */
-
-			/* Bind Texture */
-			exhibit_explanation3Shader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, text_texture_3);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, openGL_logo);
-
-			/* Pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanation3Shader.setMat4("projection", projection);
-
-			/* Camera/view transformation */
-			/* Make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanation3Shader.setMat4("view", view);
-
-			/* World transformation */
-			exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanation3Shader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[7]);
-			/* Rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* Scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanation3Shader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);	
-
-			/* Exhibit 4 explanation */
-
-			/* bind Texture */
-			exhibit_explanation4Shader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, text_texture_4);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, openGL_logo);
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanation4Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanation4Shader.setMat4("view", view);
-
-			/* world transformation */
-			exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanation4Shader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[6]);
-			/* rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(270.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanation4Shader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);	
-
-			/* exhibit 5 explanation */
-
-			/* bind Texture */
-			exhibit_explanation5Shader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-			/* Change textures here */
-			switch (interact_3_exhibit)
-				{
-					case 0:
-					{ 
-						glActiveTexture(GL_TEXTURE0);
-						glBindTexture(GL_TEXTURE_2D, text_texture_5);
-						glActiveTexture(GL_TEXTURE1);
-						glBindTexture(GL_TEXTURE_2D, openGL_logo);
-					}
-					break;
-
-					case 1:
-					{
-						glActiveTexture(GL_TEXTURE0);
-						glBindTexture(GL_TEXTURE_2D, text_texture_5_swap);
-						glActiveTexture(GL_TEXTURE1);
-						glBindTexture(GL_TEXTURE_2D, openGL_logo);
-					}
-					break;
-			
-					default:
-						break;
-				}
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanation5Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanation5Shader.setMat4("view", view);
-
-			/* world transformation */
-			exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanation5Shader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[11]);
-			/* rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanation5Shader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-			/* exhibit 6 explanation */
-
-			/* bind Texture */
-			exhibit_explanation6Shader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-			/* Change textures here */
-			switch (interact_3_exhibit)
-				{
-					case 0:
-					{ 
-						glActiveTexture(GL_TEXTURE0);
-						glBindTexture(GL_TEXTURE_2D, text_texture_6);
-						glActiveTexture(GL_TEXTURE1);
-						glBindTexture(GL_TEXTURE_2D, openGL_logo);
-					}
-					break;
-
-					case 1:
-					{
-						glActiveTexture(GL_TEXTURE0);
-						glBindTexture(GL_TEXTURE_2D, text_texture_6_swap);
-						glActiveTexture(GL_TEXTURE1);
-						glBindTexture(GL_TEXTURE_2D, openGL_logo);
-					}
-					break;
-			
-					default:
-						break;
-				}
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanation6Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanation6Shader.setMat4("view", view);
-
-			/* world transformation */
-			exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanation6Shader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[10]);
-			/* rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(270.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanation6Shader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-			/* exhibit 7 explanation */
-
-			/* bind Texture */
-			exhibit_explanation7Shader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, text_texture_7);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, openGL_logo);
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanation7Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanation7Shader.setMat4("view", view);
-
-			/* world transformation */
-			exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanation7Shader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[15]);
-			/* rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(90.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanation7Shader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-			/* exhibit 8 explanation */
-
-			/* bind Texture */
-			exhibit_explanation8Shader.use();
-      glBindVertexArray(exhibit_explenations_VAO);
-
-			switch (interact_4_exhibit)
-				{
-					case 0:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_8);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;
-
-					case 1:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_8_case1);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;
-
-					case 2:
-						{
-							glActiveTexture(GL_TEXTURE0);
-							glBindTexture(GL_TEXTURE_2D, text_texture_8_case2);
-							glActiveTexture(GL_TEXTURE1);
-							glBindTexture(GL_TEXTURE_2D, openGL_logo);
-						}
-					break;	
-
-					default:
-						break;
-			}
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			exhibit_explanation8Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			exhibit_explanation8Shader.setMat4("view", view);
-
-			/* world transformation */
-			exhibit_explanation_model = glm::mat4(1.0f);
-			exhibit_explanation8Shader.setMat4("model", exhibit_explanation_model);
-
-			exhibit_explanation_model = glm::mat4(1.0f);
-
-			exhibit_explanation_model = glm::translate(exhibit_explanation_model, exhibitsPositions[14]);
-			/* rotate the object to on an axis xyz based on the current time */
-			angle = (float) glm::radians(270.0f);
-			exhibit_explanation_model = glm::rotate(exhibit_explanation_model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
-
-			/* scale the exhibit */
-			exhibit_explanation_model = glm::scale(exhibit_explanation_model, glm::vec3(1.25f)); 
-			exhibit_explanation8Shader.setMat4("model", exhibit_explanation_model);
-
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-
-			/* be sure to activate shader when setting uniforms/drawing objects */
-			wall_Shader.use();
-			wall_Shader.setVec3("vewPos", camera.Position);
-			wall_Shader.setFloat("material.shininess", 32.0f);
-
-			/* light properties */
-			/*
-					Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index 
-					the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-					by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-					by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-			*/		
-			glm::vec3 wallPointLightColors[] = 
-				{
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f)
-				};
-			/* directional light */
-			wall_Shader.setVec3("dirLight.direction", 0.0f, 1.75f, 0.0f);
-			wall_Shader.setVec3("dirLight.ambient", 0.1f, 0.1f, 0.1f);
-			wall_Shader.setVec3("dirLight.diffuse", 0.1f, 0.1f, 0.1f);
-			wall_Shader.setVec3("dirLight.specular", 0.1f, 0.1f, 0.1f);
-
-			char attribute_buffer[50];
-			/* point light attributes */
-			for (int i=0; i<NR_POINT_LIGHTS; i++)
-				{
-					sprintf(attribute_buffer,"pointLights[%d].position", i);
-					wall_Shader.setVec3(attribute_buffer, pointLightPositions[i]);
-					
-					sprintf(attribute_buffer,"pointLights[%d].ambient", i);
-					wall_Shader.setVec3(attribute_buffer, wallPointLightColors[i].x * 0.1,  wallPointLightColors[i].y * 0.1,  wallPointLightColors[i].z * 0.1);		
-										
-					sprintf(attribute_buffer,"pointLights[%d].diffuse", i);
-					wall_Shader.setVec3(attribute_buffer, wallPointLightColors[i].x,  wallPointLightColors[i].y,  wallPointLightColors[i].z);
-
-					sprintf(attribute_buffer,"pointLights[%d].specular", i);
-					wall_Shader.setVec3(attribute_buffer, wallPointLightColors[i].x,  wallPointLightColors[i].y,  wallPointLightColors[i].z);
-										
-					sprintf(attribute_buffer,"pointLights[%d].constant", i);
-					wall_Shader.setFloat(attribute_buffer, 1.0f);
-										
-					sprintf(attribute_buffer,"pointLights[%d].linear", i);
-					wall_Shader.setFloat(attribute_buffer, 0.09);
-										
-					sprintf(attribute_buffer,"pointLights[%d].quadratic", i);
-					wall_Shader.setFloat(attribute_buffer, 0.032);									
-				}
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-			wall_Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			wall_Shader.setMat4("view", view);
-
-			/* world transformation */
-			glm::mat4 wall_model = glm::mat4(1.0f);
-			wall_Shader.setMat4("model", wall_model);
-			
-			/* bind diffuse map */
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, diffuseMap_wall);
-			/* bind specular map */
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, specularMap_wall);	
-
-			/* render container */
-			glBindVertexArray(wall_VAO);
-
-			/* loop in order to draw all the boxes with different attributes */
-			for (unsigned int i = 0; i < NUM_OF_CUBES; i++)
-				{
-					/* calculate the model matrix for each object and pass it to shader before drawing */
-					glm::mat4 wall_model = glm::mat4(1.0f);
-					/* place the cubes in various locations */
-					wall_model = glm::translate(wall_model, cubePositions[i]);
-
-					/* enlarge the cubes to make them more like a corridor*/
-					wall_model = glm::scale(wall_model, glm::vec3(4.0f)); 
-					/* send the model matrix to the shader */
-					wall_Shader.setMat4("model", wall_model);
-
-					glDrawArrays(GL_TRIANGLES, 0, 12);
-					GLClearError();
-				}
-
-			/* activate shader */
-			floor_Shader.use();
-			floor_Shader.setVec3("vewPos", camera.Position);
-			floor_Shader.setFloat("material.shininess", 32.0f);
-
-			/* light properties */
-			/*
-					Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index 
-					the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-					by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-					by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-			*/
-			glm::vec3 floorPointLightColors[] = 
-				{
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f),
-					glm::vec3(0.1f, 0.1f, 0.1f)
-				};
-			/* directional light */
-			floor_Shader.setVec3("dirLight.direction", 0.0f, 1.75f, 0.0f);
-			floor_Shader.setVec3("dirLight.ambient", 0.5f, 0.5f, 0.5f);
-			floor_Shader.setVec3("dirLight.diffuse", 0.5f, 0.5f, 0.5f);
-			floor_Shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);	
-			/* point light attributes */
-			for (int i=0; i<NR_POINT_LIGHTS; i++)
-				{
-					sprintf(attribute_buffer,"pointLights[%d].position", i);
-					floor_Shader.setVec3(attribute_buffer, pointLightPositions[i]);
-					
-					sprintf(attribute_buffer,"pointLights[%d].ambient", i);
-					floor_Shader.setVec3(attribute_buffer, floorPointLightColors[i].x * 0.1,  floorPointLightColors[i].y * 0.1,  floorPointLightColors[i].z * 0.1);		
-										
-					sprintf(attribute_buffer,"pointLights[%d].diffuse", i);
-					floor_Shader.setVec3(attribute_buffer, floorPointLightColors[i].x,  floorPointLightColors[i].y,  floorPointLightColors[i].z);
-
-					sprintf(attribute_buffer,"pointLights[%d].specular", i);
-					floor_Shader.setVec3(attribute_buffer, floorPointLightColors[i].x,  floorPointLightColors[i].y,  floorPointLightColors[i].z);
-										
-					sprintf(attribute_buffer,"pointLights[%d].constant", i);
-					floor_Shader.setFloat(attribute_buffer, 1.0f);
-										
-					sprintf(attribute_buffer,"pointLights[%d].linear", i);
-					floor_Shader.setFloat(attribute_buffer, 0.09);
-										
-					sprintf(attribute_buffer,"pointLights[%d].quadratic", i);
-					floor_Shader.setFloat(attribute_buffer, 0.032);									
-				}
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);			
-			floor_Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			floor_Shader.setMat4("view", view);
-
-			/* world transformation */
-			glm::mat4 floor_model = glm::mat4(1.0f);
-			floor_Shader.setMat4("model", floor_model);
-
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, diffuseMap_floor);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, specularMap_floor);
-
-			/* render container */
-			glBindVertexArray(floor_VAO);		
-
-			/* loop in order to draw all the boxes with different attributes */
-			for (unsigned int i = 0; i < NUM_OF_CUBES; i++)
-				{
-					/* calculate the model matrix for each object and pass it to shader before drawing */
-					glm::mat4 floor_model = glm::mat4(1.0f);
-					/* place the cubes in various locations */
-					floor_model = glm::translate(floor_model, cubePositions[i]);
-
-					/* enlarge the cubes to make them more like a corridor*/
-					floor_model = glm::scale(floor_model, glm::vec3(4.0f)); 
-					/* send the model matrix to the shader */
-					floor_Shader.setMat4("model", floor_model);
-
-					GLCall(glDrawArrays(GL_TRIANGLES, 0, 6));
-				}
-
-			/* activate shader */
-			celling_Shader.use();
-			celling_Shader.setVec3("vewPos", camera.Position);
-			celling_Shader.setFloat("material.shininess", 32.0f);
-
-			/* light properties */
-			/*
-					Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index 
-					the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-					by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-					by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-			*/	
-			glm::vec3 cellingPointLightColors[] = 
-				{
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f),
-					glm::vec3(1.0f, 1.0f, 1.0f)
-				};	
-			/* directional light */
-			celling_Shader.setVec3("dirLight.direction", 0.0f, 1.75f, 0.0f);
-			celling_Shader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-			celling_Shader.setVec3("dirLight.diffuse", 0.5f, 0.5f, 0.5f);
-			celling_Shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-			/* point light attributes */
-			for (int i=0; i<NR_POINT_LIGHTS; i++)
-				{
-					sprintf(attribute_buffer,"pointLights[%d].position", i);
-					celling_Shader.setVec3(attribute_buffer, pointLightPositions[i]);
-					
-					sprintf(attribute_buffer,"pointLights[%d].ambient", i);
-					celling_Shader.setVec3(attribute_buffer, cellingPointLightColors[i].x * 0.1,  cellingPointLightColors[i].y * 0.1,  cellingPointLightColors[i].z * 0.1);		
-										
-					sprintf(attribute_buffer,"pointLights[%d].diffuse", i);
-					celling_Shader.setVec3(attribute_buffer, cellingPointLightColors[i].x,  cellingPointLightColors[i].y,  cellingPointLightColors[i].z);
-
-					sprintf(attribute_buffer,"pointLights[%d].specular", i);
-					celling_Shader.setVec3(attribute_buffer, cellingPointLightColors[i].x,  cellingPointLightColors[i].y,  cellingPointLightColors[i].z);
-										
-					sprintf(attribute_buffer,"pointLights[%d].constant", i);
-					celling_Shader.setFloat(attribute_buffer, 1.0f);
-										
-					sprintf(attribute_buffer,"pointLights[%d].linear", i);
-					celling_Shader.setFloat(attribute_buffer, 0.09);
-										
-					sprintf(attribute_buffer,"pointLights[%d].quadratic", i);
-					celling_Shader.setFloat(attribute_buffer, 0.032);									
-				}
-
-			/* pass projection matrix to shader (note that in this case it could change every frame) */
-			projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);						
-			celling_Shader.setMat4("projection", projection);
-
-			/* camera/view transformation */
-			/* make sure to initialize matrix to identity matrix first */
-			view = camera.GetViewMatrix();
-			celling_Shader.setMat4("view", view);
-			
-			/* world transformation */
-			glm::mat4 celling_model = glm::mat4(1.0f);
-			celling_Shader.setMat4("model", celling_model);
-
-      glActiveTexture(GL_TEXTURE0);
-    	glBindTexture(GL_TEXTURE_2D, diffuseMap_celling);
-      glActiveTexture(GL_TEXTURE1);
-      glBindTexture(GL_TEXTURE_2D, specularMap_celling);
-
-			/* render container */
-			glBindVertexArray(celling_VAO);		
-
-			/* loop in order to draw all the boxes with different attributes */
-			for (unsigned int i = 0; i < NUM_OF_CUBES; i++)
-				{
-					/* calculate the model matrix for each object and pass it to shader before drawing */
-					glm::mat4 celling_model = glm::mat4(1.0f);
-					/* place the cubes in various locations */
-					celling_model = glm::translate(celling_model, cubePositions[i]);
-
-					/* enlarge the cubes to make them more like a corridor*/
-					celling_model = glm::scale(celling_model, glm::vec3(4.0f)); 
-					/* send the model matrix to the shader */
-					celling_Shader.setMat4("model", celling_model);
-
-					glDrawArrays(GL_TRIANGLES, 0, 6);
-				}
-
-			/* also draw the lamp objects */
-			lampShader.use();
-			lampShader.setMat4("projection", projection);
-			lampShader.setMat4("view", view);
-
-			/* many smaller cubes */
-			glBindVertexArray(lightVAO);
-			for (unsigned int i = 0; i < NR_POINT_LIGHTS; i++)
-				{
-					glm::mat4 lamp_model = glm::mat4(1.0f);
-					lamp_model = glm::translate(lamp_model, pointLightPositions[i]);
-					/* Make it a smaller cube */
-					lamp_model = glm::scale(lamp_model, glm::vec3(0.2f)); 
-					lampShader.setMat4("model", lamp_model);
-					glDrawArrays(GL_TRIANGLES, 0, 6);
-				}
-
-			/* glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.) */
-			glfwSwapBuffers(window);
-			glfwPollEvents();
-		}
+	/* Stop the decode workers and free the upload buffers while the context is alive */
+	textureLoader.shutdown();
 
 	/* glfw: terminate, clearing all previously allocated GLFW resources. */
-	glfwTerminate();
+	if (headless)
+		headlessContext.destroy();
+	else
+		glfwTerminate();
 
 	return 0;
 }
@@ -2255,6 +1471,7 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 /* process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly */
 void processInput(GLFWwindow *window)
 {
+	CPU_PROFILE_FUNCTION();
 	/* glfwGetKey function that takes the window as input together with a key */
 	if(glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 	{ 
@@ -2317,6 +1534,38 @@ void processInput(GLFWwindow *window)
 			{
 			}
 		}
+	/* immediate or indirect exhibit drawing */
+	if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS)
+		{
+			indirect_draw = !indirect_draw && IndirectRenderer::supported();
+			for(int i=0; i < 21474836; i++)
+			{
+			}
+		}
+	/* Hi-Z occlusion culling of the indirect batch */
+	if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS)
+		{
+			occlusion_culling = !occlusion_culling && OcclusionCuller::supported();
+			for(int i=0; i < 21474836; i++)
+			{
+			}
+		}
+	/* GPU profiler overlay */
+	if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
+		{
+			gpu_profiling = !gpu_profiling;
+			for(int i=0; i < 21474836; i++)
+			{
+			}
+		}
+	/* Frame statistics on the console */
+	if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
+		{
+			print_stats = 1;
+			for(int i=0; i < 21474836; i++)
+			{
+			}
+		}
 		
 }
 /* glfw: whenever the mouse moves, this callback is called */
@@ -2344,47 +1593,203 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
   camera.ProcessMouseScroll(yoffset);
 }
 
-/* utility function for loading a 2D texture from file */
-unsigned int loadTexture(char const * path)
+/* Look up the model matrix every shader takes */
+TransformUniforms getTransformUniforms(const Shader &shader)
 {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-	
-	int width, height, nrComponents;
-	unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-	stbi_set_flip_vertically_on_load(true);
-	if (data)
-		{
-			GLenum format;
-			if (nrComponents == 1)
-					format = GL_RED;
-			else if (nrComponents == 3)
-					format = GL_RGB;
-			else if (nrComponents == 4)
-					format = GL_RGBA;
+	TransformUniforms uniforms;
+	uniforms.model = shader.uniform("model");
+
+	return uniforms;
+}
 
-			glBindTexture(GL_TEXTURE_2D, textureID);
+/* Change colour and material properties of exhibit 7 and 8 based on button press */
+LitCubeParameters getLitCubeParameters(const LitCubeSettings &settings, int state, double time)
+{
+	LitCubeParameters parameters;
 
-			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	/* Light properties */
+	glm::vec3 lightColor;
+	glm::vec3 diffuseColor;
+	glm::vec3 ambientColor;
+	switch (state)
+		{
+			/* Set the colour and material properties to a set level */
+			case 1:
+				{
+					lightColor.x = 2.0f;
+					lightColor.y = 1.0f;
+					lightColor.z = 0.5f;
+
+					/* light properties */
+					parameters.lightAmbient = lightColor;
+					parameters.lightDiffuse = lightColor;
+					parameters.lightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+
+					/* Material properties */
+					parameters.materialAmbient = glm::vec3(0.0f, 0.1f, 0.06f);
+					parameters.materialDiffuse = glm::vec3(0.0f, 0.50980392f, 0.50980392f);
+					parameters.materialSpecular = glm::vec3(0.50196078f, 0.50196078f, 0.50196078f);
+					parameters.shininess = 32.0f;
+				}
+			break;
+			case 2:
+				{
+					lightColor.x = 0.5f;
+					lightColor.y = 1.0f;
+					lightColor.z = 2.0f;
+
+					/* Decrease the influence */
+					diffuseColor = lightColor   * glm::vec3(0.5f); 
+					/* Low influence */
+					ambientColor = diffuseColor * glm::vec3(settings.fixedAmbientStrength); 
+					
+					/* light properties */
+					parameters.lightAmbient = ambientColor;
+					parameters.lightDiffuse = diffuseColor;
+					parameters.lightSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
+
+					/* Material properties */
+					parameters.materialAmbient = glm::vec3(0.0f, 0.1f, 0.06f);
+					parameters.materialDiffuse = glm::vec3(0.0f, 0.50980392f, 0.50980392f);
+					parameters.materialSpecular = glm::vec3(0.50196078f, 0.50196078f, 0.50196078f);
+					parameters.shininess = 32.0f;
+				}
+			break;
+			/* Change colour and material properties based on the sin of the current time */
+			case 0:
+			default:
+				{
+					lightColor.x = sin(time * 2.0f);
+					lightColor.y = sin(time * 0.7f);
+					lightColor.z = sin(time * 1.3f);
+					/* Decrease the influence */
+					diffuseColor = lightColor   * glm::vec3(0.5f); 
+					/* Low influence */
+					ambientColor = diffuseColor * glm::vec3(0.2f); 
+					
+					/* light properties */
+					parameters.lightAmbient = ambientColor;
+					parameters.lightDiffuse = diffuseColor;
+					parameters.lightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
 
-			glGenerateMipmap(GL_TEXTURE_2D);
+					/* Material properties */
+					parameters.materialAmbient = glm::vec3(1.0f, 0.5f, 0.31f);
+					parameters.materialDiffuse = glm::vec3(1.0f, 0.5f, 0.31f);
 
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+					/* Specular lighting doesn't have full effect on this object's material */
+					parameters.materialSpecular = glm::vec3(0.5f, 0.5f, 0.5f); 
 
-			stbi_image_free(data);
+					/* Keep the shininess at 32 */
+					parameters.shininess = 32.0f;
+				}
+			break;
 		}
-	else
+
+	return parameters;
+}
+
+void setLitCubeUniforms(const Exhibit &exhibit, int state, double time)
+{
+	const LitCubeSettings *settings = (const LitCubeSettings *)exhibit.prepareData;
+	const LitCubeUniforms &uniforms = settings->uniforms;
+	Shader &shader = *exhibit.program;
+	LitCubeParameters parameters = getLitCubeParameters(*settings, state, time);
+
+	shader.setVec3(uniforms.light.position, settings->lightPosition);
+	shader.setVec3(uniforms.light.ambient, parameters.lightAmbient);
+	shader.setVec3(uniforms.light.diffuse, parameters.lightDiffuse);
+	shader.setVec3(uniforms.light.specular, parameters.lightSpecular);
+
+	shader.setVec3(uniforms.material.ambient, parameters.materialAmbient);
+	shader.setVec3(uniforms.material.diffuse, parameters.materialDiffuse);
+	shader.setVec3(uniforms.material.specular, parameters.materialSpecular);
+	shader.setFloat(uniforms.material.shininess, parameters.shininess);
+}
+
+void setLitCubeIndirect(const Exhibit &exhibit, int state, double time, IndirectObject &object)
+{
+	const LitCubeSettings *settings = (const LitCubeSettings *)exhibit.prepareData;
+	LitCubeParameters parameters = getLitCubeParameters(*settings, state, time);
+
+	object.lightPosition = glm::vec4(settings->lightPosition, 1.0f);
+	object.lightAmbient = glm::vec4(parameters.lightAmbient, 0.0f);
+	object.lightDiffuse = glm::vec4(parameters.lightDiffuse, 0.0f);
+	object.lightSpecular = glm::vec4(parameters.lightSpecular, 0.0f);
+
+	object.materialAmbient = glm::vec4(parameters.materialAmbient, 0.0f);
+	object.materialDiffuse = glm::vec4(parameters.materialDiffuse, 0.0f);
+	object.materialSpecular = glm::vec4(parameters.materialSpecular, parameters.shininess);
+}
+
+void reportExhibitTiming(int indirect, double milliseconds, unsigned int frames, size_t draws, size_t batched)
+{
+	if (frames == 0)
+		return;
+
+	std::cout << "Exhibits " << (indirect ? "indirect" : "immediate") << ": " << milliseconds / frames << " ms CPU per frame over "
+		<< frames << " frames, " << draws << " draws";
+	if (batched > 0)
+		std::cout << " + 1 multi draw of " << batched;
+	std::cout << std::endl;
+}
+
+/* Fill the light uniform block of one corridor surface, the shared point lights are scaled by pointLightTint on it */
+LightBlock makeCorridorLights(glm::vec3 dirAmbient, glm::vec3 dirDiffuse, glm::vec3 dirSpecular, glm::vec3 pointLightTint)
+{
+	LightBlock lights = {};
+
+	/* directional light */
+	lights.dirLight.direction = glm::vec3(0.0f, 1.75f, 0.0f);
+	lights.dirLight.ambient = dirAmbient;
+	lights.dirLight.diffuse = dirDiffuse;
+	lights.dirLight.specular = dirSpecular;
+
+	/* point light colour of this surface */
+	lights.pointLightTint = pointLightTint;
+
+	return lights;
+}
+
+std::vector<PointLightBlock> makePointLights(const glm::vec3 *pointLightPositions, unsigned int count)
+{
+	std::vector<PointLightBlock> lights(count);
+
+	/* point light attributes */
+	for (unsigned int i = 0; i < count; i++)
 		{
-			std::cout << "Texture failed to load at path: " << path << std::endl;
-			stbi_image_free(data);
+			lights[i].position = pointLightPositions[i];
+			lights[i].ambient = glm::vec3(1.0f) * 0.1f;
+			lights[i].diffuse = glm::vec3(1.0f);
+			lights[i].specular = glm::vec3(1.0f);
+			lights[i].constant = 1.0f;
+			lights[i].linear = 0.09f;
+			lights[i].quadratic = 0.032f;
+			lights[i].radius = LightCuller::effectiveRadius(lights[i]);
 		}
 
-	return textureID;
+	return lights;
+}
+
+/* Look up the single light and material of exhibit 7 and 8 */
+LitCubeUniforms getLitCubeUniforms(const Shader &shader)
+{
+	LitCubeUniforms uniforms;
+	static_cast<TransformUniforms &>(uniforms) = getTransformUniforms(shader);
+
+	uniforms.light.position = shader.uniform("light.position");
+	uniforms.light.ambient = shader.uniform("light.ambient");
+	uniforms.light.diffuse = shader.uniform("light.diffuse");
+	uniforms.light.specular = shader.uniform("light.specular");
+
+	uniforms.material.ambient = shader.uniform("material.ambient");
+	uniforms.material.diffuse = shader.uniform("material.diffuse");
+	uniforms.material.specular = shader.uniform("material.specular");
+	uniforms.material.shininess = shader.uniform("material.shininess");
+
+	return uniforms;
 }
 
+
 /* Get the maximum resolution from the primary monitor */
 void get_resolution() 
 {
@@ -2392,4 +1797,65 @@ void get_resolution()
 
 	SCR_WIDTH = mode->width;
 	SCR_HEIGHT = mode->height;
+}
+
+GLFWwindow* createWindow()
+{
+	/* Initialize the library */
+	if( !glfwInit() )
+		{
+			fprintf( stderr, "Failed to initialize GLFW\n" );
+			getchar();
+			return NULL;
+		}
+
+	/* Adding extra openGL options and version */
+	glfwWindowHint(GLFW_SAMPLES, 256);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	/* We don't want the old OpenGL */
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);  
+	/* A debug context reports more through GLDebugOutput, but can be slower */
+	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, gl_debug ? GLFW_TRUE : GLFW_FALSE);
+
+	/* Auto retrieve and select primary monitors max resolution */
+	get_resolution();
+
+	/* Create a window in full screen and set its OpenGL context */
+	GLFWwindow* window = glfwCreateWindow( SCR_WIDTH, SCR_HEIGHT, "Computer Graphics Course-OpenGL Project", glfwGetPrimaryMonitor(), NULL);
+	if( window == NULL )
+		{
+			fprintf( stderr, "Failed to open GLFW window.\n" );
+			glfwTerminate();
+			return NULL;
+		}
+	
+	/* Make the window's context current */
+	glfwMakeContextCurrent(window);
+
+	/* Tell GLFW we want to call this function on every window resize by registering it */
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+
+	/* Set the callback functions to be called on every mouse event */
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	/* Tell GLFW to capture our mouse */
+  glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);	
+
+	/* Glad: load all OpenGL function pointers */
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			std::cout << "Failed to initialize GLAD" << std::endl;
+			return NULL;
+		}
+
+	return window;
+}
+
+double frameClock()
+{
+	if (headless)
+		return headlessContext.time();
+	return glfwGetTime();
 } 
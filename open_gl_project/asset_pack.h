@@ -0,0 +1,196 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+/* Every shader and texture of the project in one file, written by the packer and mapped read only by the app.
+
+	header: magic "APAK", version, entry count, padding, TOC offset, string table offset
+	TOC: one AssetPackEntry per file, sorted by name so lookups are a binary search
+	string table: the names, not null terminated
+	data: every file, each starting on a 16 byte boundary */
+
+#define ASSET_PACK_MAGIC "APAK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 16
+
+struct AssetPackHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t padding;
+	uint64_t tocOffset;
+	uint64_t stringsOffset;
+};
+
+struct AssetPackEntry
+{
+	uint64_t offset;
+	uint64_t size;
+	/* FNV-1a of the data, computed by the packer so the app never has to touch the pages to dedup them */
+	uint64_t contentHash;
+	uint32_t nameOffset;
+	uint32_t nameLength;
+};
+
+/* A file inside the mapping, valid for as long as the pack stays open */
+struct AssetView
+{
+	const unsigned char *data;
+	size_t size;
+	uint64_t contentHash;
+};
+
+/* FNV-1a, the same hash the packer stores in the TOC */
+inline uint64_t assetPackHash(const unsigned char *data, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 0x100000001b3ull;
+		}
+	return hash;
+}
+
+class AssetPack
+{
+public:
+	AssetPack() : mapping(NULL), mappingSize(0), entries(NULL), entryCount(0), strings(NULL)
+		{
+		}
+
+	~AssetPack()
+		{
+			close();
+		}
+
+	/* Map the pack, false when it is missing or damaged, in which case every lookup misses */
+	bool open(const char *path)
+		{
+			close();
+
+			int descriptor = ::open(path, O_RDONLY);
+			if (descriptor < 0)
+				return false;
+
+			struct stat info;
+			if (fstat(descriptor, &info) != 0 || info.st_size < (off_t)sizeof(AssetPackHeader))
+				{
+					::close(descriptor);
+					return false;
+				}
+
+			void *address = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			/* The mapping keeps the file alive on its own */
+			::close(descriptor);
+			if (address == MAP_FAILED)
+				return false;
+
+			mapping = (const unsigned char *)address;
+			mappingSize = info.st_size;
+
+			if (!validate())
+				{
+					close();
+					return false;
+				}
+			return true;
+		}
+
+	void close()
+		{
+			if (mapping != NULL)
+				munmap((void *)mapping, mappingSize);
+			mapping = NULL;
+			mappingSize = 0;
+			entries = NULL;
+			entryCount = 0;
+			strings = NULL;
+		}
+
+	bool isOpen() const
+		{
+			return mapping != NULL;
+		}
+
+	/* Look up a file by the name it was packed under, the view points straight into the mapping */
+	bool find(const std::string &name, AssetView &view) const
+		{
+			size_t low = 0, high = entryCount;
+			while (low < high)
+				{
+					size_t middle = (low + high) / 2;
+					int order = compare(entries[middle], name);
+					if (order == 0)
+						{
+							view.data = mapping + entries[middle].offset;
+							view.size = entries[middle].size;
+							view.contentHash = entries[middle].contentHash;
+							return true;
+						}
+					if (order < 0)
+						low = middle + 1;
+					else
+						high = middle;
+				}
+			return false;
+		}
+
+	size_t size() const
+		{
+			return entryCount;
+		}
+
+private:
+	const unsigned char *mapping;
+	size_t mappingSize;
+	const AssetPackEntry *entries;
+	size_t entryCount;
+	const char *strings;
+
+	int compare(const AssetPackEntry &entry, const std::string &name) const
+		{
+			size_t length = entry.nameLength < name.size() ? entry.nameLength : name.size();
+			int order = memcmp(strings + entry.nameOffset, name.data(), length);
+			if (order != 0)
+				return order;
+			if (entry.nameLength == name.size())
+				return 0;
+			return entry.nameLength < name.size() ? -1 : 1;
+		}
+
+	/* Every offset has to stay inside the mapping before any of it is trusted */
+	bool validate()
+		{
+			const AssetPackHeader *header = (const AssetPackHeader *)mapping;
+			if (memcmp(header->magic, ASSET_PACK_MAGIC, 4) != 0 || header->version != ASSET_PACK_VERSION)
+				return false;
+			if (header->tocOffset > mappingSize || header->entryCount > (mappingSize - header->tocOffset) / sizeof(AssetPackEntry))
+				return false;
+			if (header->stringsOffset > mappingSize)
+				return false;
+
+			entries = (const AssetPackEntry *)(mapping + header->tocOffset);
+			entryCount = header->entryCount;
+			strings = (const char *)(mapping + header->stringsOffset);
+
+			for (size_t i = 0; i < entryCount; i++)
+				{
+					if (entries[i].offset > mappingSize || entries[i].size > mappingSize - entries[i].offset)
+						return false;
+					if (header->stringsOffset + entries[i].nameOffset + entries[i].nameLength > mappingSize)
+						return false;
+				}
+			return true;
+		}
+};
+#endif
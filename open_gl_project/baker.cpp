@@ -0,0 +1,452 @@
+/* Offline texture baker: turns the JPEG/PNG textures of the museum into KTX2 files holding a full mip chain
+	of BC1 (opaque), BC3 (with alpha) or, with --bc7, BC7 blocks, ready for glCompressedTexImage2D.
+
+	usage: baker [--bc7] [-o output_dir] image...
+
+	Every image.jpg becomes image.ktx2, next to it unless an output directory is given. The app picks up the
+	.ktx2 file in place of the image when it is there, "make bake" runs this over every texture */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "ktx2.h"
+
+/* An RGBA8 image, one mip level */
+struct Image
+{
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+};
+
+static int clampInt(int value, int low, int high)
+{
+	return value < low ? low : (value > high ? high : value);
+}
+
+/* 2x2 box filter, the last row or column is repeated for odd sizes */
+static Image downsample(const Image &source)
+{
+	Image result;
+	result.width = source.width > 1 ? source.width / 2 : 1;
+	result.height = source.height > 1 ? source.height / 2 : 1;
+	result.pixels.resize((size_t)result.width * result.height * 4);
+
+	for (int y = 0; y < result.height; y++)
+		for (int x = 0; x < result.width; x++)
+			{
+				int x0 = clampInt(x * 2, 0, source.width - 1), x1 = clampInt(x * 2 + 1, 0, source.width - 1);
+				int y0 = clampInt(y * 2, 0, source.height - 1), y1 = clampInt(y * 2 + 1, 0, source.height - 1);
+				for (int c = 0; c < 4; c++)
+					{
+						int sum = source.pixels[((size_t)y0 * source.width + x0) * 4 + c] + source.pixels[((size_t)y0 * source.width + x1) * 4 + c]
+							+ source.pixels[((size_t)y1 * source.width + x0) * 4 + c] + source.pixels[((size_t)y1 * source.width + x1) * 4 + c];
+						result.pixels[((size_t)y * result.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+					}
+			}
+
+	return result;
+}
+
+/* The 4x4 block at bx, by, edge blocks repeat the last pixel */
+static void fetchBlock(const Image &image, int bx, int by, unsigned char block[16][4])
+{
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 4; x++)
+			{
+				int px = clampInt(bx * 4 + x, 0, image.width - 1);
+				int py = clampInt(by * 4 + y, 0, image.height - 1);
+				memcpy(block[y * 4 + x], &image.pixels[((size_t)py * image.width + px) * 4], 4);
+			}
+}
+
+/* Pick the two pixels furthest apart along the block's bounding box diagonal as endpoints */
+static void findEndpoints(const unsigned char block[16][4], int channels, int low[4], int high[4])
+{
+	int minimum[4] = { 255, 255, 255, 255 }, maximum[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < channels; c++)
+			{
+				minimum[c] = block[i][c] < minimum[c] ? block[i][c] : minimum[c];
+				maximum[c] = block[i][c] > maximum[c] ? block[i][c] : maximum[c];
+			}
+
+	int axis[4] = { 0, 0, 0, 0 };
+	for (int c = 0; c < channels; c++)
+		axis[c] = maximum[c] - minimum[c];
+
+	int lowIndex = 0, highIndex = 0;
+	long lowDot = 0x7FFFFFFF, highDot = -0x7FFFFFFF;
+	for (int i = 0; i < 16; i++)
+		{
+			long dot = 0;
+			for (int c = 0; c < channels; c++)
+				dot += (long)block[i][c] * axis[c];
+			if (dot < lowDot)
+				{
+					lowDot = dot;
+					lowIndex = i;
+				}
+			if (dot > highDot)
+				{
+					highDot = dot;
+					highIndex = i;
+				}
+		}
+
+	for (int c = 0; c < 4; c++)
+		{
+			low[c] = block[lowIndex][c];
+			high[c] = block[highIndex][c];
+		}
+}
+
+static uint16_t packRGB565(const int colour[4])
+{
+	return (uint16_t)(((colour[0] * 31 + 127) / 255) << 11 | ((colour[1] * 63 + 127) / 255) << 5 | ((colour[2] * 31 + 127) / 255));
+}
+
+static void unpackRGB565(uint16_t packed, int colour[3])
+{
+	int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+	colour[0] = (r << 3) | (r >> 2);
+	colour[1] = (g << 2) | (g >> 4);
+	colour[2] = (b << 3) | (b >> 2);
+}
+
+static int distanceRGB(const unsigned char *pixel, const int colour[3])
+{
+	int dr = pixel[0] - colour[0], dg = pixel[1] - colour[1], db = pixel[2] - colour[2];
+	return dr * dr + dg * dg + db * db;
+}
+
+/* BC1 colour block in 4 colour mode, also the colour half of BC3 */
+static void encodeColourBlock(const unsigned char block[16][4], unsigned char out[8])
+{
+	int low[4], high[4];
+	findEndpoints(block, 3, low, high);
+	uint16_t colour0 = packRGB565(high), colour1 = packRGB565(low);
+	if (colour0 < colour1)
+		{
+			uint16_t swap = colour0;
+			colour0 = colour1;
+			colour1 = swap;
+		}
+
+	uint32_t indices = 0;
+	if (colour0 != colour1)
+		{
+			int palette[4][3];
+			unpackRGB565(colour0, palette[0]);
+			unpackRGB565(colour1, palette[1]);
+			for (int c = 0; c < 3; c++)
+				{
+					palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+					palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+				}
+			for (int i = 0; i < 16; i++)
+				{
+					int best = 0, bestDistance = distanceRGB(block[i], palette[0]);
+					for (int p = 1; p < 4; p++)
+						{
+							int distance = distanceRGB(block[i], palette[p]);
+							if (distance < bestDistance)
+								{
+									bestDistance = distance;
+									best = p;
+								}
+						}
+					indices |= (uint32_t)best << (2 * i);
+				}
+		}
+
+	out[0] = colour0 & 0xFF;
+	out[1] = colour0 >> 8;
+	out[2] = colour1 & 0xFF;
+	out[3] = colour1 >> 8;
+	for (int i = 0; i < 4; i++)
+		out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+/* BC3 alpha half in 8 value mode */
+static void encodeAlphaBlock(const unsigned char block[16][4], unsigned char out[8])
+{
+	int alpha0 = 0, alpha1 = 255;
+	for (int i = 0; i < 16; i++)
+		{
+			alpha0 = block[i][3] > alpha0 ? block[i][3] : alpha0;
+			alpha1 = block[i][3] < alpha1 ? block[i][3] : alpha1;
+		}
+
+	uint64_t indices = 0;
+	if (alpha0 != alpha1)
+		{
+			int palette[8];
+			palette[0] = alpha0;
+			palette[1] = alpha1;
+			for (int p = 1; p < 7; p++)
+				palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+			for (int i = 0; i < 16; i++)
+				{
+					int best = 0, bestDistance = 256;
+					for (int p = 0; p < 8; p++)
+						{
+							int distance = block[i][3] > palette[p] ? block[i][3] - palette[p] : palette[p] - block[i][3];
+							if (distance < bestDistance)
+								{
+									bestDistance = distance;
+									best = p;
+								}
+						}
+					indices |= (uint64_t)best << (3 * i);
+				}
+		}
+
+	out[0] = (unsigned char)alpha0;
+	out[1] = (unsigned char)alpha1;
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+/* Writes bits into a 128 bit BC7 block, least significant bit first */
+struct BitWriter
+{
+	unsigned char *bytes;
+	int position;
+
+	void put(uint32_t value, int count)
+		{
+			for (int i = 0; i < count; i++, position++)
+				if (value & (1u << i))
+					bytes[position / 8] |= (unsigned char)(1 << (position % 8));
+		}
+};
+
+/* BC7 mode 6: one subset, RGBA 7 bit endpoints with a p bit each, 4 bit indices */
+static void encodeBC7Block(const unsigned char block[16][4], unsigned char out[16])
+{
+	static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	int endpoint[2][4];
+	findEndpoints(block, 4, endpoint[0], endpoint[1]);
+
+	/* Quantize each endpoint to 7 bits plus the p bit that loses the least */
+	int quantized[2][4], pbit[2];
+	for (int e = 0; e < 2; e++)
+		{
+			int bestError = 0x7FFFFFFF;
+			for (int p = 0; p < 2; p++)
+				{
+					int values[4], error = 0;
+					for (int c = 0; c < 4; c++)
+						{
+							values[c] = clampInt((endpoint[e][c] - p + 1) / 2, 0, 127);
+							int restored = (values[c] << 1) | p;
+							error += (restored - endpoint[e][c]) * (restored - endpoint[e][c]);
+						}
+					if (error < bestError)
+						{
+							bestError = error;
+							pbit[e] = p;
+							memcpy(quantized[e], values, sizeof(values));
+						}
+				}
+		}
+
+	int palette[16][4];
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 4; c++)
+			{
+				int e0 = (quantized[0][c] << 1) | pbit[0], e1 = (quantized[1][c] << 1) | pbit[1];
+				palette[i][c] = ((64 - weights[i]) * e0 + weights[i] * e1 + 32) >> 6;
+			}
+
+	int indices[16];
+	for (int i = 0; i < 16; i++)
+		{
+			int best = 0, bestDistance = 0x7FFFFFFF;
+			for (int p = 0; p < 16; p++)
+				{
+					int distance = 0;
+					for (int c = 0; c < 4; c++)
+						distance += (block[i][c] - palette[p][c]) * (block[i][c] - palette[p][c]);
+					if (distance < bestDistance)
+						{
+							bestDistance = distance;
+							best = p;
+						}
+				}
+			indices[i] = best;
+		}
+
+	/* The first index is stored with 3 bits, so its top bit has to be 0: swap the endpoints if it is not */
+	if (indices[0] & 8)
+		{
+			for (int c = 0; c < 4; c++)
+				{
+					int swap = quantized[0][c];
+					quantized[0][c] = quantized[1][c];
+					quantized[1][c] = swap;
+				}
+			int swap = pbit[0];
+			pbit[0] = pbit[1];
+			pbit[1] = swap;
+			for (int i = 0; i < 16; i++)
+				indices[i] = 15 - indices[i];
+		}
+
+	memset(out, 0, 16);
+	BitWriter writer = { out, 0 };
+	writer.put(1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+		{
+			writer.put(quantized[0][c], 7);
+			writer.put(quantized[1][c], 7);
+		}
+	writer.put(pbit[0], 1);
+	writer.put(pbit[1], 1);
+	writer.put(indices[0], 3);
+	for (int i = 1; i < 16; i++)
+		writer.put(indices[i], 4);
+}
+
+static std::vector<unsigned char> compressLevel(const Image &image, uint32_t vkFormat)
+{
+	int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+	uint32_t blockBytes = ktx2BlockBytes(vkFormat);
+	std::vector<unsigned char> out((size_t)blocksX * blocksY * blockBytes);
+
+	unsigned char block[16][4];
+	for (int by = 0; by < blocksY; by++)
+		for (int bx = 0; bx < blocksX; bx++)
+			{
+				fetchBlock(image, bx, by, block);
+				unsigned char *target = &out[((size_t)by * blocksX + bx) * blockBytes];
+				if (vkFormat == KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK)
+					encodeColourBlock(block, target);
+				else if (vkFormat == KTX2_VK_FORMAT_BC3_UNORM_BLOCK)
+					{
+						encodeAlphaBlock(block, target);
+						encodeColourBlock(block, target + 8);
+					}
+				else
+					encodeBC7Block(block, target);
+			}
+
+	return out;
+}
+
+static std::string outputPath(const std::string &input, const std::string &directory)
+{
+	std::string name = input;
+	size_t dot = name.find_last_of('.');
+	size_t slash = name.find_last_of('/');
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+		name = name.substr(0, dot);
+	name += ".ktx2";
+
+	if (directory.empty())
+		return name;
+	if (slash != std::string::npos)
+		name = name.substr(slash + 1);
+	return directory + "/" + name;
+}
+
+static bool bake(const std::string &input, const std::string &output, bool useBC7)
+{
+	Image image;
+	int components = 0;
+	unsigned char *data = stbi_load(input.c_str(), &image.width, &image.height, &components, 4);
+	if (data == NULL)
+		{
+			std::cout << "baker: can not read " << input << ": " << stbi_failure_reason() << std::endl;
+			return false;
+		}
+	image.pixels.assign(data, data + (size_t)image.width * image.height * 4);
+	stbi_image_free(data);
+
+	bool hasAlpha = false;
+	for (size_t i = 3; i < image.pixels.size(); i += 4)
+		if (image.pixels[i] != 255)
+			{
+				hasAlpha = true;
+				break;
+			}
+
+	uint32_t vkFormat = useBC7 ? KTX2_VK_FORMAT_BC7_UNORM_BLOCK
+		: (hasAlpha ? KTX2_VK_FORMAT_BC3_UNORM_BLOCK : KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK);
+
+	uint32_t width = image.width, height = image.height;
+	size_t decodedBytes = image.pixels.size();
+
+	/* Mip chain down to 1x1, each level box filtered from the one above */
+	std::vector<std::vector<unsigned char> > levels;
+	for (;;)
+		{
+			levels.push_back(compressLevel(image, vkFormat));
+			if (image.width == 1 && image.height == 1)
+				break;
+			image = downsample(image);
+		}
+
+	std::vector<unsigned char> file = buildKtx2(vkFormat, width, height, levels);
+	FILE *handle = fopen(output.c_str(), "wb");
+	if (handle == NULL)
+		{
+			std::cout << "baker: can not write " << output << std::endl;
+			return false;
+		}
+	bool written = fwrite(&file[0], 1, file.size(), handle) == file.size();
+	written = (fclose(handle) == 0) && written;
+	if (!written)
+		{
+			std::cout << "baker: can not write " << output << std::endl;
+			remove(output.c_str());
+			return false;
+		}
+
+	const char *formatName = vkFormat == KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK ? "BC1" : (vkFormat == KTX2_VK_FORMAT_BC3_UNORM_BLOCK ? "BC3" : "BC7");
+	std::cout << input << " -> " << output << ": " << width << "x" << height << " " << formatName << ", " << levels.size() << " levels, "
+		<< file.size() / 1024 << " KB (RGBA8 with mips " << decodedBytes * 4 / 3 / 1024 << " KB)" << std::endl;
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	bool useBC7 = false;
+	std::string directory;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; i++)
+		{
+			if (strcmp(argv[i], "--bc7") == 0)
+				useBC7 = true;
+			else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+				directory = argv[++i];
+			else
+				inputs.push_back(argv[i]);
+		}
+
+	if (inputs.empty())
+		{
+			std::cout << "usage: baker [--bc7] [-o output_dir] image..." << std::endl;
+			return 1;
+		}
+
+	/* The app flips every image on load, the baked data has to come out the same way up */
+	stbi_set_flip_vertically_on_load(true);
+
+	int failures = 0;
+	for (size_t i = 0; i < inputs.size(); i++)
+		if (!bake(inputs[i], outputPath(inputs[i], directory), useBC7))
+			failures++;
+
+	return failures == 0 ? 0 : 1;
+}
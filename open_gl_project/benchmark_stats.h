@@ -0,0 +1,166 @@
+#ifndef BENCHMARK_STATS_H
+#define BENCHMARK_STATS_H
+
+#include "glad.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+/* Frames a GPU timestamp is read after, by then the GPU is done with it and reading never waits */
+#define BENCHMARK_QUERY_FRAMES 4
+
+/* Average, median, tail and worst of a series of frame times, in milliseconds */
+struct FrameTimeSummary
+{
+	double avg;
+	double p50;
+	double p95;
+	double p99;
+	double max;
+};
+
+/* CPU and GPU time of every benchmarked frame. The CPU side is the wall time from beginFrame() to
+	endFrame(), the GPU side the difference of two GL_TIMESTAMP queries written at the same points, read
+	back BENCHMARK_QUERY_FRAMES frames later. Timestamps rather than GL_TIME_ELAPSED, so finer grained
+	queries can run inside a frame at the same time */
+class BenchmarkStats
+{
+public:
+	std::vector<double> cpuMilliseconds;
+	std::vector<double> gpuMilliseconds;
+
+	BenchmarkStats() : frames(0)
+		{
+			glGenQueries(2 * BENCHMARK_QUERY_FRAMES, queries);
+		}
+
+	void beginFrame()
+		{
+			/* The slot this frame reuses was written BENCHMARK_QUERY_FRAMES frames ago */
+			if (frames >= BENCHMARK_QUERY_FRAMES)
+				readBack(frames - BENCHMARK_QUERY_FRAMES);
+			glQueryCounter(queries[2 * slot(frames)], GL_TIMESTAMP);
+			cpuStart = std::chrono::steady_clock::now();
+		}
+
+	void endFrame()
+		{
+			glQueryCounter(queries[2 * slot(frames) + 1], GL_TIMESTAMP);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - cpuStart;
+			cpuMilliseconds.push_back(elapsed.count());
+			frames++;
+		}
+
+	/* Wait for the frames still on the GPU, after the last endFrame() */
+	void finish()
+		{
+			for (size_t frame = gpuMilliseconds.size(); frame < frames; frame++)
+				readBack(frame);
+		}
+
+	/* Nearest rank percentiles */
+	static FrameTimeSummary summarize(std::vector<double> times)
+		{
+			FrameTimeSummary summary = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+			if (times.empty())
+				return summary;
+			std::sort(times.begin(), times.end());
+			double total = 0.0;
+			for (size_t i = 0; i < times.size(); i++)
+				total += times[i];
+			summary.avg = total / times.size();
+			summary.p50 = percentile(times, 50.0);
+			summary.p95 = percentile(times, 95.0);
+			summary.p99 = percentile(times, 99.0);
+			summary.max = times.back();
+			return summary;
+		}
+
+	void print() const
+		{
+			FrameTimeSummary cpu = summarize(cpuMilliseconds);
+			FrameTimeSummary gpu = summarize(gpuMilliseconds);
+			std::cout << "Benchmark: " << frames << " frames, CPU avg " << cpu.avg << " p50 " << cpu.p50 << " p95 " << cpu.p95
+				<< " p99 " << cpu.p99 << " max " << cpu.max << " ms, GPU avg " << gpu.avg << " p50 " << gpu.p50 << " p95 " << gpu.p95
+				<< " p99 " << gpu.p99 << " max " << gpu.max << " ms" << std::endl;
+		}
+
+	/* A quoted JSON string, only quotes and backslashes are escaped like CpuProfiler::writeString does */
+	static std::string jsonString(const char *text)
+		{
+			std::string quoted = "\"";
+			for (; *text != '\0'; text++)
+				{
+					if (*text == '"' || *text == '\\')
+						quoted += '\\';
+					quoted += *text;
+				}
+			quoted += '"';
+			return quoted;
+		}
+
+	/* The summaries and the per frame times, with whatever describes the run as "settings", a JSON object body */
+	bool writeJSON(const char *path, const std::string &settings) const
+		{
+			FILE *file = fopen(path, "w");
+			if (file == NULL)
+				{
+					std::cout << "Benchmark: can not write " << path << std::endl;
+					return false;
+				}
+			fprintf(file, "{\n\t\"settings\": {%s},\n\t\"frames\": %u,\n", settings.c_str(), (unsigned int)frames);
+			writeSummary(file, "cpu_ms", summarize(cpuMilliseconds));
+			writeSummary(file, "gpu_ms", summarize(gpuMilliseconds));
+			writeSeries(file, "cpu_frame_ms", cpuMilliseconds, ",");
+			writeSeries(file, "gpu_frame_ms", gpuMilliseconds, "");
+			fprintf(file, "}\n");
+			fclose(file);
+			std::cout << "Benchmark: results written to " << path << std::endl;
+			return true;
+		}
+
+private:
+	/* Start and end timestamp of every slot */
+	unsigned int queries[2 * BENCHMARK_QUERY_FRAMES];
+	size_t frames;
+	std::chrono::steady_clock::time_point cpuStart;
+
+	static size_t slot(size_t frame)
+		{
+			return frame % BENCHMARK_QUERY_FRAMES;
+		}
+
+	void readBack(size_t frame)
+		{
+			GLuint64 start, end;
+			glGetQueryObjectui64v(queries[2 * slot(frame)], GL_QUERY_RESULT, &start);
+			glGetQueryObjectui64v(queries[2 * slot(frame) + 1], GL_QUERY_RESULT, &end);
+			gpuMilliseconds.push_back((end - start) / 1.0e6);
+		}
+
+	static double percentile(const std::vector<double> &sorted, double percent)
+		{
+			size_t rank = (size_t)ceil(percent / 100.0 * sorted.size());
+			return sorted[rank > 0 ? rank - 1 : 0];
+		}
+
+	static void writeSummary(FILE *file, const char *name, const FrameTimeSummary &summary)
+		{
+			fprintf(file, "\t\"%s\": {\"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+				name, summary.avg, summary.p50, summary.p95, summary.p99, summary.max);
+		}
+
+	static void writeSeries(FILE *file, const char *name, const std::vector<double> &times, const char *separator)
+		{
+			fprintf(file, "\t\"%s\": [", name);
+			for (size_t i = 0; i < times.size(); i++)
+				fprintf(file, i == 0 ? "%.4f" : ", %.4f", times[i]);
+			fprintf(file, "]%s\n", separator);
+		}
+};
+#endif
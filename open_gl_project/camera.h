@@ -113,6 +113,15 @@ class Camera
             Zoom = 45.0f;
     	}
 
+    // Places the camera directly, for movement that does not come from input such as a scripted path
+    void SetPose(glm::vec3 position, float yaw, float pitch)
+    	{
+        Position = position;
+        Yaw = yaw;
+        Pitch = pitch;
+        updateCameraVectors();
+    	}
+
 private:
     // Calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors()
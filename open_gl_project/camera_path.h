@@ -0,0 +1,108 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <glm/glm.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <iostream>
+
+#include "camera.h"
+
+/* A pose the path passes through */
+struct CameraKey
+{
+	glm::vec3 position;
+	float yaw;
+	float pitch;
+};
+
+/* A scripted camera flight for benchmarks: a Catmull-Rom spline through the keys of a file, so the
+	camera moves smoothly and exactly the same way on every run, whatever the frame rate */
+class CameraPath
+{
+public:
+	std::vector<CameraKey> keys;
+
+	/* "key <position x y z> <yaw> <pitch>" one per line, # starts a comment. Needs at least two keys */
+	bool load(const char *path)
+		{
+			FILE *file = fopen(path, "r");
+			if (file == NULL)
+				{
+					std::cout << "Camera path: can not open " << path << std::endl;
+					return false;
+				}
+
+			keys.clear();
+			char line[512];
+			int lineNumber = 0;
+			bool valid = true;
+			while (valid && fgets(line, sizeof(line), file) != NULL)
+				{
+					lineNumber++;
+					char *comment = strchr(line, '#');
+					if (comment != NULL)
+						*comment = '\0';
+
+					char keyword[32];
+					CameraKey key;
+					if (sscanf(line, "%31s", keyword) != 1)
+						continue;
+
+					if (strcmp(keyword, "key") == 0 && sscanf(line, "%*s %f %f %f %f %f", &key.position.x, &key.position.y, &key.position.z, &key.yaw, &key.pitch) == 5)
+						keys.push_back(key);
+					else
+						{
+							std::cout << "Camera path " << path << ":" << lineNumber << ": can not parse " << line << std::endl;
+							valid = false;
+						}
+				}
+			fclose(file);
+
+			if (valid && keys.size() < 2)
+				{
+					std::cout << "Camera path " << path << ": needs at least two keys" << std::endl;
+					valid = false;
+				}
+			return valid;
+		}
+
+	/* The pose at t, 0 is the first key and 1 the last, every key to key span taking the same share */
+	CameraKey sample(float t) const
+		{
+			float spans = (float)(keys.size() - 1);
+			float position = glm::clamp(t, 0.0f, 1.0f) * spans;
+			int span = glm::min((int)position, (int)keys.size() - 2);
+			float local = position - span;
+
+			/* The ends are repeated so the curve still starts and stops on the first and last key */
+			const CameraKey &k0 = keys[span > 0 ? span - 1 : 0];
+			const CameraKey &k1 = keys[span];
+			const CameraKey &k2 = keys[span + 1];
+			const CameraKey &k3 = keys[span + 2 < (int)keys.size() ? span + 2 : span + 1];
+
+			CameraKey key;
+			key.position = catmullRom(k0.position, k1.position, k2.position, k3.position, local);
+			key.yaw = catmullRom(glm::vec3(k0.yaw), glm::vec3(k1.yaw), glm::vec3(k2.yaw), glm::vec3(k3.yaw), local).x;
+			key.pitch = glm::clamp(catmullRom(glm::vec3(k0.pitch), glm::vec3(k1.pitch), glm::vec3(k2.pitch), glm::vec3(k3.pitch), local).x, -89.0f, 89.0f);
+			return key;
+		}
+
+	void apply(Camera &camera, float t) const
+		{
+			CameraKey key = sample(t);
+			camera.SetPose(key.position, key.yaw, key.pitch);
+		}
+
+private:
+	/* Uniform Catmull-Rom between p1 and p2 */
+	static glm::vec3 catmullRom(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float t)
+		{
+			float t2 = t * t;
+			float t3 = t2 * t;
+			return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+		}
+};
+#endif
@@ -1,5 +1,5 @@
 #version 460 core
-#define NR_POINT_LIGHTS 5
+/* CLUSTER_GRID_X/Y/Z and CLUSTER_MAX_LIGHTS come from ClusteredLights::defines() */
 
 out vec4 FragColor;
 
@@ -16,29 +16,80 @@ struct DirLight {
     vec3 diffuse;
     vec3 specular;
 };
-struct PointLight {
+struct PointLight 
+	{
+    /* ordered so that each float fills the 4th component of a vec3 in std140 */
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-	
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
-};
+    float radius;
+	};
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
+flat in uint ObjectLightFirst;
+flat in uint ObjectLightCount;
 
-uniform vec3 viewPos;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
 uniform Material material;
-uniform DirLight dirLight;
+
+/* lights of this surface, uploaded once to the light uniform buffer */
+layout (std140, binding = 3) uniform Lights
+{
+	DirLight dirLight;
+	/* the shared point lights are scaled by this for this surface */
+	vec3 pointLightTint;
+};
+
+/* every point light of the scene, in the buffer ClusteredLights fills */
+layout (std430, binding = 3) readonly buffer PointLights
+{
+	PointLight pointLights[];
+};
+
+/* the lights reaching each cluster, listed by cluster_assign.comp */
+struct Cluster
+{
+	uint count;
+	uint lights[CLUSTER_MAX_LIGHTS];
+};
+
+layout (std430, binding = 4) readonly buffer Clusters
+{
+	Cluster clusters[];
+};
+
+/* the lights reaching each drawn segment, listed by LightCuller */
+layout (std430, binding = 7) readonly buffer ObjectLightIndices
+{
+	uint objectLights[];
+};
+
+layout (std140, binding = 4) uniform ClusterGrid
+{
+	mat4 inverseProjection;
+	vec2 tileSize;
+	float sliceScale;
+	float sliceBias;
+	float zNear;
+	float zFar;
+	uint lightCount;
+};
 
 // function prototypes
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+uint ClusterIndex(vec3 fragPos);
 
 void main()
 {
@@ -48,9 +99,19 @@ void main()
 	vec3 viewDir = normalize(viewPos - FragPos);	
 	vec3 result = CalcDirLight(dirLight, norm, viewDir);
 
-	/* phase 2: point lights */
-	for(int i = 0; i < NR_POINT_LIGHTS; i++)
-			result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+	/* phase 2: the point lights listed for this fragment's cluster, or for its segment when that list is shorter.
+			Every light reaching the fragment is in both, in the same order */
+	uint cluster = ClusterIndex(FragPos);
+	if (ObjectLightCount < clusters[cluster].count)
+		{
+			for(uint i = 0; i < ObjectLightCount; i++)
+					result += CalcPointLight(pointLights[objectLights[ObjectLightFirst + i]], norm, FragPos, viewDir);
+		}
+	else
+		{
+			for(uint i = 0; i < clusters[cluster].count; i++)
+					result += CalcPointLight(pointLights[clusters[cluster].lights[i]], norm, FragPos, viewDir);
+		}
 	
 	FragColor = vec4(result, 1.0);
 		
@@ -120,15 +181,26 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 
     /* attenuation */
     float distance = length(light.position - fragPos);
+    /* the cluster or segment may reach further than the light, past its radius it adds nothing visible */
+    if (distance > light.radius)
+        return vec3(0.0);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
 
     /* combine results */
-    vec3 ambient = light.ambient * vec3(texture(material.diffuseMap_celling, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuseMap_celling, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specularMap_celling, TexCoords));
+    vec3 ambient = light.ambient * pointLightTint * vec3(texture(material.diffuseMap_celling, TexCoords));
+    vec3 diffuse = light.diffuse * pointLightTint * diff * vec3(texture(material.diffuseMap_celling, TexCoords));
+    vec3 specular = light.specular * pointLightTint * spec * vec3(texture(material.specularMap_celling, TexCoords));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
 
     return (ambient + diffuse + specular);
 }
+/* the cluster holding a fragment: its tile on screen and the depth slice of its view space distance */
+uint ClusterIndex(vec3 fragPos)
+{
+    float viewZ = (view * vec4(fragPos, 1.0)).z;
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / tileSize), uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+    uint slice = uint(clamp(log(-viewZ) * sliceScale + sliceBias, 0.0, float(CLUSTER_GRID_Z - 1)));
+    return tile.x + tile.y * CLUSTER_GRID_X + slice * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+}
@@ -0,0 +1,120 @@
+#ifndef CLUSTERED_LIGHTS_H
+#define CLUSTERED_LIGHTS_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+
+#include "shader_s.h"
+#include "uniform_buffer.h"
+#include "cpu_profiler.h"
+
+/* Clusters across, down and in depth. The depth slices grow exponentially from the near to the far plane */
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+/* Lights one cluster keeps, any more touching it are dropped */
+#define CLUSTER_MAX_LIGHTS 128
+/* Storage buffer binding points, the same numbers as layout(binding = N) in cluster_assign.comp and the corridor shaders */
+#define CLUSTER_LIGHTS_BINDING 3
+#define CLUSTER_LISTS_BINDING 4
+
+/* Clustered forward lighting. The point lights live in a storage buffer, cluster_assign.comp splits the
+	view volume into a CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z grid and lists, for every cluster, the
+	lights whose radius reaches it. A fragment works out its cluster from its pixel and view depth and only
+	shades the lights listed there, so its cost depends on the lights near it and not on how many there are */
+class ClusteredLights
+{
+public:
+	ClusteredLights(Shader &assignProgram) : assignProgram(assignProgram), lightBuffer(0), lightCount(0), gridUBO(sizeof(ClusterGridBlock))
+		{
+			glGenBuffers(1, &listBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, listBuffer);
+			glBufferStorage(GL_SHADER_STORAGE_BUFFER, listBytes(), NULL, 0);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+			memset(&grid, 0, sizeof(grid));
+			gridUBO.bind(CLUSTER_GRID_UBO_BINDING);
+		}
+
+	/* The grid size for ShaderCache::get(), every program reading the clusters is built with it */
+	static std::string defines()
+		{
+			return "#define CLUSTER_GRID_X " + std::to_string(CLUSTER_GRID_X) + "\n"
+				+ "#define CLUSTER_GRID_Y " + std::to_string(CLUSTER_GRID_Y) + "\n"
+				+ "#define CLUSTER_GRID_Z " + std::to_string(CLUSTER_GRID_Z) + "\n"
+				+ "#define CLUSTER_MAX_LIGHTS " + std::to_string(CLUSTER_MAX_LIGHTS) + "\n";
+		}
+
+	/* Replace every light, the radius of each has to be set already */
+	void setLights(const PointLightBlock *lights, unsigned int count)
+		{
+			if (lightBuffer == 0)
+				glGenBuffers(1, &lightBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, count > 0 ? count * sizeof(PointLightBlock) : sizeof(PointLightBlock), lights, GL_STATIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			lightCount = count;
+		}
+
+	/* The grid follows the projection and the window, activeCount is how many indices the visible light list
+		bound at LIGHT_ACTIVE_BINDING holds. The uniform block is only written when any of them changed */
+	void update(const glm::mat4 &projection, float zNear, float zFar, int width, int height, unsigned int activeCount)
+		{
+			CPU_PROFILE_SCOPE("ClusteredLights::update");
+			ClusterGridBlock next;
+			memset(&next, 0, sizeof(next));
+			next.inverseProjection = glm::inverse(projection);
+			next.tileSize = glm::vec2((float)width / CLUSTER_GRID_X, (float)height / CLUSTER_GRID_Y);
+			next.sliceScale = CLUSTER_GRID_Z / logf(zFar / zNear);
+			next.sliceBias = -CLUSTER_GRID_Z * logf(zNear) / logf(zFar / zNear);
+			next.zNear = zNear;
+			next.zFar = zFar;
+			next.lightCount = activeCount;
+			if (memcmp(&next, &grid, sizeof(grid)) == 0)
+				return;
+			grid = next;
+			gridUBO.update(0, sizeof(grid), &grid);
+		}
+
+	/* Rebuild the light list of every cluster for this frame's view out of the visible lights, before the lit draws */
+	void assign()
+		{
+			assignProgram.use();
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LIGHTS_BINDING, lightBuffer);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_LISTS_BINDING, listBuffer);
+			/* One work group per depth slice, one invocation per cluster of it */
+			glDispatchCompute(CLUSTER_GRID_Z, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+		}
+
+	unsigned int size() const
+		{
+			return lightCount;
+		}
+
+	void printStats() const
+		{
+			std::cout << "Clustered lights: " << lightCount << " point lights, " << CLUSTER_GRID_X << "x" << CLUSTER_GRID_Y << "x" << CLUSTER_GRID_Z
+				<< " clusters of up to " << CLUSTER_MAX_LIGHTS << " lights, " << listBytes() / 1024 << " KB of lists" << std::endl;
+		}
+
+private:
+	Shader &assignProgram;
+	unsigned int lightBuffer;
+	unsigned int listBuffer;
+	unsigned int lightCount;
+	UniformBuffer gridUBO;
+	ClusterGridBlock grid;
+
+	/* A count followed by CLUSTER_MAX_LIGHTS indices per cluster */
+	static GLsizeiptr listBytes()
+		{
+			return (GLsizeiptr)CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z * (1 + CLUSTER_MAX_LIGHTS) * sizeof(GLuint);
+		}
+};
+#endif
@@ -0,0 +1,257 @@
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+/* Built in unless NDEBUG is defined, "make release" leaves it out and every marker below expands to nothing */
+#ifndef NDEBUG
+#define CPU_PROFILING
+#endif
+
+#ifdef CPU_PROFILING
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <iostream>
+
+/* Scopes one thread can record in a capture, any more are counted and dropped */
+#define CPU_PROFILER_THREAD_EVENTS 32768
+
+/* One finished scope, times in nanoseconds since the profiler started */
+struct CpuProfileEvent
+{
+	/* Has to outlive the capture, markers only take string literals */
+	const char *name;
+	int64_t start;
+	int64_t duration;
+};
+
+/* The events of one thread. Only the thread itself writes them, count is published with a release store
+	after every event so the thread writing the trace reads whole events without a lock */
+struct CpuProfileThread
+{
+	unsigned int id;
+	std::atomic<const char *> name;
+	std::atomic<unsigned int> count;
+	unsigned int dropped;
+	CpuProfileEvent events[CPU_PROFILER_THREAD_EVENTS];
+};
+
+/* Hierarchical CPU scopes, written as a Chrome trace_event file (chrome://tracing or ui.perfetto.dev).
+	Scopes are only recorded between the first and last frame of a capture; outside of it a marker costs
+	one relaxed atomic load. A thread gets its buffer the first time it records, which is the only point
+	a mutex is taken, and buffers live until exit so the trace can be written after a thread has ended */
+class CpuProfiler
+{
+public:
+	static CpuProfiler &instance()
+		{
+			static CpuProfiler profiler;
+			return profiler;
+		}
+
+	/* Record frames first to last, both included, and write them to path once last has ended */
+	void capture(unsigned int first, unsigned int last, const char *path)
+		{
+			firstFrame = first;
+			lastFrame = last;
+			outputPath = path;
+			captured = true;
+			std::cout << "CPU profiler: tracing frames " << first << " to " << last << " into " << path << std::endl;
+		}
+
+	/* Call on the main thread before anything of the frame is recorded */
+	void beginFrame(unsigned int frame)
+		{
+			if (!captured)
+				return;
+			if (frame == firstFrame)
+				recording.store(true, std::memory_order_relaxed);
+			else if (frame == lastFrame + 1)
+				finish();
+		}
+
+	/* Write the trace now if the capture is still running, for loops that end before its last frame */
+	void finish()
+		{
+			if (!captured)
+				return;
+			recording.store(false, std::memory_order_relaxed);
+			captured = false;
+			writeTrace();
+		}
+
+	bool isRecording() const
+		{
+			return recording.load(std::memory_order_relaxed);
+		}
+
+	static int64_t now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - instance().start).count();
+		}
+
+	void record(const char *name, int64_t begin, int64_t end)
+		{
+			CpuProfileThread *thread = currentThread();
+			unsigned int index = thread->count.load(std::memory_order_relaxed);
+			if (index == CPU_PROFILER_THREAD_EVENTS)
+				{
+					thread->dropped++;
+					return;
+				}
+			thread->events[index].name = name;
+			thread->events[index].start = begin;
+			thread->events[index].duration = end - begin;
+			thread->count.store(index + 1, std::memory_order_release);
+		}
+
+	/* The name the calling thread has in the trace, a string literal */
+	static void nameThread(const char *name)
+		{
+			threadName() = name;
+			if (threadBuffer() != NULL)
+				threadBuffer()->name.store(name, std::memory_order_relaxed);
+		}
+
+private:
+	std::atomic<bool> recording;
+	bool captured;
+	unsigned int firstFrame;
+	unsigned int lastFrame;
+	const char *outputPath;
+	std::chrono::steady_clock::time_point start;
+	/* Only taken to add a thread and to write the trace */
+	std::mutex threadsMutex;
+	std::vector<CpuProfileThread *> threads;
+
+	CpuProfiler() : recording(false), captured(false), firstFrame(0), lastFrame(0), outputPath(NULL), start(std::chrono::steady_clock::now())
+		{
+		}
+
+	static const char *&threadName()
+		{
+			static thread_local const char *name = NULL;
+			return name;
+		}
+
+	static CpuProfileThread *&threadBuffer()
+		{
+			static thread_local CpuProfileThread *buffer = NULL;
+			return buffer;
+		}
+
+	CpuProfileThread *currentThread()
+		{
+			CpuProfileThread *&buffer = threadBuffer();
+			if (buffer == NULL)
+				{
+					buffer = new CpuProfileThread;
+					buffer->name.store(threadName() != NULL ? threadName() : "thread", std::memory_order_relaxed);
+					buffer->count.store(0, std::memory_order_relaxed);
+					buffer->dropped = 0;
+					std::lock_guard<std::mutex> lock(threadsMutex);
+					buffer->id = (unsigned int)threads.size() + 1;
+					threads.push_back(buffer);
+				}
+			return buffer;
+		}
+
+	/* Names come from the code, only quotes and backslashes need escaping */
+	static void writeString(FILE *file, const char *text)
+		{
+			fputc('"', file);
+			for (; *text != '\0'; text++)
+				{
+					if (*text == '"' || *text == '\\')
+						fputc('\\', file);
+					fputc(*text, file);
+				}
+			fputc('"', file);
+		}
+
+	/* Complete ("X") events with times in microseconds, and a name for every thread */
+	void writeTrace()
+		{
+			FILE *file = fopen(outputPath, "w");
+			if (file == NULL)
+				{
+					std::cout << "CPU profiler: can not write " << outputPath << std::endl;
+					return;
+				}
+
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			size_t events = 0;
+			unsigned int dropped = 0;
+			fprintf(file, "{\"traceEvents\": [\n");
+			for (size_t i = 0; i < threads.size(); i++)
+				{
+					CpuProfileThread *thread = threads[i];
+					fprintf(file, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": ", i == 0 ? "" : ",\n", thread->id);
+					writeString(file, thread->name.load(std::memory_order_relaxed));
+					fprintf(file, "}}");
+					unsigned int count = thread->count.load(std::memory_order_acquire);
+					for (unsigned int e = 0; e < count; e++)
+						{
+							const CpuProfileEvent &event = thread->events[e];
+							fprintf(file, ",\n{\"name\": ");
+							writeString(file, event.name);
+							fprintf(file, ", \"cat\": \"cpu\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+								event.start / 1000.0, event.duration / 1000.0, thread->id);
+						}
+					events += count;
+					dropped += thread->dropped;
+				}
+			fprintf(file, "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {\"first_frame\": %u, \"last_frame\": %u, \"dropped_events\": %u}}\n",
+				firstFrame, lastFrame, dropped);
+			fclose(file);
+			std::cout << "CPU profiler: " << events << " scopes on " << threads.size() << " threads written to " << outputPath;
+			if (dropped > 0)
+				std::cout << ", " << dropped << " dropped";
+			std::cout << std::endl;
+		}
+};
+
+/* Times the rest of the enclosing block */
+class CpuProfileScope
+{
+public:
+	explicit CpuProfileScope(const char *name) : name(name), start(CpuProfiler::instance().isRecording() ? CpuProfiler::now() : -1)
+		{
+		}
+
+	~CpuProfileScope()
+		{
+			if (start >= 0)
+				CpuProfiler::instance().record(name, start, CpuProfiler::now());
+		}
+
+private:
+	const char *name;
+	int64_t start;
+};
+
+#define CPU_PROFILE_CONCAT_LINE(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_LINE(a, b)
+#define CPU_PROFILE_SCOPE(name) CpuProfileScope CPU_PROFILE_CONCAT(cpuProfileScope, __LINE__)(name)
+#define CPU_PROFILE_FUNCTION() CPU_PROFILE_SCOPE(__func__)
+#define CPU_PROFILE_THREAD(name) CpuProfiler::nameThread(name)
+#define CPU_PROFILE_CAPTURE(first, last, path) CpuProfiler::instance().capture(first, last, path)
+#define CPU_PROFILE_FRAME(frame) CpuProfiler::instance().beginFrame(frame)
+#define CPU_PROFILE_FINISH() CpuProfiler::instance().finish()
+
+#else
+
+#include <iostream>
+
+#define CPU_PROFILE_SCOPE(name) ((void)0)
+#define CPU_PROFILE_FUNCTION() ((void)0)
+#define CPU_PROFILE_THREAD(name) ((void)0)
+#define CPU_PROFILE_CAPTURE(first, last, path) ((void)(first), (void)(last), (void)(path), std::cout << "CPU profiler: not in this build, nothing is traced" << std::endl)
+#define CPU_PROFILE_FRAME(frame) ((void)0)
+#define CPU_PROFILE_FINISH() ((void)0)
+
+#endif
+#endif
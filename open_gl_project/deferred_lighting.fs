@@ -0,0 +1,193 @@
+#version 460 core
+/* CLUSTER_GRID_X/Y/Z and CLUSTER_MAX_LIGHTS come from ClusteredLights::defines() */
+out vec4 FragColor;
+
+struct DirLight 
+	{
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+	};
+struct PointLight 
+	{
+    /* ordered so that each float fills the 4th component of a vec3 in std140 */
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+    float radius;
+	};
+
+/* the G-buffer written by gbuffer_corridor.fs, one texel per pixel */
+layout (binding = 0) uniform sampler2D gAlbedo;
+layout (binding = 1) uniform sampler2D gSpecular;
+layout (binding = 2) uniform sampler2D gNormal;
+layout (binding = 3) uniform sampler2D gDepth;
+
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
+
+/* the Lights blocks of the wall, floor and celling at bindings 1, 2 and 3, picked by the surface in gNormal.w */
+layout (std140, binding = 1) uniform Lights
+{
+	DirLight dirLight;
+	vec3 pointLightTint;
+} surfaces[3];
+
+/* every point light of the scene, in the buffer ClusteredLights fills */
+layout (std430, binding = 3) readonly buffer PointLights
+{
+	PointLight pointLights[];
+};
+
+/* the lights reaching each cluster, listed by cluster_assign.comp */
+struct Cluster
+{
+	uint count;
+	uint lights[CLUSTER_MAX_LIGHTS];
+};
+
+layout (std430, binding = 4) readonly buffer Clusters
+{
+	Cluster clusters[];
+};
+
+layout (std140, binding = 4) uniform ClusterGrid
+{
+	mat4 inverseProjection;
+	vec2 tileSize;
+	float sliceScale;
+	float sliceBias;
+	float zNear;
+	float zFar;
+	uint lightCount;
+};
+
+/* back from window depth to world space */
+uniform mat4 inverseViewProjection;
+
+/* what the corridor shaders get from their textures and uniforms, read back from the G-buffer */
+vec3 albedo;
+vec3 specularColour;
+float shininess;
+vec3 pointLightTint;
+
+// function prototypes
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+uint ClusterIndex(vec3 fragPos);
+
+/* the same lighting as wall_shader.fs, floor_shader.fs and celling_shader.fs, once per pixel instead of once per fragment drawn */
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(gDepth, pixel, 0).r;
+	/* nothing of the corridor here, the clear colour stays */
+	if (depth == 1.0)
+		discard;
+	gl_FragDepth = depth;
+
+	vec4 ndc = vec4(gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 world = inverseViewProjection * ndc;
+	vec3 fragPos = world.xyz / world.w;
+
+	vec4 normalSurface = texelFetch(gNormal, pixel, 0);
+	vec4 specularShininess = texelFetch(gSpecular, pixel, 0);
+	albedo = texelFetch(gAlbedo, pixel, 0).rgb;
+	specularColour = specularShininess.rgb;
+	shininess = specularShininess.a * 255.0;
+
+	/* block arrays may only be indexed with a constant here, the surface differs from pixel to pixel */
+	DirLight dirLight;
+	int surface = int(normalSurface.w + 0.5);
+	if (surface == 0)
+	{
+		dirLight = surfaces[0].dirLight;
+		pointLightTint = surfaces[0].pointLightTint;
+	}
+	else if (surface == 1)
+	{
+		dirLight = surfaces[1].dirLight;
+		pointLightTint = surfaces[1].pointLightTint;
+	}
+	else
+	{
+		dirLight = surfaces[2].dirLight;
+		pointLightTint = surfaces[2].pointLightTint;
+	}
+
+	/* properties */
+	vec3 norm = normalize(normalSurface.xyz);
+	vec3 viewDir = normalize(viewPos - fragPos);
+
+	/* phase 1: directional lighting */
+	vec3 result = CalcDirLight(dirLight, norm, viewDir);
+	/* phase 2: the point lights listed for this pixel's cluster */
+	uint cluster = ClusterIndex(fragPos);
+	for(uint i = 0; i < clusters[cluster].count; i++)
+			result += CalcPointLight(pointLights[clusters[cluster].lights[i]], norm, fragPos, viewDir);
+
+	FragColor = vec4(result, 1.0);
+}
+
+/* calculates the color when using a directional light. */
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+{
+    vec3 lightDir = normalize(-light.direction);
+    /* diffuse shading */
+    float diff = max(dot(normal, lightDir), 0.0);
+    /* specular shading */
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    /* combine results */
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
+    vec3 specular = light.specular * spec * specularColour;
+    return (ambient + diffuse + specular);
+}
+// calculates the color when using a point light.
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    /* diffuse shading */
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    /* specular shading */
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+
+    /* attenuation */
+    float distance = length(light.position - fragPos);
+    /* the cluster may reach further than the light, past its radius it adds nothing visible */
+    if (distance > light.radius)
+        return vec3(0.0);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+
+    /* combine results */
+    vec3 ambient = light.ambient * pointLightTint * albedo;
+    vec3 diffuse = light.diffuse * pointLightTint * diff * albedo;
+    vec3 specular = light.specular * pointLightTint * spec * specularColour;
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+
+    return (ambient + diffuse + specular);
+}
+/* the cluster holding a fragment: its tile on screen and the depth slice of its view space distance */
+uint ClusterIndex(vec3 fragPos)
+{
+    float viewZ = (view * vec4(fragPos, 1.0)).z;
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / tileSize), uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+    uint slice = uint(clamp(log(-viewZ) * sliceScale + sliceBias, 0.0, float(CLUSTER_GRID_Z - 1)));
+    return tile.x + tile.y * CLUSTER_GRID_X + slice * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+}
@@ -0,0 +1,152 @@
+#ifndef DEFERRED_RENDERER_H
+#define DEFERRED_RENDERER_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+
+#include <iostream>
+
+#include "shader_s.h"
+
+/* Texture units of the G-buffer in the lighting pass, layout(binding = N) in deferred_lighting.fs */
+#define GBUFFER_ALBEDO_UNIT 0
+#define GBUFFER_SPECULAR_UNIT 1
+#define GBUFFER_NORMAL_UNIT 2
+#define GBUFFER_DEPTH_UNIT 3
+
+/* Surface index written to the G-buffer, selects the Lights block of the surface in the lighting pass */
+enum GBufferSurface
+{
+	GBUFFER_WALL = 0,
+	GBUFFER_FLOOR = 1,
+	GBUFFER_CELLING = 2
+};
+
+/* Deferred shading of the corridor surfaces.
+	The geometry pass draws walls, floor and celling with gbuffer_corridor.fs into an FBO holding albedo,
+	specular colour and shininess, normal and surface, and depth. The lighting pass then draws one
+	triangle over the window and runs deferred_lighting.fs once per pixel: the directional light of the
+	pixel's surface and the clustered point lights, whatever the overdraw of the geometry pass was. It also
+	writes the G-buffer depth, so the exhibits and lamps drawn forward afterwards are hidden correctly */
+class DeferredRenderer
+{
+public:
+	DeferredRenderer(Shader &geometryProgram, Shader &lightingProgram)
+		: geometryProgram(geometryProgram), lightingProgram(lightingProgram), framebuffer(0), width(0), height(0)
+		{
+			surfaceUniform = geometryProgram.uniform("surface");
+			inverseViewProjectionUniform = lightingProgram.uniform("inverseViewProjection");
+			geometryProgram.use();
+			geometryProgram.setInt("material.diffuseMap", 0);
+			geometryProgram.setInt("material.specularMap", 1);
+			geometryProgram.setFloat("material.shininess", 32.0f);
+
+			/* The lighting triangle comes from gl_VertexID, a core context still wants a vertex array bound */
+			glGenVertexArrays(1, &emptyVAO);
+		}
+
+	/* Match the size of the window, the targets are only made again when it changed */
+	void resize(int newWidth, int newHeight)
+		{
+			if (newWidth == width && newHeight == height)
+				return;
+			width = newWidth;
+			height = newHeight;
+
+			if (framebuffer != 0)
+				{
+					glDeleteFramebuffers(1, &framebuffer);
+					glDeleteTextures(4, textures);
+				}
+
+			glGenTextures(4, textures);
+			makeTarget(textures[GBUFFER_ALBEDO_UNIT], GL_RGBA8);
+			makeTarget(textures[GBUFFER_SPECULAR_UNIT], GL_RGBA8);
+			makeTarget(textures[GBUFFER_NORMAL_UNIT], GL_RGBA16F);
+			makeTarget(textures[GBUFFER_DEPTH_UNIT], GL_DEPTH_COMPONENT32F);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			GLint previousFramebuffer;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+			glGenFramebuffers(1, &framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			for (int i = 0; i < 3; i++)
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i], 0);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[GBUFFER_DEPTH_UNIT], 0);
+			GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+			glDrawBuffers(3, drawBuffers);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cout << "ERROR::DEFERRED::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+
+			/* 4 + 4 + 8 + 4 bytes per pixel */
+			std::cout << "Deferred shading: " << width << "x" << height << " G-buffer, "
+				<< (long)width * height * 20 / 1024 << " KB" << std::endl;
+		}
+
+	/* Draw the corridor surfaces with the program returned here until endGeometry(), after setSurface() */
+	Shader &beginGeometry()
+		{
+			glGetIntegerv(GL_VIEWPORT, viewport);
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glViewport(0, 0, width, height);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			geometryProgram.use();
+			return geometryProgram;
+		}
+
+	void setSurface(GBufferSurface surface)
+		{
+			geometryProgram.setInt(surfaceUniform, surface);
+		}
+
+	void endGeometry()
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+			glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		}
+
+	/* Light every pixel the geometry pass covered into the bound framebuffer, which must be the size of the G-buffer.
+		The clustered light buffers have to be bound already */
+	void light(const glm::mat4 &viewProjection)
+		{
+			lightingProgram.use();
+			lightingProgram.setMat4(inverseViewProjectionUniform, glm::inverse(viewProjection));
+			for (int i = 0; i < 4; i++)
+				{
+					glActiveTexture(GL_TEXTURE0 + i);
+					glBindTexture(GL_TEXTURE_2D, textures[i]);
+				}
+			/* Every pixel gets the G-buffer depth, whatever the depth buffer held */
+			glDepthFunc(GL_ALWAYS);
+			glBindVertexArray(emptyVAO);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+			glDepthFunc(GL_LESS);
+		}
+
+private:
+	Shader &geometryProgram;
+	Shader &lightingProgram;
+	GLint surfaceUniform;
+	GLint inverseViewProjectionUniform;
+
+	unsigned int framebuffer;
+	/* Indexed by the GBUFFER_*_UNIT the lighting pass samples them on */
+	unsigned int textures[4];
+	unsigned int emptyVAO;
+	int width;
+	int height;
+	/* The viewport and framebuffer, the window's or the headless one, the pass returns to */
+	GLint viewport[4];
+	GLint targetFramebuffer;
+
+	void makeTarget(unsigned int texture, GLenum format)
+		{
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexStorage2D(GL_TEXTURE_2D, 1, format, width, height);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+};
+#endif
@@ -0,0 +1,6 @@
+#version 460 core
+
+/* no colour attachment, only the depth written by the rasterizer is kept */
+void main()
+{
+}
@@ -0,0 +1,26 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+/* one matrix per corridor segment, and the segments drawn this frame; instance i is segment drawnSegments[i], see InstanceBuffer */
+layout (std430, binding = 8) readonly buffer SegmentModels
+{
+	mat4 segmentModels[];
+};
+layout (std430, binding = 9) readonly buffer DrawnSegments
+{
+	uint drawnSegments[];
+};
+
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
+
+/* position only, the occluders are drawn for their depth alone */
+void main()
+{
+    mat4 model = segmentModels[drawnSegments[gl_InstanceID]];
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
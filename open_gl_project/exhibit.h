@@ -0,0 +1,210 @@
+#ifndef EXHIBIT_H
+#define EXHIBIT_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <string.h>
+
+#include "shader_s.h"
+#include "geometry_manager.h"
+#include "stream_ring.h"
+#include "cpu_profiler.h"
+
+/* Most interactive exhibits cycle through 3 states, the panels show 1 text and the openGL logo */
+#define EXHIBIT_MAX_STATES 3
+#define EXHIBIT_MAX_TEXTURES 2
+
+/* Per object data of the indirect path, see indirect_renderer.h */
+struct IndirectObject;
+
+/* Geometry of an exhibit, a VAO plus what to pass to the draw call */
+struct Mesh
+{
+	unsigned int VAO;
+	/* Number of vertices, or of indices when indexed */
+	GLsizei count;
+	bool indexed;
+	/* Added to every index, or the first vertex drawn when not indexed */
+	GLint baseVertex;
+	GLuint firstIndex;
+	/* Bounding sphere around the local origin */
+	float radius;
+};
+
+/* A mesh kept by the geometry manager */
+inline Mesh makeMesh(const GeometryManager &geometry, const GeometryHandle &handle)
+{
+	Mesh mesh;
+	mesh.VAO = geometry.vertexArray(handle.format);
+	mesh.indexed = handle.indexCount > 0;
+	mesh.count = mesh.indexed ? handle.indexCount : handle.vertexCount;
+	mesh.baseVertex = handle.baseVertex;
+	mesh.firstIndex = handle.firstIndex;
+	mesh.radius = handle.radius;
+
+	return mesh;
+}
+
+/* A mesh whose vertices are streamed, see DynamicVertices. VAO comes from StreamRing::makeVertexArray() and
+	the vertices are bound at their offset for every draw, the handle only places the indices */
+inline Mesh makeStreamedMesh(unsigned int VAO, const GeometryHandle &handle)
+{
+	Mesh mesh;
+	mesh.VAO = VAO;
+	mesh.indexed = handle.indexCount > 0;
+	mesh.count = mesh.indexed ? handle.indexCount : handle.vertexCount;
+	mesh.baseVertex = 0;
+	mesh.firstIndex = handle.firstIndex;
+	mesh.radius = handle.radius;
+
+	return mesh;
+}
+
+/* Vertices that follow the interaction state, kept in a block reserved in every region of a StreamRing.
+	Each region remembers the state it holds, so after a change every region is written once, the first
+	time it comes around, and a state that stays put costs no writes at all */
+struct DynamicVertices
+{
+	StreamRing *ring;
+	GLintptr reservation;
+	GLsizei stride;
+	/* One array of size bytes per interaction state */
+	const float *states[EXHIBIT_MAX_STATES];
+	GLsizeiptr size;
+	/* State copied into each region, -1 before the first write */
+	int written[STREAM_RING_FRAMES];
+};
+
+/* Reserve the block, call before StreamRing::create(). The states are filled in by the caller */
+inline DynamicVertices makeDynamicVertices(StreamRing &ring, GLsizeiptr size, GLsizei stride)
+{
+	DynamicVertices vertices = {};
+	vertices.ring = &ring;
+	vertices.reservation = ring.reserve(size);
+	vertices.stride = stride;
+	vertices.size = size;
+	for (int region = 0; region < STREAM_RING_FRAMES; region++)
+		vertices.written[region] = -1;
+
+	return vertices;
+}
+
+/* Where the vertices of state are in this frame's region, copied there first if the region holds another state */
+inline GLintptr streamDynamicVertices(DynamicVertices &vertices, int state)
+{
+	int region = vertices.ring->currentRegion();
+	if (vertices.written[region] != state)
+		{
+			CPU_PROFILE_SCOPE("exhibit vertex copy");
+			memcpy(vertices.ring->reservedPointer(vertices.reservation), vertices.states[state], vertices.size);
+			vertices.written[region] = state;
+		}
+
+	return vertices.ring->reservedOffset(vertices.reservation);
+}
+
+/* One exhibit or explanation panel of the museum, everything the renderer needs to draw it */
+struct Exhibit
+{
+	/* Shown by the profilers */
+	const char *name;
+	Mesh mesh;
+	Shader *program;
+	/* Location of "model" in program, resolved when the exhibit is built */
+	GLint modelUniform;
+
+	/* Textures bound to units 0..textureCount-1, one set per interaction state */
+	unsigned int textures[EXHIBIT_MAX_STATES][EXHIBIT_MAX_TEXTURES];
+	int textureCount;
+
+	/* Vertices streamed per interaction state, NULL for meshes that never change */
+	DynamicVertices *vertices;
+
+	/* Transform: translate to position, rotate about the Y axis, then scale */
+	glm::vec3 position;
+	/* Angle in degrees */
+	float angle;
+	/* Animation, degrees per second added on top of angle */
+	float spin;
+	glm::vec3 scale;
+
+	/* Interaction state selected with the keyboard, NULL when the exhibit is not interactive */
+	const int *interaction;
+	/* Drawn as wireframe while this toggle is not 0 */
+	const int *wireframe;
+
+	/* Optional per exhibit uniforms that do not fit the fields above, called after program is in use */
+	void (*prepare)(const Exhibit &exhibit, int state, double time);
+	const void *prepareData;
+
+	/* The same exhibit for the IndirectRenderer: its mesh in the merged buffers for each interaction state,
+		-1 to always draw it through the RenderQueue, and which branch of exhibit_indirect.fs shades it */
+	int indirectMesh[EXHIBIT_MAX_STATES];
+	int indirectMaterial;
+	/* Optional, fills in what prepare sets as uniforms on the immediate path */
+	void (*prepareIndirect)(const Exhibit &exhibit, int state, double time, IndirectObject &object);
+};
+
+/* An exhibit with no textures, interaction or animation, the rest is filled in by the caller */
+inline Exhibit makeExhibit(const char *name, const Mesh &mesh, Shader &program, glm::vec3 position, float angle, float scale)
+{
+	Exhibit exhibit = {};
+	exhibit.name = name;
+	exhibit.mesh = mesh;
+	exhibit.program = &program;
+	exhibit.modelUniform = program.uniform("model");
+	exhibit.position = position;
+	exhibit.angle = angle;
+	exhibit.scale = glm::vec3(scale);
+	for (int state = 0; state < EXHIBIT_MAX_STATES; state++)
+		exhibit.indirectMesh[state] = -1;
+
+	return exhibit;
+}
+
+/* Let the IndirectRenderer draw the exhibit, with the same mesh in every interaction state */
+inline void setExhibitIndirect(Exhibit &exhibit, int mesh, int material)
+{
+	for (int state = 0; state < EXHIBIT_MAX_STATES; state++)
+		exhibit.indirectMesh[state] = mesh;
+	exhibit.indirectMaterial = material;
+}
+
+/* Set the textures of one interaction state, use state 0 for exhibits that do not change */
+inline void setExhibitTextures(Exhibit &exhibit, int state, unsigned int texture0, unsigned int texture1)
+{
+	exhibit.textures[state][0] = texture0;
+	exhibit.textures[state][1] = texture1;
+	exhibit.textureCount = 2;
+}
+
+inline int exhibitState(const Exhibit &exhibit)
+{
+	if (exhibit.interaction == NULL)
+		return 0;
+
+	return *exhibit.interaction;
+}
+
+/* Radius of a sphere at position that holds the exhibit in any rotation about its origin */
+inline float exhibitBoundingRadius(const Exhibit &exhibit)
+{
+	return exhibit.mesh.radius * glm::max(exhibit.scale.x, glm::max(exhibit.scale.y, exhibit.scale.z));
+}
+
+inline glm::mat4 exhibitModelMatrix(const Exhibit &exhibit, double time)
+{
+	glm::mat4 model = glm::mat4(1.0f);
+	/* Translate "move" the object in its place in the hallway */
+	model = glm::translate(model, exhibit.position);
+	/* Rotate the object to face the wall, spinning ones keep turning with time */
+	float angle = glm::radians(exhibit.angle) + glm::radians(exhibit.spin) * (float)time;
+	model = glm::rotate(model, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+	model = glm::scale(model, exhibit.scale);
+
+	return model;
+}
+
+#endif
@@ -20,7 +20,13 @@ in vec3 Normal;
 in vec3 FragPos;  
 
 /* the location of the light source */
-uniform vec3 viewPos;
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
 uniform Material material;
 uniform Light light;
 
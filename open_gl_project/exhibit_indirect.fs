@@ -0,0 +1,83 @@
+#version 460 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+in vec3 ourColor;
+flat in int objectIndex;
+
+/* has to match the IndirectMaterial enum of indirect_renderer.h */
+#define MATERIAL_VERTEX_COLOUR 0
+#define MATERIAL_TEXTURED 1
+#define MATERIAL_LIT 2
+#define MATERIAL_WHITE 3
+
+struct Object
+{
+	mat4 model;
+	vec4 lightPosition;
+	vec4 lightAmbient;
+	vec4 lightDiffuse;
+	vec4 lightSpecular;
+	vec4 materialAmbient;
+	vec4 materialDiffuse;
+	vec4 materialSpecular;
+	int material;
+	float radius;
+	int layer;
+};
+
+layout (std430, binding = 0) readonly buffer Objects
+{
+	Object objects[];
+};
+
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
+
+/* the textures of the batch as layers of one array, and the one mixed over all of them. The layer comes from
+	the object, it does not have to be dynamically uniform the way a sampler array index would */
+layout (binding = 0) uniform sampler2DArray layers;
+layout (binding = 1) uniform sampler2D overlay;
+
+void main()
+{
+	Object object = objects[objectIndex];
+
+	if (object.material == MATERIAL_VERTEX_COLOUR)
+		{
+			FragColor = vec4(ourColor, 1.0f);
+		}
+	else if (object.material == MATERIAL_TEXTURED)
+		{
+			// linearly interpolate between both textures (80% first, 20% second)
+			FragColor = mix(texture(layers, vec3(TexCoord, object.layer)), texture(overlay, TexCoord), 0.2);
+		}
+	else if (object.material == MATERIAL_LIT)
+		{
+			/* the same single light as exhibit_7_light_colour.fs */
+			vec3 ambient = object.lightAmbient.xyz * object.materialAmbient.xyz;
+
+			vec3 norm = normalize(Normal);
+			vec3 lightDir = normalize(object.lightPosition.xyz - FragPos);
+			float diff = max(dot(norm, lightDir), 0.0);
+			vec3 diffuse = object.lightDiffuse.xyz * (diff * object.materialDiffuse.xyz);
+
+			vec3 viewDir = normalize(viewPos - FragPos);
+			vec3 reflectDir = reflect(-lightDir, norm);
+			float spec = pow(max(dot(viewDir, reflectDir), 0.0), object.materialSpecular.w);
+			vec3 specular = object.lightSpecular.xyz * (spec * object.materialSpecular.xyz);
+
+			FragColor = vec4(ambient + diffuse + specular, 1.0);
+		}
+	else
+		{
+			FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+		}
+}
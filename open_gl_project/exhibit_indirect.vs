@@ -0,0 +1,53 @@
+#version 460 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec3 aColor;
+
+/* one record per exhibit of the batch, gl_DrawID is the index of the indirect command being drawn */
+struct Object
+{
+	mat4 model;
+	vec4 lightPosition;
+	vec4 lightAmbient;
+	vec4 lightDiffuse;
+	vec4 lightSpecular;
+	vec4 materialAmbient;
+	vec4 materialDiffuse;
+	vec4 materialSpecular;
+	int material;
+	float radius;
+	int layer;
+};
+
+layout (std430, binding = 0) readonly buffer Objects
+{
+	Object objects[];
+};
+
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+out vec3 ourColor;
+flat out int objectIndex;
+
+void main()
+{
+	mat4 model = objects[gl_DrawID].model;
+
+	FragPos = vec3(model * vec4(aPos, 1.0));
+	Normal = mat3(transpose(inverse(model))) * aNormal;
+	TexCoord = aTexCoord;
+	ourColor = aColor;
+	objectIndex = gl_DrawID;
+
+	gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,162 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include <stddef.h>
+#include <vector>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include "cpu_profiler.h"
+
+/* Spheres tested per SSE step, the arrays of SphereSet are padded to a multiple of it */
+#define FRUSTUM_BATCH 4
+
+/* The 6 planes of a view volume, pointing inwards. A point p is inside plane i when
+	normal[i].p + distance[i] >= 0 */
+class Frustum
+{
+public:
+	float normalX[6];
+	float normalY[6];
+	float normalZ[6];
+	float distance[6];
+
+	/* Gribb and Hartmann: every plane is the 4th row of projection * view plus or minus one of the
+		others, the result is in world space */
+	void extract(const glm::mat4 &viewProjection)
+		{
+			for (int i = 0; i < 6; i++)
+				{
+					int row = i / 2;
+					float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+					/* glm is column major, m[column][row] */
+					glm::vec4 plane;
+					for (int column = 0; column < 4; column++)
+						plane[column] = viewProjection[column][3] + sign * viewProjection[column][row];
+
+					float length = glm::length(glm::vec3(plane));
+					normalX[i] = plane.x / length;
+					normalY[i] = plane.y / length;
+					normalZ[i] = plane.z / length;
+					distance[i] = plane.w / length;
+				}
+		}
+};
+
+/* Bounding spheres kept as separate x, y, z and radius arrays so FRUSTUM_BATCH of them go through
+	each plane test together. Padding entries have a radius of -1 and are never visible */
+class SphereSet
+{
+public:
+	/* Filled by cull(), 1 for every sphere that touches the frustum */
+	std::vector<unsigned char> visible;
+
+	SphereSet() : count(0)
+		{
+		}
+
+	/* Returns the index of the new sphere */
+	size_t add(glm::vec3 center, float radius)
+		{
+			size_t index = count;
+			count++;
+			if (x.size() < count)
+				{
+					x.resize(x.size() + FRUSTUM_BATCH, 0.0f);
+					y.resize(y.size() + FRUSTUM_BATCH, 0.0f);
+					z.resize(z.size() + FRUSTUM_BATCH, 0.0f);
+					radii.resize(radii.size() + FRUSTUM_BATCH, -1.0f);
+					visible.resize(visible.size() + FRUSTUM_BATCH, 0);
+				}
+			set(index, center, radius);
+			return index;
+		}
+
+	void set(size_t index, glm::vec3 center, float radius)
+		{
+			x[index] = center.x;
+			y[index] = center.y;
+			z[index] = center.z;
+			radii[index] = radius;
+		}
+
+	size_t size() const
+		{
+			return count;
+		}
+
+	glm::vec3 center(size_t index) const
+		{
+			return glm::vec3(x[index], y[index], z[index]);
+		}
+
+	float radius(size_t index) const
+		{
+			return radii[index];
+		}
+
+	/* Test every sphere, returns how many are visible */
+	size_t cull(const Frustum &frustum)
+		{
+			CPU_PROFILE_SCOPE("SphereSet::cull");
+			size_t drawn = 0;
+			for (size_t first = 0; first < x.size(); first += FRUSTUM_BATCH)
+				drawn += cullBatch(frustum, first);
+			return drawn;
+		}
+
+private:
+	size_t count;
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	std::vector<float> radii;
+
+#if defined(__SSE__)
+	/* A sphere is outside when its centre is further than its radius behind any plane */
+	size_t cullBatch(const Frustum &frustum, size_t first)
+		{
+			__m128 centerX = _mm_loadu_ps(&x[first]);
+			__m128 centerY = _mm_loadu_ps(&y[first]);
+			__m128 centerZ = _mm_loadu_ps(&z[first]);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radii[first]));
+			/* All ones in the lanes still inside every plane so far */
+			__m128 inside = _mm_cmpge_ps(_mm_loadu_ps(&radii[first]), _mm_setzero_ps());
+			for (int i = 0; i < 6; i++)
+				{
+					__m128 side = _mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(frustum.normalX[i])),
+						_mm_add_ps(_mm_mul_ps(centerY, _mm_set1_ps(frustum.normalY[i])),
+						_mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(frustum.normalZ[i])), _mm_set1_ps(frustum.distance[i]))));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(side, negativeRadius));
+				}
+
+			int mask = _mm_movemask_ps(inside);
+			size_t drawn = 0;
+			for (int lane = 0; lane < FRUSTUM_BATCH; lane++)
+				{
+					visible[first + lane] = (mask >> lane) & 1;
+					drawn += visible[first + lane];
+				}
+			return drawn;
+		}
+#else
+	size_t cullBatch(const Frustum &frustum, size_t first)
+		{
+			size_t drawn = 0;
+			for (size_t s = first; s < first + FRUSTUM_BATCH; s++)
+				{
+					bool inside = radii[s] >= 0.0f;
+					for (int i = 0; i < 6 && inside; i++)
+						inside = frustum.normalX[i] * x[s] + frustum.normalY[i] * y[s] + frustum.normalZ[i] * z[s] + frustum.distance[i] >= -radii[s];
+					visible[s] = inside ? 1 : 0;
+					drawn += visible[s];
+				}
+			return drawn;
+		}
+#endif
+};
+#endif
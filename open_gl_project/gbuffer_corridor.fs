@@ -0,0 +1,28 @@
+#version 460 core
+/* G-buffer targets, the attachments DeferredRenderer makes in this order */
+layout (location = 0) out vec4 gAlbedo;
+layout (location = 1) out vec4 gSpecular;
+layout (location = 2) out vec4 gNormal;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+/* the maps of whichever corridor surface is drawn, diffuse on unit 0 and specular on unit 1 */
+struct Material
+	{
+		sampler2D diffuseMap;
+		sampler2D specularMap;
+		float shininess;
+	};
+uniform Material material;
+/* 0 wall, 1 floor, 2 celling: which Lights block deferred_lighting.fs shades the pixel with */
+uniform int surface;
+
+/* no lighting here, only what the lighting pass needs to light the pixel later */
+void main()
+{
+	gAlbedo = vec4(texture(material.diffuseMap, TexCoords).rgb, 1.0);
+	gSpecular = vec4(texture(material.specularMap, TexCoords).rgb, material.shininess / 255.0);
+	gNormal = vec4(normalize(Normal), float(surface));
+}
@@ -0,0 +1,314 @@
+#ifndef GEOMETRY_MANAGER_H
+#define GEOMETRY_MANAGER_H
+
+#include "glad.h"
+
+#include <math.h>
+#include <map>
+#include <vector>
+#include <iostream>
+
+/* Room made for the first meshes of a format, pools double whenever a mesh does not fit */
+#define GEOMETRY_INITIAL_VERTICES 1024
+#define GEOMETRY_INITIAL_INDICES 1024
+
+/* First fit allocator over a range of elements. Free blocks are kept sorted by offset and a released
+	block is merged with the free blocks on either side, so the free list never holds two neighbours */
+class RangeAllocator
+{
+public:
+	RangeAllocator() : size(0), inUse(0)
+		{
+		}
+
+	/* false when no free block is large enough, grow() and try again */
+	bool allocate(GLuint count, GLuint &offset)
+		{
+			for (std::map<GLuint, GLuint>::iterator it = freeBlocks.begin(); it != freeBlocks.end(); ++it)
+				{
+					if (it->second < count)
+						continue;
+
+					offset = it->first;
+					GLuint remaining = it->second - count;
+					freeBlocks.erase(it);
+					if (remaining > 0)
+						freeBlocks[offset + count] = remaining;
+					inUse += count;
+					return true;
+				}
+			return false;
+		}
+
+	void release(GLuint offset, GLuint count)
+		{
+			if (count == 0)
+				return;
+			inUse -= count;
+
+			std::map<GLuint, GLuint>::iterator next = freeBlocks.lower_bound(offset);
+			/* Merge with the block right after */
+			if (next != freeBlocks.end() && offset + count == next->first)
+				{
+					count += next->second;
+					next = freeBlocks.erase(next);
+				}
+			/* and with the block right before */
+			if (next != freeBlocks.begin())
+				{
+					std::map<GLuint, GLuint>::iterator previous = next;
+					--previous;
+					if (previous->first + previous->second == offset)
+						{
+							previous->second += count;
+							return;
+						}
+				}
+			freeBlocks[offset] = count;
+		}
+
+	/* Extend the range, the new space joins a free block at the end if there is one */
+	void grow(GLuint newSize)
+		{
+			if (newSize <= size)
+				return;
+			GLuint oldSize = size;
+			size = newSize;
+			inUse += newSize - oldSize;
+			release(oldSize, newSize - oldSize);
+		}
+
+	GLuint capacity() const
+		{
+			return size;
+		}
+
+	GLuint used() const
+		{
+			return inUse;
+		}
+
+	size_t fragments() const
+		{
+			return freeBlocks.size();
+		}
+
+private:
+	GLuint size;
+	GLuint inUse;
+	/* offset -> length */
+	std::map<GLuint, GLuint> freeBlocks;
+};
+
+/* One float attribute of a vertex format, offset in floats from the start of the vertex */
+struct VertexAttribute
+{
+	GLuint location;
+	GLint components;
+	GLuint offset;
+};
+
+/* Where a mesh lives inside the buffers of its format. Draw it with glDrawElementsBaseVertex when indexCount
+	is not 0, with glDrawArrays(baseVertex, vertexCount) otherwise */
+struct GeometryHandle
+{
+	int format;
+	GLint baseVertex;
+	GLuint vertexCount;
+	GLuint firstIndex;
+	GLuint indexCount;
+	/* Of the smallest sphere around the local origin that holds every vertex */
+	float radius;
+};
+
+/* Packs the meshes of each vertex format into one vertex and one index buffer shared through one VAO,
+	so drawing any number of meshes of a format takes a single VAO bind. Space is handed out by a
+	RangeAllocator per buffer, removed meshes free theirs for the next ones */
+class GeometryManager
+{
+public:
+	/* A new vertex layout, returns the format to pass to add() */
+	int addFormat(GLsizei strideFloats, const VertexAttribute *attributes, int attributeCount)
+		{
+			Pool pool;
+			pool.stride = strideFloats * sizeof(float);
+			pool.attributes.assign(attributes, attributes + attributeCount);
+			pool.meshes = 0;
+			glGenVertexArrays(1, &pool.VAO);
+			pool.VBO = 0;
+			pool.EBO = 0;
+			pools.push_back(pool);
+			return (int)pools.size() - 1;
+		}
+
+	/* Copy a mesh into the buffers of its format, indices may be NULL for a plain triangle list */
+	GeometryHandle add(int format, const float *vertices, GLuint vertexCount, const unsigned int *indices = NULL, GLuint indexCount = 0)
+		{
+			Pool &pool = pools[format];
+			GeometryHandle handle;
+			handle.format = format;
+			handle.vertexCount = vertexCount;
+			handle.indexCount = indices != NULL ? indexCount : 0;
+			handle.firstIndex = 0;
+			handle.radius = boundingRadius(vertices, vertexCount, pool.stride / sizeof(float));
+
+			GLuint baseVertex = 0;
+			while (!pool.vertices.allocate(vertexCount, baseVertex))
+				growVertices(pool, vertexCount);
+			handle.baseVertex = (GLint)baseVertex;
+			while (handle.indexCount > 0 && !pool.indices.allocate(handle.indexCount, handle.firstIndex))
+				growIndices(pool, handle.indexCount);
+
+			glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+			glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)baseVertex * pool.stride, (GLsizeiptr)vertexCount * pool.stride, vertices);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			if (handle.indexCount > 0)
+				{
+					/* The element binding is VAO state, so the VAO has to be bound to reach the buffer */
+					glBindVertexArray(pool.VAO);
+					glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)handle.firstIndex * sizeof(unsigned int), (GLsizeiptr)handle.indexCount * sizeof(unsigned int), indices);
+					glBindVertexArray(0);
+				}
+
+			pool.meshes++;
+			return handle;
+		}
+
+	/* Rewrite the vertices of a mesh in place, same count as when it was added */
+	void update(const GeometryHandle &handle, const float *vertices)
+		{
+			const Pool &pool = pools[handle.format];
+			glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+			glBufferSubData(GL_ARRAY_BUFFER, vertexOffset(handle), (GLsizeiptr)handle.vertexCount * pool.stride, vertices);
+		}
+
+	/* Give the space of a mesh back, the handle must not be drawn afterwards */
+	void remove(const GeometryHandle &handle)
+		{
+			Pool &pool = pools[handle.format];
+			pool.vertices.release((GLuint)handle.baseVertex, handle.vertexCount);
+			pool.indices.release(handle.firstIndex, handle.indexCount);
+			pool.meshes--;
+		}
+
+	unsigned int vertexArray(int format) const
+		{
+			return pools[format].VAO;
+		}
+
+	unsigned int vertexBuffer(int format) const
+		{
+			return pools[format].VBO;
+		}
+
+	/* Changes when the indices of the format outgrow it, take it after the last add() */
+	unsigned int indexBuffer(int format) const
+		{
+			return pools[format].EBO;
+		}
+
+	/* Byte offset of a mesh's first vertex in vertexBuffer() */
+	GLintptr vertexOffset(const GeometryHandle &handle) const
+		{
+			return (GLintptr)handle.baseVertex * pools[handle.format].stride;
+		}
+
+	void printStats() const
+		{
+			for (size_t i = 0; i < pools.size(); i++)
+				{
+					const Pool &pool = pools[i];
+					std::cout << "Geometry format " << i << ": " << pool.meshes << " meshes in 1 VAO, "
+						<< pool.vertices.used() << "/" << pool.vertices.capacity() << " vertices, "
+						<< pool.indices.used() << "/" << pool.indices.capacity() << " indices, "
+						<< pool.vertices.fragments() + pool.indices.fragments() << " free blocks" << std::endl;
+				}
+		}
+
+private:
+	struct Pool
+	{
+		GLsizei stride;
+		std::vector<VertexAttribute> attributes;
+		unsigned int VAO;
+		unsigned int VBO;
+		unsigned int EBO;
+		RangeAllocator vertices;
+		RangeAllocator indices;
+		unsigned int meshes;
+	};
+
+	std::vector<Pool> pools;
+
+	/* Move a buffer's contents to one of a new size, the old object is deleted */
+	static unsigned int resize(unsigned int buffer, GLsizeiptr oldSize, GLsizeiptr newSize)
+		{
+			unsigned int resized;
+			glGenBuffers(1, &resized);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, resized);
+			glBufferData(GL_COPY_WRITE_BUFFER, newSize, NULL, GL_STATIC_DRAW);
+			if (buffer != 0)
+				{
+					glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+					glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+					glDeleteBuffers(1, &buffer);
+				}
+			return resized;
+		}
+
+	/* Every format starts with the position */
+	static float boundingRadius(const float *vertices, GLuint vertexCount, size_t strideFloats)
+		{
+			float radiusSquared = 0.0f;
+			for (GLuint i = 0; i < vertexCount; i++)
+				{
+					const float *position = vertices + i * strideFloats;
+					float lengthSquared = position[0] * position[0] + position[1] * position[1] + position[2] * position[2];
+					if (lengthSquared > radiusSquared)
+						radiusSquared = lengthSquared;
+				}
+			return sqrtf(radiusSquared);
+		}
+
+	static GLuint grownSize(GLuint capacity, GLuint needed, GLuint initial)
+		{
+			GLuint size = capacity > 0 ? capacity * 2 : initial;
+			while (size < capacity + needed)
+				size *= 2;
+			return size;
+		}
+
+	/* Handles keep their offsets, only the buffer object behind them changes */
+	void growVertices(Pool &pool, GLuint needed)
+		{
+			GLuint oldCapacity = pool.vertices.capacity();
+			GLuint newCapacity = grownSize(oldCapacity, needed, GEOMETRY_INITIAL_VERTICES);
+			pool.VBO = resize(pool.VBO, (GLsizeiptr)oldCapacity * pool.stride, (GLsizeiptr)newCapacity * pool.stride);
+			pool.vertices.grow(newCapacity);
+
+			/* The attribute pointers captured the old buffer */
+			glBindVertexArray(pool.VAO);
+			glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+			for (size_t i = 0; i < pool.attributes.size(); i++)
+				{
+					const VertexAttribute &attribute = pool.attributes[i];
+					glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, pool.stride, (void*)(attribute.offset * sizeof(float)));
+					glEnableVertexAttribArray(attribute.location);
+				}
+			glBindVertexArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+
+	void growIndices(Pool &pool, GLuint needed)
+		{
+			GLuint oldCapacity = pool.indices.capacity();
+			GLuint newCapacity = grownSize(oldCapacity, needed, GEOMETRY_INITIAL_INDICES);
+			pool.EBO = resize(pool.EBO, (GLsizeiptr)oldCapacity * sizeof(unsigned int), (GLsizeiptr)newCapacity * sizeof(unsigned int));
+			pool.indices.grow(newCapacity);
+
+			glBindVertexArray(pool.VAO);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+			glBindVertexArray(0);
+		}
+};
+#endif
@@ -0,0 +1,201 @@
+#ifndef GL_DEBUG_H
+#define GL_DEBUG_H
+
+#include "glad.h"
+
+#include <iostream>
+
+/* Built in unless NDEBUG is defined, like the CPU profiler. Without it GLCall(x) is only x and nothing is checked */
+#ifndef NDEBUG
+#define GL_DEBUGGING
+#endif
+
+#ifdef GL_DEBUGGING
+
+#include <signal.h>
+#include <stdio.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/* Times the same message is printed from the same call site, later ones are only counted */
+#define GL_DEBUG_REPEATS 1
+
+/* Asserts if the return was false and lunches debug break */
+#define ASSERT(x) if (!(x)) raise(SIGTRAP);
+
+/* Only remembers which call is being made, the driver reports through the callback instead of glGetError */
+#define GLCall(x) do { GLDebugOutput::setCallSite(#x, __FILE__, __LINE__); x; GLDebugOutput::setCallSite(NULL, NULL, 0); } while (0)
+
+/* Driver messages through glDebugMessageCallback (KHR_debug, core since 4.3) instead of polling glGetError
+	around every call, which makes some drivers wait for the GPU. Notifications and known chatter are filtered
+	out, and every message is printed once per call site and counted after that. Asynchronous by default, where
+	the driver may call the callback from any of its threads and several at once, so the counters and the map
+	are only touched under a mutex. In synchronous mode the callback runs inside the call that caused the
+	message, so the GLCall() site is exact and errors break into the debugger the way GLCall used to */
+class GLDebugOutput
+{
+public:
+	/* On the current context, false when it has no KHR_debug */
+	static bool enable(bool synchronous)
+		{
+			if (!GLAD_GL_VERSION_4_3 && !GLAD_GL_KHR_debug)
+				{
+					std::cout << "OpenGL debug: KHR_debug not supported, no driver messages" << std::endl;
+					return false;
+				}
+			GLint flags = 0;
+			glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+			if (!(flags & GL_CONTEXT_FLAG_DEBUG_BIT))
+				std::cout << "OpenGL debug: not a debug context, the driver may report less" << std::endl;
+
+			state().synchronous = synchronous;
+			glEnable(GL_DEBUG_OUTPUT);
+			if (synchronous)
+				glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+			else
+				glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+			glDebugMessageCallback(callback, NULL);
+
+			/* Everything but notifications, and not the buffer placement hints some drivers give on every upload */
+			glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_TRUE);
+			glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+			static const GLuint chatter[] = { 131169, 131185, 131204, 131218 };
+			glDebugMessageControl(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, GL_DONT_CARE, 4, chatter, GL_FALSE);
+
+			std::cout << "OpenGL debug: driver messages on, " << (synchronous ? "synchronous" : "asynchronous") << std::endl;
+			return true;
+		}
+
+	/* Called by GLCall() around every wrapped call, NULL once it has returned */
+	static void setCallSite(const char *call, const char *file, int line)
+		{
+			GLDebugOutput &debug = state();
+			debug.call = call;
+			debug.file = file;
+			debug.line = line;
+		}
+
+	/* How many messages came in and how many of them were repeats left out, at exit */
+	static void printSummary()
+		{
+			GLDebugOutput &debug = state();
+			std::lock_guard<std::mutex> lock(debug.mutex);
+			if (debug.messages > 0)
+				std::cout << "OpenGL debug: " << debug.messages << " messages, " << debug.repeats << " repeats not printed" << std::endl;
+		}
+
+private:
+	bool synchronous;
+	const char *call;
+	const char *file;
+	int line;
+	unsigned int messages;
+	unsigned int repeats;
+	/* Times each message was seen, by id and call site */
+	std::unordered_map<std::string, unsigned int> seen;
+	/* Held for the whole callback, it also keeps the lines of two messages from mixing on cout */
+	std::mutex mutex;
+
+	GLDebugOutput() : synchronous(false), call(NULL), file(NULL), line(0), messages(0), repeats(0)
+		{
+		}
+
+	static GLDebugOutput &state()
+		{
+			static GLDebugOutput debug;
+			return debug;
+		}
+
+	static const char *sourceName(GLenum source)
+		{
+			switch (source)
+				{
+					case GL_DEBUG_SOURCE_API: return "API";
+					case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+					case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+					case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+					case GL_DEBUG_SOURCE_APPLICATION: return "application";
+					default: return "other";
+				}
+		}
+
+	static const char *typeName(GLenum type)
+		{
+			switch (type)
+				{
+					case GL_DEBUG_TYPE_ERROR: return "ERROR";
+					case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED";
+					case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "UNDEFINED BEHAVIOR";
+					case GL_DEBUG_TYPE_PORTABILITY: return "PORTABILITY";
+					case GL_DEBUG_TYPE_PERFORMANCE: return "PERFORMANCE";
+					case GL_DEBUG_TYPE_MARKER: return "MARKER";
+					default: return "OTHER";
+				}
+		}
+
+	static const char *severityName(GLenum severity)
+		{
+			switch (severity)
+				{
+					case GL_DEBUG_SEVERITY_HIGH: return "high";
+					case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+					case GL_DEBUG_SEVERITY_LOW: return "low";
+					default: return "notification";
+				}
+		}
+
+	static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam)
+		{
+			GLDebugOutput &debug = state();
+			std::lock_guard<std::mutex> lock(debug.mutex);
+			debug.messages++;
+
+			/* Asynchronous messages can arrive long after the call, the site is only known in synchronous mode */
+			bool sited = debug.synchronous && debug.call != NULL;
+			char key[64];
+			snprintf(key, sizeof(key), "%x:%x:%u:%d", source, type, id, sited ? debug.line : 0);
+			std::string site = key;
+			if (sited)
+				site += debug.file;
+			unsigned int count = ++debug.seen[site];
+			if (count > GL_DEBUG_REPEATS)
+				{
+					debug.repeats++;
+					return;
+				}
+
+			std::cout << "[OpenGL " << typeName(type) << "] (" << id << ", " << sourceName(source) << ", " << severityName(severity) << ") " << message;
+			if (sited)
+				std::cout << " from function: " << debug.call << " in file " << debug.file << " at line " << debug.line;
+			if (count == GL_DEBUG_REPEATS)
+				std::cout << " (later ones only counted)";
+			std::cout << std::endl;
+
+			if (sited && type == GL_DEBUG_TYPE_ERROR)
+				ASSERT(false);
+		}
+};
+
+#else
+
+#define ASSERT(x) ((void)0)
+#define GLCall(x) x
+
+/* Release builds, nothing is set up and nothing checked */
+class GLDebugOutput
+{
+public:
+	static bool enable(bool synchronous)
+		{
+			std::cout << "OpenGL debug: not in this build" << std::endl;
+			return false;
+		}
+
+	static void printSummary()
+		{
+		}
+};
+
+#endif
+#endif
@@ -0,0 +1,243 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include "glad.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "cpu_profiler.h"
+
+/* Query pools, the one a frame writes and the one from the frame before, read while the next is written */
+#define GPU_PROFILER_FRAMES 2
+/* Scopes one frame can time, any more are not timed */
+#define GPU_PROFILER_MAX_SCOPES 64
+/* Frames the rolling averages run over */
+#define GPU_PROFILER_WINDOW 60
+
+/* The timings of one named scope over the last GPU_PROFILER_WINDOW frames it ran in */
+struct GpuScopeStats
+{
+	std::string name;
+	/* How many scopes it was nested in when first seen */
+	int depth;
+	float samples[GPU_PROFILER_WINDOW];
+	int sampleCount;
+	int nextSample;
+	/* Frame of its last sample, scopes that stopped running drop out of the overlay */
+	unsigned int lastFrame;
+
+	double average() const
+		{
+			double total = 0.0;
+			for (int i = 0; i < sampleCount; i++)
+				total += samples[i];
+			return sampleCount > 0 ? total / sampleCount : 0.0;
+		}
+
+	float maximum() const
+		{
+			float largest = 0.0f;
+			for (int i = 0; i < sampleCount; i++)
+				largest = samples[i] > largest ? samples[i] : largest;
+			return largest;
+		}
+};
+
+/* GPU time of named, nestable scopes of the frame. begin() and end() each write a GL_TIMESTAMP with
+	glQueryCounter, which unlike GL_TIME_ELAPSED queries can nest and overlap. A frame's queries are read
+	GPU_PROFILER_FRAMES frames later, just before their pool is written again; when the GPU has not
+	finished them yet that frame is dropped instead of waited for, so the profiler never stalls */
+class GpuProfiler
+{
+public:
+	/* In the order they were first seen, which is the order of the frame for scopes that always run */
+	std::vector<GpuScopeStats> scopes;
+
+	GpuProfiler() : enabled(false), requested(false), frame(0), droppedFrames(0), csv(NULL)
+		{
+			glGenQueries(GPU_PROFILER_FRAMES * GPU_PROFILER_MAX_SCOPES * 2, &queries[0][0]);
+			for (int pool = 0; pool < GPU_PROFILER_FRAMES; pool++)
+				recordCount[pool] = 0;
+		}
+
+	~GpuProfiler()
+		{
+			if (csv != NULL)
+				fclose(csv);
+		}
+
+	/* Takes effect at the next beginFrame() so no frame is timed in part */
+	void setEnabled(bool enable)
+		{
+			requested = enable;
+		}
+
+	bool isEnabled() const
+		{
+			return requested;
+		}
+
+	/* Append the rolling averages to a CSV file every GPU_PROFILER_WINDOW frames while enabled */
+	bool openCSV(const char *path)
+		{
+			csv = fopen(path, "w");
+			if (csv == NULL)
+				{
+					std::cout << "GPU profiler: can not write " << path << std::endl;
+					return false;
+				}
+			fprintf(csv, "frame,scope,depth,avg_ms,max_ms,samples\n");
+			return true;
+		}
+
+	void beginFrame()
+		{
+			CPU_PROFILE_SCOPE("GpuProfiler::beginFrame");
+			int pool = frame % GPU_PROFILER_FRAMES;
+			collect(pool);
+			recordCount[pool] = 0;
+			open.clear();
+			enabled = requested;
+			if (enabled && csv != NULL && frame % GPU_PROFILER_WINDOW == 0)
+				writeCSV();
+		}
+
+	void endFrame()
+		{
+			/* Scopes left open are dropped */
+			int pool = frame % GPU_PROFILER_FRAMES;
+			for (size_t i = 0; i < open.size(); i++)
+				if (open[i] >= 0)
+					records[pool][open[i]].scope = -1;
+			frame++;
+		}
+
+	void begin(const char *name)
+		{
+			if (!enabled)
+				return;
+			int pool = frame % GPU_PROFILER_FRAMES;
+			if (recordCount[pool] == GPU_PROFILER_MAX_SCOPES)
+				{
+					open.push_back(-1);
+					return;
+				}
+			int record = recordCount[pool]++;
+			records[pool][record].scope = findScope(name, (int)open.size());
+			glQueryCounter(queries[pool][2 * record], GL_TIMESTAMP);
+			lastQuery[pool] = queries[pool][2 * record];
+			open.push_back(record);
+		}
+
+	void end()
+		{
+			if (!enabled || open.empty())
+				return;
+			int record = open.back();
+			open.pop_back();
+			if (record < 0)
+				return;
+			int pool = frame % GPU_PROFILER_FRAMES;
+			glQueryCounter(queries[pool][2 * record + 1], GL_TIMESTAMP);
+			lastQuery[pool] = queries[pool][2 * record + 1];
+		}
+
+	/* Whether a scope ran in one of the last few frames, the ones still worth showing */
+	bool isCurrent(const GpuScopeStats &scope) const
+		{
+			return scope.lastFrame + GPU_PROFILER_FRAMES + 1 >= frame;
+		}
+
+	/* Frames whose results were not ready in time */
+	unsigned int dropped() const
+		{
+			return droppedFrames;
+		}
+
+private:
+	struct ScopeRecord
+	{
+		/* Index into scopes, -1 when the scope was never closed */
+		int scope;
+	};
+
+	bool enabled;
+	bool requested;
+	unsigned int frame;
+	unsigned int droppedFrames;
+	/* Start and end timestamp of every record */
+	unsigned int queries[GPU_PROFILER_FRAMES][GPU_PROFILER_MAX_SCOPES * 2];
+	ScopeRecord records[GPU_PROFILER_FRAMES][GPU_PROFILER_MAX_SCOPES];
+	int recordCount[GPU_PROFILER_FRAMES];
+	/* The query of each pool written last */
+	unsigned int lastQuery[GPU_PROFILER_FRAMES];
+	/* Records of the scopes begun and not yet ended, -1 for the untimed ones */
+	std::vector<int> open;
+	FILE *csv;
+
+	int findScope(const char *name, int depth)
+		{
+			for (size_t i = 0; i < scopes.size(); i++)
+				if (scopes[i].name == name)
+					return (int)i;
+			GpuScopeStats scope;
+			scope.name = name;
+			scope.depth = depth;
+			scope.sampleCount = 0;
+			scope.nextSample = 0;
+			scope.lastFrame = frame;
+			scopes.push_back(scope);
+			return (int)scopes.size() - 1;
+		}
+
+	/* Read the pool written GPU_PROFILER_FRAMES frames ago if the GPU got through all of it */
+	void collect(int pool)
+		{
+			if (recordCount[pool] == 0)
+				return;
+			/* Timestamps are written in order, when the last one is there so are the others */
+			GLint available = 0;
+			glGetQueryObjectiv(lastQuery[pool], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available)
+				{
+					droppedFrames++;
+					return;
+				}
+			unsigned int recordFrame = frame - GPU_PROFILER_FRAMES;
+			for (int record = 0; record < recordCount[pool]; record++)
+				{
+					if (records[pool][record].scope < 0)
+						continue;
+					GLuint64 start, end;
+					glGetQueryObjectui64v(queries[pool][2 * record], GL_QUERY_RESULT, &start);
+					glGetQueryObjectui64v(queries[pool][2 * record + 1], GL_QUERY_RESULT, &end);
+					GpuScopeStats &scope = scopes[records[pool][record].scope];
+					/* A scope that ran more than once in the frame adds up */
+					float milliseconds = (end - start) / 1.0e6f;
+					if (scope.lastFrame == recordFrame && scope.sampleCount > 0)
+						scope.samples[(scope.nextSample + GPU_PROFILER_WINDOW - 1) % GPU_PROFILER_WINDOW] += milliseconds;
+					else
+						{
+							scope.samples[scope.nextSample] = milliseconds;
+							scope.nextSample = (scope.nextSample + 1) % GPU_PROFILER_WINDOW;
+							if (scope.sampleCount < GPU_PROFILER_WINDOW)
+								scope.sampleCount++;
+						}
+					scope.lastFrame = recordFrame;
+				}
+		}
+
+	void writeCSV()
+		{
+			for (size_t i = 0; i < scopes.size(); i++)
+				if (scopes[i].sampleCount > 0 && isCurrent(scopes[i]))
+					fprintf(csv, "%u,\"%s\",%d,%.4f,%.4f,%d\n", frame, scopes[i].name.c_str(), scopes[i].depth,
+						scopes[i].average(), scopes[i].maximum(), scopes[i].sampleCount);
+			fflush(csv);
+		}
+};
+#endif
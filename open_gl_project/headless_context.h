@@ -0,0 +1,169 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include "glad.h"
+/* Keep Xlib and its macros out, there is no X server to talk to */
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+/* An OpenGL 4.6 core context without a window or a display server, for render nodes and containers.
+	EGL is asked for Mesa's surfaceless platform, which needs no X server or GPU (llvmpipe renders on the
+	CPU), and the context is made current with no surface at all. Everything is drawn into a framebuffer
+	object of the requested size instead, which stays bound in place of the window's */
+class HeadlessContext
+{
+public:
+	HeadlessContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT), framebuffer(0), width(0), height(0)
+		{
+		}
+
+	/* Make the context current, false when EGL could not give one. Load glad with getProcAddress() afterwards
+		and then call createFramebuffer(). A debug context reports more to GLDebugOutput */
+	bool create(bool debug = false)
+		{
+			/* The client extensions tell whether the surfaceless platform can be asked for by name */
+			const char *clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+			PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+			if (clientExtensions != NULL && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != NULL && getPlatformDisplay != NULL)
+				display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			else
+				display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			EGLint major, minor;
+			if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+				{
+					std::cout << "ERROR::HEADLESS::NO_EGL_DISPLAY" << std::endl;
+					return false;
+				}
+			const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+			if (extensions == NULL || strstr(extensions, "EGL_KHR_surfaceless_context") == NULL)
+				{
+					std::cout << "ERROR::HEADLESS::NO_SURFACELESS_CONTEXT" << std::endl;
+					return false;
+				}
+
+			EGLint configAttributes[] = {
+				EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+				EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+				EGL_NONE
+			};
+			EGLConfig config;
+			EGLint configs = 0;
+			if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0 || !eglBindAPI(EGL_OPENGL_API))
+				{
+					std::cout << "ERROR::HEADLESS::NO_OPENGL_CONFIG" << std::endl;
+					return false;
+				}
+			EGLint contextAttributes[] = {
+				EGL_CONTEXT_MAJOR_VERSION, 4,
+				EGL_CONTEXT_MINOR_VERSION, 6,
+				EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+				EGL_CONTEXT_OPENGL_DEBUG, debug ? EGL_TRUE : EGL_FALSE,
+				EGL_NONE
+			};
+			context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+			if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+				{
+					std::cout << "ERROR::HEADLESS::NO_OPENGL_4_6_CONTEXT" << std::endl;
+					return false;
+				}
+			std::cout << "Headless: EGL " << major << "." << minor << " " << eglQueryString(display, EGL_VENDOR) << std::endl;
+			start = std::chrono::steady_clock::now();
+			return true;
+		}
+
+	/* For gladLoadGLLoader() */
+	static void *getProcAddress(const char *name)
+		{
+			return (void *)eglGetProcAddress(name);
+		}
+
+	/* The colour and depth targets everything is drawn into, bound and with the viewport set to all of them */
+	void createFramebuffer(int newWidth, int newHeight)
+		{
+			width = newWidth;
+			height = newHeight;
+			glGenRenderbuffers(2, renderbuffers);
+			glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+			glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+			glGenFramebuffers(1, &framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cout << "ERROR::HEADLESS::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+			/* With no surface the viewport starts out empty */
+			glViewport(0, 0, width, height);
+			std::cout << "Headless: rendering offscreen at " << width << "x" << height << std::endl;
+		}
+
+	/* Seconds since create(), what glfwGetTime() would give with a window */
+	double time() const
+		{
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			return elapsed.count();
+		}
+
+	/* The colour target as a binary PPM, top row first. Waits for the frame to finish */
+	bool writePPM(const char *path) const
+		{
+			std::vector<unsigned char> pixels((size_t)width * height * 3);
+			glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+
+			FILE *file = fopen(path, "wb");
+			if (file == NULL)
+				{
+					std::cout << "ERROR::HEADLESS::CAN_NOT_WRITE: " << path << std::endl;
+					return false;
+				}
+			fprintf(file, "P6 %d %d 255\n", width, height);
+			/* GL rows start at the bottom */
+			for (int y = height - 1; y >= 0; y--)
+				fwrite(&pixels[(size_t)y * width * 3], 1, (size_t)width * 3, file);
+			fclose(file);
+			return true;
+		}
+
+	void destroy()
+		{
+			if (framebuffer != 0)
+				{
+					glDeleteFramebuffers(1, &framebuffer);
+					glDeleteRenderbuffers(2, renderbuffers);
+					framebuffer = 0;
+				}
+			if (display != EGL_NO_DISPLAY)
+				{
+					eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+					if (context != EGL_NO_CONTEXT)
+						eglDestroyContext(display, context);
+					eglTerminate(display);
+					display = EGL_NO_DISPLAY;
+					context = EGL_NO_CONTEXT;
+				}
+		}
+
+private:
+	EGLDisplay display;
+	EGLContext context;
+	unsigned int framebuffer;
+	/* Colour, then depth and stencil */
+	unsigned int renderbuffers[2];
+	int width;
+	int height;
+	std::chrono::steady_clock::time_point start;
+};
+#endif
@@ -0,0 +1,377 @@
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <iostream>
+#include <vector>
+
+#include "shader_s.h"
+#include "exhibit.h"
+#include "render_queue.h"
+#include "geometry_manager.h"
+#include "stream_ring.h"
+#include "occlusion_culler.h"
+#include "cpu_profiler.h"
+
+/* Binding point of the per object buffer, the same number as layout(binding = N) in exhibit_indirect.vs/fs */
+#define INDIRECT_OBJECTS_BINDING 0
+/* Texture units of the layer array and of the texture mixed over every layer, binding = N in exhibit_indirect.fs */
+#define INDIRECT_LAYERS_UNIT 0
+#define INDIRECT_OVERLAY_UNIT 1
+/* Objects one batch takes, the rest go back to the RenderQueue. Sizes the batch's share of the StreamRing */
+#define INDIRECT_MAX_OBJECTS 256
+
+/* Shading of one object, selects the branch taken in exhibit_indirect.fs */
+enum IndirectMaterial
+{
+	/* colour from the vertices, triangle.fs */
+	INDIRECT_VERTEX_COLOUR = 0,
+	/* a layer of the array mixed 80/20 with the overlay texture, square.fs */
+	INDIRECT_TEXTURED = 1,
+	/* one light and a material, exhibit_7_light_colour.fs */
+	INDIRECT_LIT = 2,
+	/* plain white, lamp.fs */
+	INDIRECT_WHITE = 3
+};
+
+/* One object of the batch in the std430 layout of exhibit_indirect.vs/fs, the shaders pick theirs with gl_DrawID.
+	The lit fields are only read for INDIRECT_LIT, materialSpecular.w holds the shininess */
+struct IndirectObject
+{
+	glm::mat4 model;
+	glm::vec4 lightPosition;
+	glm::vec4 lightAmbient;
+	glm::vec4 lightDiffuse;
+	glm::vec4 lightSpecular;
+	glm::vec4 materialAmbient;
+	glm::vec4 materialDiffuse;
+	glm::vec4 materialSpecular;
+	int32_t material;
+	/* Bounding sphere radius in world units about the model origin, for occlusion_cull.comp */
+	float radius;
+	/* Layer of the array texture for INDIRECT_TEXTURED */
+	int32_t layer;
+	/* std430 rounds the array stride up to the 16 byte alignment of the matrix */
+	int32_t padding;
+};
+
+static_assert(sizeof(IndirectObject) == 192, "IndirectObject does not match the std430 Object struct");
+
+/* The command layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER */
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+
+/* Where the attributes of a source vertex array are, in floats, -1 for the ones it does not have.
+	The position is always the first 3 floats */
+struct IndirectVertexFormat
+{
+	int stride;
+	int normal;
+	int texCoord;
+	int colour;
+};
+
+/* The vertex layout of the batch, every mesh is converted to it */
+struct IndirectVertex
+{
+	float position[3];
+	float normal[3];
+	float texCoord[2];
+	float colour[3];
+};
+
+/* Draws every exhibit that opted in with one glMultiDrawElementsIndirect.
+	All meshes are one GeometryManager format, so they share a vertex and an index buffer. Transforms and shading data go to a shader storage
+	buffer indexed with gl_DrawID, so nothing but the buffers changes between objects. The objects and commands
+	of a frame are copied into the mapped StreamRing. Exhibits that need
+	state the batch can not express, like wireframe, are handed back for the RenderQueue to draw.
+	Textured exhibits join when their texture is a layer of the one array texture and the second is the overlay
+	texture, see addLayer(). The layer index comes from the object, which is fine for an array layer where a
+	sampler array index would have to be dynamically uniform. Any other textures go to the RenderQueue */
+class IndirectRenderer
+{
+public:
+	IndirectRenderer(GeometryManager &geometry, StreamRing &ring) : geometry(geometry), ring(ring), program(NULL), culler(NULL),
+		overlay(0), layerArray(0)
+		{
+			VertexAttribute attributes[] =
+				{
+					{ 0, 3, offsetof(IndirectVertex, position) / sizeof(float) },
+					{ 1, 3, offsetof(IndirectVertex, normal) / sizeof(float) },
+					{ 2, 2, offsetof(IndirectVertex, texCoord) / sizeof(float) },
+					{ 3, 3, offsetof(IndirectVertex, colour) / sizeof(float) }
+				};
+			format = geometry.addFormat(sizeof(IndirectVertex) / sizeof(float), attributes, 4);
+			objects.reserve(INDIRECT_MAX_OBJECTS);
+			commands.reserve(INDIRECT_MAX_OBJECTS);
+		}
+
+	/* Space a full batch takes in one region of the ring, to add to StreamRing::create() */
+	static GLsizeiptr frameBytes()
+		{
+			return INDIRECT_MAX_OBJECTS * (sizeof(IndirectObject) + sizeof(DrawElementsIndirectCommand)) + 2 * STREAM_RING_ALIGNMENT;
+		}
+
+	/* gl_DrawID and glMultiDrawElementsIndirect both need GL 4.6 */
+	static bool supported()
+		{
+			return GLAD_GL_VERSION_4_6 != 0;
+		}
+
+	/* The program built from exhibit_indirect.vs/fs */
+	void setProgram(Shader &shader)
+		{
+			program = &shader;
+		}
+
+	/* Test the batch against the culler's pyramid before drawing it, NULL to draw everything */
+	void setOcclusionCuller(OcclusionCuller *occlusionCuller)
+		{
+			culler = occlusionCuller;
+		}
+
+	/* Convert a mesh to the batch's vertex layout and hand it to the geometry manager, indices may be NULL
+		for a plain triangle list. Returns the handle to put in Exhibit::indirectMesh */
+	int addMesh(const float *vertices, int vertexCount, const IndirectVertexFormat &sourceFormat, const unsigned int *indices = NULL, int indexCount = 0)
+		{
+			std::vector<IndirectVertex> converted(vertexCount);
+			for (int i = 0; i < vertexCount; i++)
+				{
+					const float *source = vertices + i * sourceFormat.stride;
+					IndirectVertex vertex = {};
+					copyFloats(vertex.position, source, 0, 3);
+					copyFloats(vertex.normal, source, sourceFormat.normal, 3);
+					copyFloats(vertex.texCoord, source, sourceFormat.texCoord, 2);
+					copyFloats(vertex.colour, source, sourceFormat.colour, 3);
+					converted[i] = vertex;
+				}
+
+			/* Every command is an indexed draw */
+			std::vector<unsigned int> sequence;
+			if (indices == NULL)
+				{
+					for (int i = 0; i < vertexCount; i++)
+						sequence.push_back(i);
+					indices = &sequence[0];
+					indexCount = vertexCount;
+				}
+
+			meshes.push_back(geometry.add(format, (const float *)&converted[0], vertexCount, indices, indexCount));
+			return (int)meshes.size() - 1;
+		}
+
+	/* Make a texture a layer of the batch's array texture. Every layer has to match the first one's size and
+		format, the ones that do not stay out and their exhibits go to the RenderQueue. Call before buildLayers() */
+	void addLayer(unsigned int texture)
+		{
+			for (size_t i = 0; i < layerSources.size(); i++)
+				if (layerSources[i] == texture)
+					return;
+			layerSources.push_back(texture);
+			layers.push_back(-1);
+		}
+
+	/* The second texture of every textured exhibit in the batch, mixed over its layer */
+	void setOverlay(unsigned int texture)
+		{
+			overlay = texture;
+		}
+
+	/* Copy the layer textures into one array texture, call once every one of them is loaded. Until then the
+		textured exhibits are left to the RenderQueue. The sources stay as they are, the RenderQueue still
+		draws from them when the batch is off. Returns true once the array exists */
+	bool buildLayers()
+		{
+			if (layerArray != 0 || layerSources.empty())
+				return layerArray != 0;
+
+			/* Only DSA calls, so no binding the GLStateCache shadows is touched */
+			GLint width, height, internalFormat, maxLevel;
+			glGetTextureLevelParameteriv(layerSources[0], 0, GL_TEXTURE_WIDTH, &width);
+			glGetTextureLevelParameteriv(layerSources[0], 0, GL_TEXTURE_HEIGHT, &height);
+			glGetTextureLevelParameteriv(layerSources[0], 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+			glGetTextureParameteriv(layerSources[0], GL_TEXTURE_MAX_LEVEL, &maxLevel);
+			/* Every level glGenerateMipmap made, or the ones a KTX2 file brought */
+			GLsizei levels = 1;
+			while (levels <= maxLevel && ((width > height ? width : height) >> levels) > 0)
+				levels++;
+
+			GLsizei count = 0;
+			for (size_t i = 0; i < layerSources.size(); i++)
+				{
+					GLint sourceWidth, sourceHeight, sourceFormat;
+					glGetTextureLevelParameteriv(layerSources[i], 0, GL_TEXTURE_WIDTH, &sourceWidth);
+					glGetTextureLevelParameteriv(layerSources[i], 0, GL_TEXTURE_HEIGHT, &sourceHeight);
+					glGetTextureLevelParameteriv(layerSources[i], 0, GL_TEXTURE_INTERNAL_FORMAT, &sourceFormat);
+					if (sourceWidth == width && sourceHeight == height && sourceFormat == internalFormat)
+						layers[i] = count++;
+				}
+
+			GLint wrapS, wrapT, minFilter, magFilter;
+			glGetTextureParameteriv(layerSources[0], GL_TEXTURE_WRAP_S, &wrapS);
+			glGetTextureParameteriv(layerSources[0], GL_TEXTURE_WRAP_T, &wrapT);
+			glGetTextureParameteriv(layerSources[0], GL_TEXTURE_MIN_FILTER, &minFilter);
+			glGetTextureParameteriv(layerSources[0], GL_TEXTURE_MAG_FILTER, &magFilter);
+
+			glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &layerArray);
+			glTextureStorage3D(layerArray, levels, internalFormat, width, height, count);
+			glTextureParameteri(layerArray, GL_TEXTURE_WRAP_S, wrapS);
+			glTextureParameteri(layerArray, GL_TEXTURE_WRAP_T, wrapT);
+			glTextureParameteri(layerArray, GL_TEXTURE_MIN_FILTER, minFilter);
+			glTextureParameteri(layerArray, GL_TEXTURE_MAG_FILTER, magFilter);
+			for (size_t i = 0; i < layerSources.size(); i++)
+				{
+					if (layers[i] < 0)
+						continue;
+					/* Level for level, so nothing is filtered again */
+					for (GLsizei level = 0; level < levels; level++)
+						{
+							GLsizei levelWidth = (width >> level) > 0 ? (width >> level) : 1;
+							GLsizei levelHeight = (height >> level) > 0 ? (height >> level) : 1;
+							glCopyImageSubData(layerSources[i], GL_TEXTURE_2D, level, 0, 0, 0,
+								layerArray, GL_TEXTURE_2D_ARRAY, level, 0, 0, layers[i], levelWidth, levelHeight, 1);
+						}
+				}
+
+			std::cout << "Indirect batch: " << count << " of " << layerSources.size() << " textures copied into one " << width << "x" << height
+				<< " array texture" << std::endl;
+			return true;
+		}
+
+	/* Start a new frame */
+	void clear()
+		{
+			objects.clear();
+			commands.clear();
+		}
+
+	/* Add an exhibit to this frame's batch, false when it has to go through the RenderQueue instead */
+	bool push(const Exhibit &exhibit, double time)
+		{
+			int state = exhibitState(exhibit);
+			int mesh = exhibit.indirectMesh[state];
+			if (mesh < 0)
+				return false;
+			/* Polygon mode is one setting for the whole batch */
+			if (exhibit.wireframe != NULL && *exhibit.wireframe != 0)
+				return false;
+			if (commands.size() == INDIRECT_MAX_OBJECTS)
+				return false;
+
+			IndirectObject object = {};
+			object.model = exhibitModelMatrix(exhibit, time);
+			object.material = exhibit.indirectMaterial;
+			object.radius = exhibitBoundingRadius(exhibit);
+			if (exhibit.textureCount > 0)
+				{
+					object.layer = textureLayer(exhibit, state);
+					if (object.layer < 0)
+						return false;
+				}
+			if (exhibit.prepareIndirect != NULL)
+				exhibit.prepareIndirect(exhibit, state, time, object);
+
+			DrawElementsIndirectCommand command;
+			command.count = meshes[mesh].indexCount;
+			command.instanceCount = 1;
+			command.firstIndex = meshes[mesh].firstIndex;
+			command.baseVertex = meshes[mesh].baseVertex;
+			command.baseInstance = 0;
+
+			objects.push_back(object);
+			commands.push_back(command);
+			return true;
+		}
+
+	/* Copy the frame's objects and commands into the ring and draw them all with one call. With a culler the
+		instance counts are rewritten on the GPU first, occluded objects draw nothing */
+	void submit(GLStateCache &state)
+		{
+			CPU_PROFILE_SCOPE("IndirectRenderer::submit");
+			if (commands.empty())
+				return;
+
+			GLintptr objectOffset;
+			GLintptr commandOffset;
+			void *objectData = ring.allocate(objects.size() * sizeof(IndirectObject), objectOffset);
+			void *commandData = ring.allocate(commands.size() * sizeof(DrawElementsIndirectCommand), commandOffset);
+			if (objectData == NULL || commandData == NULL)
+				return;
+			memcpy(objectData, &objects[0], objects.size() * sizeof(IndirectObject));
+			memcpy(commandData, &commands[0], commands.size() * sizeof(DrawElementsIndirectCommand));
+
+			if (culler != NULL)
+				culler->cull(state, ring, objectOffset, commandOffset, (GLsizei)commands.size(),
+					objects.size() * sizeof(IndirectObject), commands.size() * sizeof(DrawElementsIndirectCommand));
+
+			state.useProgram(program->ID);
+			state.bindVertexArray(geometry.vertexArray(format));
+			state.setPolygonMode(GL_FILL);
+			if (layerArray != 0)
+				{
+					/* The array goes to another target of the unit than the 2D textures the cache keeps track of */
+					glBindTextureUnit(INDIRECT_LAYERS_UNIT, layerArray);
+					state.bindTexture2D(INDIRECT_OVERLAY_UNIT, overlay);
+				}
+
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INDIRECT_OBJECTS_BINDING, ring.buffer(), objectOffset, objects.size() * sizeof(IndirectObject));
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.buffer());
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)commandOffset, (GLsizei)commands.size(), 0);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		}
+
+	/* Objects in this frame's batch */
+	size_t size() const
+		{
+			return commands.size();
+		}
+
+private:
+	GeometryManager &geometry;
+	StreamRing &ring;
+	int format;
+	Shader *program;
+	OcclusionCuller *culler;
+
+	std::vector<GeometryHandle> meshes;
+
+	std::vector<IndirectObject> objects;
+	std::vector<DrawElementsIndirectCommand> commands;
+
+	unsigned int overlay;
+	unsigned int layerArray;
+	/* GL names given to addLayer(), and the layer each one got, -1 until buildLayers() or when it did not fit */
+	std::vector<unsigned int> layerSources;
+	std::vector<int> layers;
+
+	/* The layer of an exhibit's first texture in this state, -1 when the batch can not draw its textures */
+	int textureLayer(const Exhibit &exhibit, int state) const
+		{
+			if (layerArray == 0 || exhibit.textureCount != 2 || exhibit.textures[state][1] != overlay)
+				return -1;
+			for (size_t i = 0; i < layerSources.size(); i++)
+				if (layerSources[i] == exhibit.textures[state][0])
+					return layers[i];
+			return -1;
+		}
+
+	static void copyFloats(float *destination, const float *source, int offset, int count)
+		{
+			if (offset < 0)
+				return;
+			for (int i = 0; i < count; i++)
+				destination[i] = source[offset + i];
+		}
+};
+#endif
@@ -0,0 +1,70 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+
+#include <string.h>
+#include <vector>
+
+#include "stream_ring.h"
+
+/* Storage buffer binding points, the same numbers as layout(binding = N) in the corridor vertex shaders */
+#define INSTANCE_MODELS_BINDING 8
+#define INSTANCE_DRAWN_BINDING 9
+
+/* Per instance model matrices for glDrawArraysInstanced. Every matrix is kept in a storage buffer, and each
+	frame the indices of the ones to draw go to the StreamRing; instance i of the draw reads the matrix
+	models[drawn[i]]. So a draw of N copies of a mesh is one call no matter how large N gets, and the copies
+	drawn do not have to be neighbours in the buffer */
+class InstanceBuffer
+{
+public:
+	unsigned int ID;
+
+	InstanceBuffer() : ID(0), instanceCount(0)
+		{
+		}
+
+	/* Most of a ring region one frame can take for the drawn list, to add to StreamRing::create() */
+	static GLsizeiptr frameBytes(size_t instances)
+		{
+			return (GLsizeiptr)((instances > 0 ? instances : 1) * sizeof(GLuint)) + STREAM_RING_ALIGNMENT;
+		}
+
+	/* Replace every matrix, the buffer is reallocated to fit and bound to INSTANCE_MODELS_BINDING */
+	void upload(const std::vector<glm::mat4> &models)
+		{
+			if (ID == 0)
+				glGenBuffers(1, &ID);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, ID);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, models.empty() ? sizeof(glm::mat4) : models.size() * sizeof(glm::mat4),
+				models.empty() ? NULL : &models[0], GL_STATIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_MODELS_BINDING, ID);
+			instanceCount = (GLsizei)models.size();
+		}
+
+	/* Copy this frame's list of instances to draw into the ring and bind it to INSTANCE_DRAWN_BINDING. The
+		ring has to have been created with frameBytes() of room */
+	void setDrawn(StreamRing &ring, const std::vector<GLuint> &drawn) const
+		{
+			GLsizeiptr bytes = drawn.empty() ? sizeof(GLuint) : drawn.size() * sizeof(GLuint);
+			GLintptr offset;
+			void *data = ring.allocate(bytes, offset);
+			if (data == NULL)
+				return;
+			if (!drawn.empty())
+				memcpy(data, &drawn[0], bytes);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, INSTANCE_DRAWN_BINDING, ring.buffer(), offset, bytes);
+		}
+
+	GLsizei count() const
+		{
+			return instanceCount;
+		}
+
+private:
+	GLsizei instanceCount;
+};
+#endif
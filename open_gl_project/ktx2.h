@@ -0,0 +1,220 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/* The subset of KTX 2.0 (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html) written by the baker
+	and read by the app: one 2D image, no array layers or cube faces, no supercompression, BC1, BC3 or BC7
+	blocks with a full mip chain. Shared by the baker and the app so both agree on the layout */
+
+/* vkFormat values of the block formats we use */
+#define KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK 131
+#define KTX2_VK_FORMAT_BC3_UNORM_BLOCK 137
+#define KTX2_VK_FORMAT_BC7_UNORM_BLOCK 145
+
+/* Data format descriptor colour models of the same formats */
+#define KTX2_DF_MODEL_BC1A 128
+#define KTX2_DF_MODEL_BC3 130
+#define KTX2_DF_MODEL_BC7 134
+
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+static const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+/* One mip level inside the file */
+struct Ktx2Level
+{
+	uint64_t byteOffset;
+	uint64_t byteLength;
+};
+
+/* What the app needs from a parsed file, level 0 is the full size image */
+struct Ktx2Image
+{
+	uint32_t vkFormat;
+	uint32_t width;
+	uint32_t height;
+	std::vector<Ktx2Level> levels;
+};
+
+inline bool isKtx2(const unsigned char *bytes, size_t size)
+{
+	return size >= sizeof(KTX2_IDENTIFIER) && memcmp(bytes, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
+
+/* Bytes of one 4x4 block */
+inline uint32_t ktx2BlockBytes(uint32_t vkFormat)
+{
+	return vkFormat == KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK ? 8 : 16;
+}
+
+inline uint32_t ktx2LevelBytes(uint32_t vkFormat, uint32_t width, uint32_t height)
+{
+	return ((width + 3) / 4) * ((height + 3) / 4) * ktx2BlockBytes(vkFormat);
+}
+
+inline uint32_t ktx2ReadU32(const unsigned char *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint64_t ktx2ReadU64(const unsigned char *p)
+{
+	return (uint64_t)ktx2ReadU32(p) | ((uint64_t)ktx2ReadU32(p + 4) << 32);
+}
+
+/* Check the header and level index of a file in memory, false for anything outside the subset above */
+inline bool parseKtx2(const unsigned char *bytes, size_t size, Ktx2Image &image)
+{
+	if (size < KTX2_HEADER_SIZE || !isKtx2(bytes, size))
+		return false;
+
+	image.vkFormat = ktx2ReadU32(bytes + 12);
+	uint32_t typeSize = ktx2ReadU32(bytes + 16);
+	image.width = ktx2ReadU32(bytes + 20);
+	image.height = ktx2ReadU32(bytes + 24);
+	uint32_t depth = ktx2ReadU32(bytes + 28);
+	uint32_t layerCount = ktx2ReadU32(bytes + 32);
+	uint32_t faceCount = ktx2ReadU32(bytes + 36);
+	uint32_t levelCount = ktx2ReadU32(bytes + 40);
+	uint32_t supercompression = ktx2ReadU32(bytes + 44);
+
+	if (image.vkFormat != KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK && image.vkFormat != KTX2_VK_FORMAT_BC3_UNORM_BLOCK
+		&& image.vkFormat != KTX2_VK_FORMAT_BC7_UNORM_BLOCK)
+		return false;
+	if (typeSize != 1 || image.width == 0 || image.height == 0 || depth != 0 || layerCount != 0 || faceCount != 1
+		|| levelCount == 0 || supercompression != 0)
+		return false;
+	if (size < KTX2_HEADER_SIZE + (size_t)levelCount * KTX2_LEVEL_INDEX_ENTRY_SIZE)
+		return false;
+
+	image.levels.resize(levelCount);
+	for (uint32_t level = 0; level < levelCount; level++)
+		{
+			const unsigned char *entry = bytes + KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+			image.levels[level].byteOffset = ktx2ReadU64(entry);
+			image.levels[level].byteLength = ktx2ReadU64(entry + 8);
+
+			uint32_t width = image.width >> level ? image.width >> level : 1;
+			uint32_t height = image.height >> level ? image.height >> level : 1;
+			if (image.levels[level].byteLength != ktx2LevelBytes(image.vkFormat, width, height)
+				|| image.levels[level].byteOffset + image.levels[level].byteLength > size)
+				return false;
+		}
+
+	return true;
+}
+
+inline void ktx2PutU32(std::vector<unsigned char> &out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+inline void ktx2PutU64(std::vector<unsigned char> &out, uint64_t value)
+{
+	ktx2PutU32(out, (uint32_t)value);
+	ktx2PutU32(out, (uint32_t)(value >> 32));
+}
+
+/* Basic data format descriptor with one sample per block plane, alpha first for BC3 as the spec lists it */
+inline std::vector<unsigned char> ktx2BuildDFD(uint32_t vkFormat)
+{
+	uint32_t model = KTX2_DF_MODEL_BC7;
+	uint32_t samples = 1;
+	if (vkFormat == KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK)
+		model = KTX2_DF_MODEL_BC1A;
+	else if (vkFormat == KTX2_VK_FORMAT_BC3_UNORM_BLOCK)
+		{
+			model = KTX2_DF_MODEL_BC3;
+			samples = 2;
+		}
+	uint32_t blockSize = 24 + 16 * samples;
+	uint32_t bytesPlane0 = ktx2BlockBytes(vkFormat);
+
+	std::vector<unsigned char> dfd;
+	ktx2PutU32(dfd, 4 + blockSize);
+	/* vendorId 0 (Khronos), descriptorType 0 (basic) */
+	ktx2PutU32(dfd, 0);
+	/* versionNumber 2, descriptorBlockSize */
+	ktx2PutU32(dfd, 2 | (blockSize << 16));
+	/* colorModel, BT.709 primaries, linear transfer, straight alpha */
+	ktx2PutU32(dfd, model | (1 << 8) | (1 << 16) | (0 << 24));
+	/* texelBlockDimension 4x4x1x1 stored minus one */
+	ktx2PutU32(dfd, 3 | (3 << 8));
+	ktx2PutU32(dfd, bytesPlane0);
+	ktx2PutU32(dfd, 0);
+
+	for (uint32_t sample = 0; sample < samples; sample++)
+		{
+			/* BC3: the alpha half (channel 15) comes first, then the colour half */
+			uint32_t channel = (samples == 2 && sample == 0) ? 15 : 0;
+			uint32_t bitOffset = sample * 64;
+			uint32_t bitLength = (bytesPlane0 / samples) * 8 - 1;
+			ktx2PutU32(dfd, bitOffset | (bitLength << 16) | (channel << 24));
+			ktx2PutU32(dfd, 0);
+			ktx2PutU32(dfd, 0);
+			ktx2PutU32(dfd, 0xFFFFFFFFu);
+		}
+
+	return dfd;
+}
+
+/* Lay out a whole file, levels[0] is the full size image. Level data goes smallest first as the spec asks */
+inline std::vector<unsigned char> buildKtx2(uint32_t vkFormat, uint32_t width, uint32_t height, const std::vector<std::vector<unsigned char> > &levels)
+{
+	std::vector<unsigned char> dfd = ktx2BuildDFD(vkFormat);
+	uint32_t levelCount = (uint32_t)levels.size();
+	uint32_t dfdOffset = KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+
+	/* Level data has to start on a multiple of the block size (lcm with 4 is the block size itself) */
+	uint64_t blockBytes = ktx2BlockBytes(vkFormat);
+	std::vector<uint64_t> offsets(levelCount);
+	uint64_t offset = dfdOffset + dfd.size();
+	for (int level = (int)levelCount - 1; level >= 0; level--)
+		{
+			offset = (offset + blockBytes - 1) / blockBytes * blockBytes;
+			offsets[level] = offset;
+			offset += levels[level].size();
+		}
+
+	std::vector<unsigned char> out(KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	ktx2PutU32(out, vkFormat);
+	ktx2PutU32(out, 1);
+	ktx2PutU32(out, width);
+	ktx2PutU32(out, height);
+	ktx2PutU32(out, 0);
+	ktx2PutU32(out, 0);
+	ktx2PutU32(out, 1);
+	ktx2PutU32(out, levelCount);
+	ktx2PutU32(out, 0);
+	/* Index: DFD, no key/value data, no supercompression global data */
+	ktx2PutU32(out, dfdOffset);
+	ktx2PutU32(out, (uint32_t)dfd.size());
+	ktx2PutU32(out, 0);
+	ktx2PutU32(out, 0);
+	ktx2PutU64(out, 0);
+	ktx2PutU64(out, 0);
+
+	for (uint32_t level = 0; level < levelCount; level++)
+		{
+			ktx2PutU64(out, offsets[level]);
+			ktx2PutU64(out, levels[level].size());
+			ktx2PutU64(out, levels[level].size());
+		}
+
+	out.insert(out.end(), dfd.begin(), dfd.end());
+
+	for (int level = (int)levelCount - 1; level >= 0; level--)
+		{
+			out.resize(offsets[level], 0);
+			out.insert(out.end(), levels[level].begin(), levels[level].end());
+		}
+
+	return out;
+}
+#endif
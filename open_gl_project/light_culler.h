@@ -0,0 +1,155 @@
+#ifndef LIGHT_CULLER_H
+#define LIGHT_CULLER_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+
+#include <math.h>
+#include <string.h>
+#include <stddef.h>
+#include <vector>
+
+#include "uniform_buffer.h"
+#include "frustum.h"
+#include "stream_ring.h"
+#include "cpu_profiler.h"
+
+/* Luminance below which a light no longer counts, one step of an 8 bit channel */
+#define LIGHT_LUMINANCE_THRESHOLD (1.0f / 256.0f)
+/* Lights one object's list keeps, any more touching it are dropped */
+#define OBJECT_MAX_LIGHTS 128
+/* Storage buffer binding points, the same numbers as layout(binding = N) in cluster_assign.comp and the corridor shaders */
+#define LIGHT_ACTIVE_BINDING 5
+#define OBJECT_LIGHT_RANGES_BINDING 6
+#define OBJECT_LIGHT_INDICES_BINDING 7
+
+/* Works out on the CPU which point lights matter this frame. Every light gets a radius from its attenuation,
+	the lights whose sphere misses the view frustum are dropped, and every drawn object
+	gets the list of the remaining lights whose sphere touches its own. All of it goes to the GPU through the
+	StreamRing: the visible lights for cluster_assign.comp to bin, and the per object lists, which the draw
+	reads for its instance with gl_InstanceID */
+class LightCuller
+{
+public:
+	/* Indices of the lights touching the frustum after cull(), in increasing order */
+	std::vector<GLuint> visibleLights;
+
+	LightCuller() : listedObjects(0), listedLights(0)
+		{
+		}
+
+	/* Distance where constant + linear * d + quadratic * d^2 has brought the most luminous of the light's
+		colours below threshold */
+	static float effectiveRadius(const PointLightBlock &light, float threshold = LIGHT_LUMINANCE_THRESHOLD)
+		{
+			float brightest = glm::max(luminance(light.ambient), glm::max(luminance(light.diffuse), luminance(light.specular)));
+			float c = light.constant - brightest / threshold;
+			if (c >= 0.0f)
+				return 0.0f;
+			if (light.quadratic <= 0.0f)
+				return light.linear > 0.0f ? -c / light.linear : 1.0e30f;
+			return (-light.linear + sqrtf(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+		}
+
+	/* Most of a ring region one frame can take for up to objects objects and lights lights, to add to StreamRing::create() */
+	static GLsizeiptr frameBytes(size_t objects, size_t lights)
+		{
+			size_t perObject = lights < OBJECT_MAX_LIGHTS ? lights : OBJECT_MAX_LIGHTS;
+			return (GLsizeiptr)(lights * sizeof(GLuint) + objects * 2 * sizeof(GLuint) + objects * perObject * sizeof(GLuint)) + 3 * STREAM_RING_ALIGNMENT;
+		}
+
+	/* The lights do not move, their spheres are kept from here on. radius has to be set */
+	void setLights(const PointLightBlock *lights, unsigned int count)
+		{
+			spheres = SphereSet();
+			for (unsigned int i = 0; i < count; i++)
+				spheres.add(lights[i].position, lights[i].radius);
+			visibleLights.reserve(count);
+		}
+
+	/* Returns how many lights touch the frustum */
+	size_t cull(const Frustum &frustum)
+		{
+			CPU_PROFILE_SCOPE("LightCuller::cull");
+			spheres.cull(frustum);
+			visibleLights.clear();
+			for (size_t i = 0; i < spheres.size(); i++)
+				if (spheres.visible[i])
+					visibleLights.push_back((GLuint)i);
+			return visibleLights.size();
+		}
+
+	/* A list of visible lights for each object in drawn, object drawn[i] is instance i of the draw */
+	void buildObjectLists(const SphereSet &objects, const std::vector<GLuint> &drawn)
+		{
+			CPU_PROFILE_SCOPE("LightCuller::buildObjectLists");
+			size_t count = drawn.size();
+			ranges.resize(count * 2);
+			indices.clear();
+			for (size_t i = 0; i < count; i++)
+				{
+					glm::vec3 center = objects.center(drawn[i]);
+					float radius = objects.radius(drawn[i]);
+					size_t start = indices.size();
+					for (size_t l = 0; l < visibleLights.size() && indices.size() - start < OBJECT_MAX_LIGHTS; l++)
+						{
+							GLuint light = visibleLights[l];
+							float reach = radius + spheres.radius(light);
+							glm::vec3 offset = spheres.center(light) - center;
+							if (glm::dot(offset, offset) <= reach * reach)
+								indices.push_back(light);
+						}
+					ranges[i * 2] = (GLuint)start;
+					ranges[i * 2 + 1] = (GLuint)(indices.size() - start);
+				}
+			listedObjects = count;
+			listedLights = indices.size();
+		}
+
+	/* Copy this frame's lists into the ring and bind them, the ring has to have been created with frameBytes() of room */
+	void upload(StreamRing &ring)
+		{
+			CPU_PROFILE_SCOPE("LightCuller::upload");
+			uploadArray(ring, LIGHT_ACTIVE_BINDING, visibleLights);
+			uploadArray(ring, OBJECT_LIGHT_RANGES_BINDING, ranges);
+			uploadArray(ring, OBJECT_LIGHT_INDICES_BINDING, indices);
+		}
+
+	size_t visibleCount() const
+		{
+			return visibleLights.size();
+		}
+
+	/* Lights per object over the objects of the last buildObjectLists() */
+	double averageObjectLights() const
+		{
+			return listedObjects > 0 ? (double)listedLights / listedObjects : 0.0;
+		}
+
+private:
+	SphereSet spheres;
+	/* First index and count in indices for every object */
+	std::vector<GLuint> ranges;
+	std::vector<GLuint> indices;
+	size_t listedObjects;
+	size_t listedLights;
+
+	static float luminance(glm::vec3 colour)
+		{
+			return glm::dot(colour, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+		}
+
+	/* An empty array still binds one word, a zero sized range is not allowed */
+	static void uploadArray(StreamRing &ring, GLuint binding, const std::vector<GLuint> &values)
+		{
+			GLsizeiptr bytes = values.empty() ? sizeof(GLuint) : values.size() * sizeof(GLuint);
+			GLintptr offset;
+			void *data = ring.allocate(bytes, offset);
+			if (data == NULL)
+				return;
+			if (!values.empty())
+				memcpy(data, &values[0], bytes);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, ring.buffer(), offset, bytes);
+		}
+};
+#endif
@@ -0,0 +1,219 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include "glad.h"
+
+#include "shader_s.h"
+#include "render_queue.h"
+#include "stream_ring.h"
+
+/* Binding points of occlusion_cull.comp, the objects are the same buffer exhibit_indirect.vs reads */
+#define OCCLUSION_OBJECTS_BINDING 0
+#define OCCLUSION_COMMANDS_BINDING 1
+#define OCCLUSION_COUNTERS_BINDING 2
+/* Texture unit and image unit of the pyramid, layout(binding = N) in the compute shaders */
+#define HIZ_TEXTURE_UNIT 0
+#define HIZ_IMAGE_UNIT 0
+/* local_size of the compute shaders */
+#define HIZ_GROUP_SIZE 8
+#define OCCLUSION_GROUP_SIZE 64
+
+/* Hierarchical Z occlusion culling for the indirect batch.
+	The large occluders are drawn depth only into a texture of their own, which is reduced into a mip
+	pyramid where every texel holds the farthest depth of the texels it covers. occlusion_cull.comp then
+	projects the bounding box of each object of the batch, reads the pyramid level where the box spans
+	2x2 texels, and sets the instance count of the object's indirect command to 0 when the box is behind
+	all of it. The number culled comes back through a persistently mapped buffer, STREAM_RING_FRAMES
+	frames later, once the frame that counted it is known to be done */
+class OcclusionCuller
+{
+public:
+	OcclusionCuller(Shader &depthProgram, Shader &downsampleProgram, Shader &cullProgram)
+		: depthProgram(depthProgram), downsampleProgram(downsampleProgram), cullProgram(cullProgram),
+		framebuffer(0), depthTexture(0), pyramid(0), width(0), height(0), levels(0), culled(0), tested(0)
+		{
+			sourceLevelUniform = downsampleProgram.uniform("sourceLevel");
+			copyUniform = downsampleProgram.uniform("copy");
+			objectCountUniform = cullProgram.uniform("objectCount");
+
+			/* One counter per ring region, each at an offset glBindBufferRange accepts for a storage buffer */
+			GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glGenBuffers(1, &counterBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+			glBufferStorage(GL_SHADER_STORAGE_BUFFER, STREAM_RING_ALIGNMENT * STREAM_RING_FRAMES, NULL, flags);
+			counters = (unsigned char *)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, STREAM_RING_ALIGNMENT * STREAM_RING_FRAMES, flags);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			for (int region = 0; region < STREAM_RING_FRAMES; region++)
+				{
+					*counter(region) = 0;
+					testedCounts[region] = 0;
+				}
+		}
+
+	/* Compute shaders need GL 4.3, glBufferStorage 4.4 */
+	static bool supported()
+		{
+			return GLAD_GL_VERSION_4_4 != 0;
+		}
+
+	/* Match the size of the window, the textures are only made again when it changed */
+	void resize(int newWidth, int newHeight)
+		{
+			if (newWidth == width && newHeight == height)
+				return;
+			width = newWidth;
+			height = newHeight;
+
+			if (framebuffer != 0)
+				{
+					glDeleteFramebuffers(1, &framebuffer);
+					glDeleteTextures(1, &depthTexture);
+					glDeleteTextures(1, &pyramid);
+				}
+
+			glGenTextures(1, &depthTexture);
+			glBindTexture(GL_TEXTURE_2D, depthTexture);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+			setNearestFilter();
+
+			levels = 1;
+			while ((width >> levels) > 0 || (height >> levels) > 0)
+				levels++;
+			glGenTextures(1, &pyramid);
+			glBindTexture(GL_TEXTURE_2D, pyramid);
+			glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+			setNearestFilter();
+			/* Every level has to be in range for texelFetch */
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			GLint previousFramebuffer;
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+			glGenFramebuffers(1, &framebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+			if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+				std::cout << "ERROR::OCCLUSION::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+			glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+		}
+
+	/* Draw the occluders with the program returned here until endOccluders() */
+	Shader &beginOccluders()
+		{
+			glGetIntegerv(GL_VIEWPORT, viewport);
+			glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &targetFramebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			glViewport(0, 0, width, height);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			depthProgram.use();
+			return depthProgram;
+		}
+
+	/* Back to the window, then reduce the occluder depth into the pyramid */
+	void endOccluders()
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+			glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+			downsampleProgram.use();
+			/* Level 0 is a plain copy, the depth texture can not be an image */
+			glActiveTexture(GL_TEXTURE0 + HIZ_TEXTURE_UNIT);
+			glBindTexture(GL_TEXTURE_2D, depthTexture);
+			downsampleProgram.setBool(copyUniform, true);
+			downsampleProgram.setInt(sourceLevelUniform, 0);
+			dispatchLevel(0);
+
+			glBindTexture(GL_TEXTURE_2D, pyramid);
+			downsampleProgram.setBool(copyUniform, false);
+			for (int level = 1; level < levels; level++)
+				{
+					glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+					downsampleProgram.setInt(sourceLevelUniform, level - 1);
+					dispatchLevel(level);
+				}
+			glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		}
+
+	/* Set the instance count of count commands at commandOffset of the ring from the objects at objectOffset.
+		Binds go through state, the draw that follows uses it too */
+	void cull(GLStateCache &state, const StreamRing &ring, GLintptr objectOffset, GLintptr commandOffset, GLsizei count, GLsizeiptr objectSize, GLsizeiptr commandSize)
+		{
+			/* The counter of this region was last written STREAM_RING_FRAMES frames ago and the ring has
+				waited for that frame's fence, so it is final */
+			int region = ring.currentRegion();
+			culled = *counter(region);
+			tested = testedCounts[region];
+			*counter(region) = 0;
+			testedCounts[region] = count;
+
+			state.useProgram(cullProgram.ID);
+			state.bindTexture2D(HIZ_TEXTURE_UNIT, pyramid);
+			cullProgram.setInt(objectCountUniform, count);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, OCCLUSION_OBJECTS_BINDING, ring.buffer(), objectOffset, objectSize);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, OCCLUSION_COMMANDS_BINDING, ring.buffer(), commandOffset, commandSize);
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, OCCLUSION_COUNTERS_BINDING, counterBuffer, region * STREAM_RING_ALIGNMENT, sizeof(GLuint));
+			glDispatchCompute((count + OCCLUSION_GROUP_SIZE - 1) / OCCLUSION_GROUP_SIZE, 1, 1);
+			/* The draw reads the commands, the CPU reads the counter once the frame's fence has passed */
+			glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+		}
+
+	/* Objects culled out of culledOf() tested, in the last frame that is known to be done */
+	unsigned int culledObjects() const
+		{
+			return culled;
+		}
+
+	unsigned int culledOf() const
+		{
+			return tested;
+		}
+
+private:
+	Shader &depthProgram;
+	Shader &downsampleProgram;
+	Shader &cullProgram;
+	GLint sourceLevelUniform;
+	GLint copyUniform;
+	GLint objectCountUniform;
+
+	unsigned int framebuffer;
+	unsigned int depthTexture;
+	unsigned int pyramid;
+	int width;
+	int height;
+	int levels;
+	/* The viewport and framebuffer, the window's or the headless one, the pass returns to */
+	GLint viewport[4];
+	GLint targetFramebuffer;
+
+	unsigned int counterBuffer;
+	unsigned char *counters;
+	/* Objects sent to the shader in the frame that last used each region */
+	unsigned int testedCounts[STREAM_RING_FRAMES];
+	unsigned int culled;
+	unsigned int tested;
+
+	GLuint *counter(int region) const
+		{
+			return (GLuint *)(counters + region * STREAM_RING_ALIGNMENT);
+		}
+
+	void dispatchLevel(int level)
+		{
+			int levelWidth = width >> level > 0 ? width >> level : 1;
+			int levelHeight = height >> level > 0 ? height >> level : 1;
+			glBindImageTexture(HIZ_IMAGE_UNIT, pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+			glDispatchCompute((levelWidth + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (levelHeight + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+		}
+
+	static void setNearestFilter()
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+};
+#endif
@@ -0,0 +1,109 @@
+#ifndef OVERLAY_FONT_H
+#define OVERLAY_FONT_H
+
+/* A fixed width bitmap font for the on-screen overlays: one glyph per printable ASCII character from
+	' ' to '~', one byte per pixel row from the top, bit 5 is the leftmost pixel */
+#define OVERLAY_FONT_WIDTH 6
+#define OVERLAY_FONT_HEIGHT 11
+#define OVERLAY_FONT_FIRST 32
+#define OVERLAY_FONT_COUNT 95
+
+static const unsigned char OVERLAY_FONT[OVERLAY_FONT_COUNT][OVERLAY_FONT_HEIGHT] =
+{
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* ' ' */
+	{ 0x00, 0x00, 0x00, 0x18, 0x18, 0x18, 0x18, 0x00, 0x18, 0x00, 0x00 },	/* '!' */
+	{ 0x00, 0x00, 0x00, 0x14, 0x14, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* '"' */
+	{ 0x00, 0x00, 0x14, 0x14, 0x3E, 0x14, 0x14, 0x3E, 0x14, 0x14, 0x00 },	/* '#' */
+	{ 0x00, 0x08, 0x1E, 0x32, 0x3C, 0x1E, 0x06, 0x36, 0x3C, 0x08, 0x00 },	/* '$' */
+	{ 0x00, 0x00, 0x38, 0x2A, 0x3C, 0x08, 0x1E, 0x2A, 0x0E, 0x00, 0x00 },	/* '%' */
+	{ 0x00, 0x00, 0x00, 0x1C, 0x30, 0x18, 0x3E, 0x2C, 0x3E, 0x00, 0x00 },	/* '&' */
+	{ 0x00, 0x00, 0x0C, 0x08, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* ''' */
+	{ 0x00, 0x00, 0x04, 0x08, 0x18, 0x18, 0x18, 0x18, 0x08, 0x04, 0x00 },	/* '(' */
+	{ 0x00, 0x00, 0x10, 0x08, 0x0C, 0x0C, 0x0C, 0x0C, 0x08, 0x10, 0x00 },	/* ')' */
+	{ 0x00, 0x00, 0x08, 0x3C, 0x18, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* asterisk */
+	{ 0x00, 0x00, 0x00, 0x08, 0x08, 0x3E, 0x08, 0x08, 0x00, 0x00, 0x00 },	/* '+' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x08, 0x10 },	/* ',' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* '-' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00 },	/* '.' */
+	{ 0x00, 0x00, 0x02, 0x02, 0x04, 0x04, 0x08, 0x08, 0x10, 0x10, 0x00 },	/* slash */
+	{ 0x00, 0x00, 0x1C, 0x36, 0x36, 0x36, 0x36, 0x36, 0x1C, 0x00, 0x00 },	/* '0' */
+	{ 0x00, 0x00, 0x0C, 0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00, 0x00 },	/* '1' */
+	{ 0x00, 0x00, 0x1C, 0x36, 0x06, 0x0C, 0x18, 0x36, 0x3E, 0x00, 0x00 },	/* '2' */
+	{ 0x00, 0x00, 0x1C, 0x36, 0x06, 0x1C, 0x06, 0x36, 0x1C, 0x00, 0x00 },	/* '3' */
+	{ 0x00, 0x00, 0x06, 0x0E, 0x16, 0x36, 0x3F, 0x06, 0x06, 0x00, 0x00 },	/* '4' */
+	{ 0x00, 0x00, 0x3E, 0x30, 0x3C, 0x36, 0x06, 0x26, 0x3C, 0x00, 0x00 },	/* '5' */
+	{ 0x00, 0x00, 0x1C, 0x36, 0x30, 0x3C, 0x36, 0x36, 0x1C, 0x00, 0x00 },	/* '6' */
+	{ 0x00, 0x00, 0x3E, 0x36, 0x06, 0x0C, 0x0C, 0x18, 0x18, 0x00, 0x00 },	/* '7' */
+	{ 0x00, 0x00, 0x1C, 0x36, 0x36, 0x1C, 0x36, 0x36, 0x1C, 0x00, 0x00 },	/* '8' */
+	{ 0x00, 0x00, 0x1C, 0x36, 0x36, 0x1E, 0x06, 0x36, 0x1C, 0x00, 0x00 },	/* '9' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x18, 0x00, 0x00 },	/* ':' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x18, 0x10, 0x20 },	/* ';' */
+	{ 0x00, 0x00, 0x00, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x00, 0x00, 0x00 },	/* '<' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x3C, 0x00, 0x3C, 0x00, 0x00, 0x00, 0x00 },	/* '=' */
+	{ 0x00, 0x00, 0x00, 0x18, 0x0C, 0x06, 0x0C, 0x18, 0x00, 0x00, 0x00 },	/* '>' */
+	{ 0x00, 0x00, 0x00, 0x1C, 0x26, 0x0C, 0x18, 0x00, 0x18, 0x00, 0x00 },	/* '?' */
+	{ 0x00, 0x00, 0x1C, 0x32, 0x26, 0x2A, 0x2A, 0x27, 0x30, 0x1C, 0x00 },	/* '@' */
+	{ 0x00, 0x00, 0x00, 0x3C, 0x1C, 0x14, 0x3E, 0x36, 0x37, 0x00, 0x00 },	/* 'A' */
+	{ 0x00, 0x00, 0x00, 0x3C, 0x36, 0x3C, 0x36, 0x36, 0x3C, 0x00, 0x00 },	/* 'B' */
+	{ 0x00, 0x00, 0x00, 0x1E, 0x36, 0x30, 0x30, 0x36, 0x1C, 0x00, 0x00 },	/* 'C' */
+	{ 0x00, 0x00, 0x00, 0x3C, 0x36, 0x36, 0x36, 0x36, 0x3C, 0x00, 0x00 },	/* 'D' */
+	{ 0x00, 0x00, 0x00, 0x3E, 0x30, 0x3C, 0x30, 0x36, 0x3E, 0x00, 0x00 },	/* 'E' */
+	{ 0x00, 0x00, 0x00, 0x3E, 0x30, 0x3C, 0x30, 0x30, 0x38, 0x00, 0x00 },	/* 'F' */
+	{ 0x00, 0x00, 0x00, 0x1C, 0x36, 0x30, 0x3E, 0x36, 0x1E, 0x00, 0x00 },	/* 'G' */
+	{ 0x00, 0x00, 0x00, 0x37, 0x36, 0x3E, 0x36, 0x36, 0x37, 0x00, 0x00 },	/* 'H' */
+	{ 0x00, 0x00, 0x00, 0x3C, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00, 0x00 },	/* 'I' */
+	{ 0x00, 0x00, 0x00, 0x1E, 0x0C, 0x0C, 0x2C, 0x2C, 0x38, 0x00, 0x00 },	/* 'J' */
+	{ 0x00, 0x00, 0x00, 0x36, 0x34, 0x38, 0x3C, 0x36, 0x3B, 0x00, 0x00 },	/* 'K' */
+	{ 0x00, 0x00, 0x00, 0x38, 0x30, 0x30, 0x30, 0x36, 0x3E, 0x00, 0x00 },	/* 'L' */
+	{ 0x00, 0x00, 0x00, 0x22, 0x36, 0x36, 0x3E, 0x2A, 0x2A, 0x00, 0x00 },	/* 'M' */
+	{ 0x00, 0x00, 0x00, 0x37, 0x3A, 0x3A, 0x36, 0x36, 0x32, 0x00, 0x00 },	/* 'N' */
+	{ 0x00, 0x00, 0x00, 0x1C, 0x36, 0x36, 0x36, 0x36, 0x1C, 0x00, 0x00 },	/* 'O' */
+	{ 0x00, 0x00, 0x00, 0x3C, 0x36, 0x36, 0x3C, 0x30, 0x38, 0x00, 0x00 },	/* 'P' */
+	{ 0x00, 0x00, 0x00, 0x1C, 0x36, 0x36, 0x36, 0x36, 0x1C, 0x06, 0x00 },	/* 'Q' */
+	{ 0x00, 0x00, 0x00, 0x3C, 0x36, 0x36, 0x3C, 0x36, 0x3B, 0x00, 0x00 },	/* 'R' */
+	{ 0x00, 0x00, 0x00, 0x1E, 0x32, 0x3C, 0x0E, 0x26, 0x3C, 0x00, 0x00 },	/* 'S' */
+	{ 0x00, 0x00, 0x00, 0x3E, 0x1A, 0x18, 0x18, 0x18, 0x3C, 0x00, 0x00 },	/* 'T' */
+	{ 0x00, 0x00, 0x00, 0x37, 0x36, 0x36, 0x36, 0x36, 0x1C, 0x00, 0x00 },	/* 'U' */
+	{ 0x00, 0x00, 0x00, 0x37, 0x36, 0x14, 0x1C, 0x1C, 0x08, 0x00, 0x00 },	/* 'V' */
+	{ 0x00, 0x00, 0x00, 0x2B, 0x2A, 0x2A, 0x3E, 0x1C, 0x14, 0x00, 0x00 },	/* 'W' */
+	{ 0x00, 0x00, 0x00, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x33, 0x00, 0x00 },	/* 'X' */
+	{ 0x00, 0x00, 0x00, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00, 0x00 },	/* 'Y' */
+	{ 0x00, 0x00, 0x00, 0x3E, 0x36, 0x0C, 0x18, 0x36, 0x3E, 0x00, 0x00 },	/* 'Z' */
+	{ 0x00, 0x00, 0x1C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1C, 0x00 },	/* '[' */
+	{ 0x00, 0x00, 0x20, 0x20, 0x10, 0x10, 0x08, 0x08, 0x04, 0x04, 0x00 },	/* backslash */
+	{ 0x00, 0x00, 0x1C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1C, 0x00 },	/* ']' */
+	{ 0x00, 0x00, 0x08, 0x1C, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* '^' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3F },	/* '_' */
+	{ 0x00, 0x00, 0x18, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },	/* '`' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1C, 0x36, 0x1E, 0x36, 0x3F, 0x00, 0x00 },	/* 'a' */
+	{ 0x00, 0x00, 0x30, 0x30, 0x3C, 0x36, 0x36, 0x36, 0x3C, 0x00, 0x00 },	/* 'b' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1C, 0x36, 0x30, 0x36, 0x1C, 0x00, 0x00 },	/* 'c' */
+	{ 0x00, 0x00, 0x0E, 0x06, 0x1E, 0x36, 0x36, 0x36, 0x1F, 0x00, 0x00 },	/* 'd' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1C, 0x36, 0x3E, 0x30, 0x1E, 0x00, 0x00 },	/* 'e' */
+	{ 0x00, 0x00, 0x0E, 0x18, 0x3E, 0x18, 0x18, 0x18, 0x3E, 0x00, 0x00 },	/* 'f' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1B, 0x36, 0x36, 0x36, 0x1E, 0x06, 0x3C },	/* 'g' */
+	{ 0x00, 0x00, 0x30, 0x30, 0x3C, 0x36, 0x36, 0x36, 0x36, 0x00, 0x00 },	/* 'h' */
+	{ 0x00, 0x00, 0x0C, 0x00, 0x3C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00, 0x00 },	/* 'i' */
+	{ 0x00, 0x00, 0x0C, 0x00, 0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x38 },	/* 'j' */
+	{ 0x00, 0x00, 0x30, 0x30, 0x36, 0x3C, 0x38, 0x3C, 0x37, 0x00, 0x00 },	/* 'k' */
+	{ 0x00, 0x00, 0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00, 0x00 },	/* 'l' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x3C, 0x3E, 0x2A, 0x2A, 0x2A, 0x00, 0x00 },	/* 'm' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x2C, 0x36, 0x36, 0x36, 0x36, 0x00, 0x00 },	/* 'n' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1C, 0x36, 0x36, 0x36, 0x1C, 0x00, 0x00 },	/* 'o' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x3C, 0x36, 0x36, 0x36, 0x3C, 0x30, 0x38 },	/* 'p' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1B, 0x36, 0x36, 0x36, 0x1E, 0x06, 0x0F },	/* 'q' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x37, 0x1D, 0x18, 0x18, 0x3C, 0x00, 0x00 },	/* 'r' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1E, 0x38, 0x1E, 0x07, 0x3E, 0x00, 0x00 },	/* 's' */
+	{ 0x00, 0x00, 0x18, 0x18, 0x3E, 0x18, 0x18, 0x1B, 0x0E, 0x00, 0x00 },	/* 't' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x36, 0x36, 0x36, 0x36, 0x1F, 0x00, 0x00 },	/* 'u' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x36, 0x36, 0x1C, 0x1C, 0x08, 0x00, 0x00 },	/* 'v' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x2B, 0x2A, 0x3E, 0x1E, 0x14, 0x00, 0x00 },	/* 'w' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x3B, 0x1E, 0x0C, 0x1E, 0x37, 0x00, 0x00 },	/* 'x' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x37, 0x36, 0x36, 0x14, 0x1C, 0x18, 0x30 },	/* 'y' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x3E, 0x2C, 0x18, 0x36, 0x3E, 0x00, 0x00 },	/* 'z' */
+	{ 0x00, 0x00, 0x06, 0x0C, 0x0C, 0x18, 0x0C, 0x0C, 0x0C, 0x06, 0x00 },	/* '{' */
+	{ 0x00, 0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00 },	/* '|' */
+	{ 0x00, 0x00, 0x30, 0x18, 0x18, 0x0C, 0x18, 0x18, 0x18, 0x30, 0x00 },	/* '}' */
+	{ 0x00, 0x00, 0x00, 0x00, 0x1A, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x00 }	/* '~' */
+};
+#endif
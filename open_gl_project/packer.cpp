@@ -0,0 +1,138 @@
+/* Asset packer: writes every given file into one pack the app maps at startup, see asset_pack.h for the layout.
+
+	usage: packer output.pak file...
+
+	Files are stored under their name without the directory, which is also the name the app asks for.
+	"make pack" bakes the textures and packs them together with the shaders */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+#include "asset_pack.h"
+
+struct PackedFile
+{
+	std::string name;
+	std::vector<unsigned char> data;
+};
+
+static bool nameLess(const PackedFile &a, const PackedFile &b)
+{
+	return a.name < b.name;
+}
+
+static bool readFile(const char *path, std::vector<unsigned char> &data)
+{
+	FILE *handle = fopen(path, "rb");
+	if (handle == NULL)
+		return false;
+
+	fseek(handle, 0, SEEK_END);
+	long size = ftell(handle);
+	fseek(handle, 0, SEEK_SET);
+	data.resize(size > 0 ? size : 0);
+	bool ok = size <= 0 || fread(&data[0], 1, size, handle) == (size_t)size;
+	fclose(handle);
+	return ok;
+}
+
+static void append(std::vector<unsigned char> &out, const void *data, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	out.insert(out.end(), bytes, bytes + size);
+}
+
+static void alignTo(std::vector<unsigned char> &out, size_t alignment)
+{
+	out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+		{
+			std::cout << "usage: packer output.pak file..." << std::endl;
+			return 1;
+		}
+
+	std::vector<PackedFile> files;
+	for (int i = 2; i < argc; i++)
+		{
+			PackedFile file;
+			const char *slash = strrchr(argv[i], '/');
+			file.name = slash != NULL ? slash + 1 : argv[i];
+			if (!readFile(argv[i], file.data))
+				{
+					std::cout << "packer: can not read " << argv[i] << std::endl;
+					return 1;
+				}
+			files.push_back(file);
+		}
+
+	/* The app binary searches the TOC */
+	std::sort(files.begin(), files.end(), nameLess);
+	for (size_t i = 1; i < files.size(); i++)
+		if (files[i].name == files[i - 1].name)
+			{
+				std::cout << "packer: " << files[i].name << " given twice" << std::endl;
+				return 1;
+			}
+
+	std::vector<unsigned char> strings;
+	std::vector<AssetPackEntry> entries(files.size());
+	for (size_t i = 0; i < files.size(); i++)
+		{
+			entries[i].nameOffset = (uint32_t)strings.size();
+			entries[i].nameLength = (uint32_t)files[i].name.size();
+			append(strings, files[i].name.data(), files[i].name.size());
+		}
+
+	AssetPackHeader header;
+	memcpy(header.magic, ASSET_PACK_MAGIC, 4);
+	header.version = ASSET_PACK_VERSION;
+	header.entryCount = (uint32_t)files.size();
+	header.padding = 0;
+	header.tocOffset = sizeof(AssetPackHeader);
+	header.stringsOffset = header.tocOffset + entries.size() * sizeof(AssetPackEntry);
+
+	/* Data goes after the string table, the TOC is written last once the offsets are known */
+	std::vector<unsigned char> out(header.stringsOffset, 0);
+	append(out, strings.empty() ? NULL : &strings[0], strings.size());
+	size_t total = 0;
+	for (size_t i = 0; i < files.size(); i++)
+		{
+			alignTo(out, ASSET_PACK_ALIGNMENT);
+			entries[i].offset = out.size();
+			entries[i].size = files[i].data.size();
+			entries[i].contentHash = assetPackHash(files[i].data.empty() ? NULL : &files[i].data[0], files[i].data.size());
+			append(out, files[i].data.empty() ? NULL : &files[i].data[0], files[i].data.size());
+			total += files[i].data.size();
+		}
+
+	memcpy(&out[0], &header, sizeof(header));
+	if (!entries.empty())
+		memcpy(&out[header.tocOffset], &entries[0], entries.size() * sizeof(AssetPackEntry));
+
+	FILE *handle = fopen(argv[1], "wb");
+	if (handle == NULL)
+		{
+			std::cout << "packer: can not write " << argv[1] << std::endl;
+			return 1;
+		}
+	bool written = fwrite(&out[0], 1, out.size(), handle) == out.size();
+	written = (fclose(handle) == 0) && written;
+	if (!written)
+		{
+			std::cout << "packer: can not write " << argv[1] << std::endl;
+			remove(argv[1]);
+			return 1;
+		}
+
+	std::cout << argv[1] << ": " << files.size() << " files, " << total / 1024 << " KB" << std::endl;
+	return 0;
+}
@@ -0,0 +1,468 @@
+#ifndef PORTAL_VISIBILITY_H
+#define PORTAL_VISIBILITY_H
+
+#include <glm/glm.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "frustum.h"
+#include "cpu_profiler.h"
+
+/* Name portals use for the space around the scene, a camera in no cell starts looking from there */
+#define SCENE_OUTSIDE "outside"
+/* Portals followed in a row from the camera cell, bounds the stack of view planes */
+#define PORTAL_MAX_DEPTH 32
+/* Portal steps one update() may take per portal of the scene. Every simple chain of portals is a separate
+	walk, which on a grid of rooms with lined up doorways grows exponentially, so past this the walk stops */
+#define PORTAL_VISITS_PER_PORTAL 4
+/* A portal the eye is closer to than this is stepped through as is, more than the 0.1 near plane of the
+	camera or the portal would be clipped away while the camera walks through it */
+#define PORTAL_EYE_DISTANCE 0.2f
+
+/* A room of the scene, an axis aligned box */
+struct SceneCell
+{
+	std::string name;
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+/* An axis aligned rectangle between two cells. One component of halfSize is 0, that axis is the
+	portal's normal. A cell of -1 is the outside */
+struct ScenePortal
+{
+	int cells[2];
+	glm::vec3 center;
+	glm::vec3 halfSize;
+};
+
+struct SceneDescription
+{
+	std::vector<SceneCell> cells;
+	std::vector<ScenePortal> portals;
+};
+
+/* "cell <name> <min x y z> <max x y z>" and "portal <cell> <cell> <centre x y z> <half size x y z>",
+	one per line, # starts a comment. Cells have to come before the portals naming them */
+inline bool loadScene(const char *path, SceneDescription &scene)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return false;
+
+	char line[512];
+	int lineNumber = 0;
+	bool valid = true;
+	while (valid && fgets(line, sizeof(line), file) != NULL)
+		{
+			lineNumber++;
+			char *comment = strchr(line, '#');
+			if (comment != NULL)
+				*comment = '\0';
+
+			char keyword[32];
+			char first[128];
+			char second[128];
+			glm::vec3 a;
+			glm::vec3 b;
+			if (sscanf(line, "%31s", keyword) != 1)
+				continue;
+
+			if (strcmp(keyword, "cell") == 0 && sscanf(line, "%*s %127s %f %f %f %f %f %f", first, &a.x, &a.y, &a.z, &b.x, &b.y, &b.z) == 7)
+				{
+					SceneCell cell;
+					cell.name = first;
+					cell.min = glm::min(a, b);
+					cell.max = glm::max(a, b);
+					scene.cells.push_back(cell);
+				}
+			else if (strcmp(keyword, "portal") == 0 && sscanf(line, "%*s %127s %127s %f %f %f %f %f %f", first, second, &a.x, &a.y, &a.z, &b.x, &b.y, &b.z) == 8)
+				{
+					ScenePortal portal;
+					portal.center = a;
+					portal.halfSize = glm::abs(b);
+					if ((portal.halfSize.x == 0.0f) + (portal.halfSize.y == 0.0f) + (portal.halfSize.z == 0.0f) != 1)
+						{
+							std::cout << "Scene " << path << ":" << lineNumber << ": a portal needs a half size of 0 along exactly one axis" << std::endl;
+							valid = false;
+						}
+					const char *names[2] = { first, second };
+					for (int side = 0; side < 2; side++)
+						{
+							portal.cells[side] = -1;
+							for (size_t c = 0; c < scene.cells.size(); c++)
+								if (scene.cells[c].name == names[side])
+									portal.cells[side] = (int)c;
+							if (portal.cells[side] < 0 && strcmp(names[side], SCENE_OUTSIDE) != 0)
+								{
+									std::cout << "Scene " << path << ":" << lineNumber << ": no cell named " << names[side] << std::endl;
+									valid = false;
+								}
+						}
+					scene.portals.push_back(portal);
+				}
+			else
+				{
+					std::cout << "Scene " << path << ":" << lineNumber << ": can not parse " << line << std::endl;
+					valid = false;
+				}
+		}
+	fclose(file);
+
+	return valid;
+}
+
+/* Whether a point is inside any cell, on the boundary counts */
+inline bool sceneContains(const SceneDescription &scene, glm::vec3 point)
+{
+	for (size_t c = 0; c < scene.cells.size(); c++)
+		if (glm::all(glm::greaterThanEqual(point, scene.cells[c].min)) && glm::all(glm::lessThanEqual(point, scene.cells[c].max)))
+			return true;
+	return false;
+}
+
+/* A straight corridor of cubic cells down the -z axis, open to the outside at both ends */
+inline SceneDescription makeCorridorScene(unsigned int segments, float length)
+{
+	SceneDescription scene;
+	float half = length / 2.0f;
+	for (unsigned int i = 0; i < segments; i++)
+		{
+			SceneCell cell;
+			cell.name = "segment" + std::to_string(i);
+			cell.min = glm::vec3(-half, -half, -length * i - half);
+			cell.max = glm::vec3(half, half, -length * i + half);
+			scene.cells.push_back(cell);
+		}
+	for (unsigned int i = 0; i <= segments; i++)
+		{
+			ScenePortal portal;
+			portal.cells[0] = i > 0 ? (int)i - 1 : -1;
+			portal.cells[1] = i < segments ? (int)i : -1;
+			portal.center = glm::vec3(0.0f, 0.0f, -length * i + half);
+			portal.halfSize = glm::vec3(half, half, 0.0f);
+			scene.portals.push_back(portal);
+		}
+
+	return scene;
+}
+
+/* Cells and portals of a scene, and the cells the camera can see into this frame. Starting from the
+	camera's cell, every portal inside the current view volume is followed into the next cell with the
+	view narrowed to the planes through the eye and the portal's edges, so a cell is only reached
+	through a chain of portals that are all in sight. Objects are registered with the cells their
+	bounding sphere overlaps and count as visible when any of those cells is.
+	The walk is capped at PORTAL_VISITS_PER_PORTAL steps per portal. A walk that runs out of steps is finished
+	conservatively: every cell reachable from the cells already found, through portals inside the camera
+	frustum, is marked visible as well. The cost stays linear in the size of the scene */
+class PortalVisibility
+{
+public:
+	/* 1 for every cell reached in the last update() */
+	std::vector<unsigned char> visible;
+
+	PortalVisibility() : cameraCell(-1), portalsPassed(0), cellsVisible(0), visitBudget(0), budgetSpent(false)
+		{
+		}
+
+	void build(const SceneDescription &description)
+		{
+			scene = description;
+			visible.assign(scene.cells.size(), 0);
+			onPath.assign(scene.cells.size() + 1, 0);
+			cellPortals.assign(scene.cells.size() + 1, std::vector<int>());
+			for (size_t p = 0; p < scene.portals.size(); p++)
+				for (int side = 0; side < 2; side++)
+					cellPortals[slot(scene.portals[p].cells[side])].push_back((int)p);
+			/* 6 frustum planes and 4 more for each portal in a row */
+			planes.reserve(6 + 4 * PORTAL_MAX_DEPTH);
+			visitBudget = (unsigned int)scene.portals.size() * PORTAL_VISITS_PER_PORTAL;
+			floodCells.reserve(scene.cells.size() + 1);
+		}
+
+	/* Register an object, returns the id for objectVisible() */
+	int addObject(glm::vec3 center, float radius)
+		{
+			objectCellStart.push_back((int)objectCells.size());
+			for (size_t c = 0; c < scene.cells.size(); c++)
+				{
+					/* Sphere against box: distance from the centre to the closest point of the box */
+					glm::vec3 closest = glm::clamp(center, scene.cells[c].min, scene.cells[c].max);
+					glm::vec3 offset = center - closest;
+					if (glm::dot(offset, offset) <= radius * radius)
+						objectCells.push_back((int)c);
+				}
+			objectCellEnd.push_back((int)objectCells.size());
+			return (int)objectCellStart.size() - 1;
+		}
+
+	/* Objects in no cell at all are always visible, the frustum test still applies to them */
+	bool objectVisible(int object) const
+		{
+			if (objectCellStart[object] == objectCellEnd[object])
+				return true;
+			for (int i = objectCellStart[object]; i < objectCellEnd[object]; i++)
+				if (visible[objectCells[i]])
+					return true;
+			return false;
+		}
+
+	/* Find the cells seen from eye through the frustum of the camera */
+	void update(glm::vec3 eye, const Frustum &frustum)
+		{
+			CPU_PROFILE_SCOPE("PortalVisibility::update");
+			for (size_t c = 0; c < visible.size(); c++)
+				visible[c] = 0;
+			portalsPassed = 0;
+			cellsVisible = 0;
+			budgetSpent = false;
+
+			planes.clear();
+			for (int i = 0; i < 6; i++)
+				{
+					Plane plane = { glm::vec3(frustum.normalX[i], frustum.normalY[i], frustum.normalZ[i]), frustum.distance[i] };
+					planes.push_back(plane);
+				}
+
+			cameraCell = findCell(eye);
+			/* Outside a scene nothing connects to, there is nothing to narrow the view with */
+			if (cameraCell < 0 && cellPortals[slot(-1)].empty())
+				{
+					for (size_t c = 0; c < visible.size(); c++)
+						visible[c] = 1;
+					cellsVisible = (unsigned int)visible.size();
+					return;
+				}
+			visit(cameraCell, eye, 0);
+			if (budgetSpent)
+				flood();
+		}
+
+	/* -1 when the camera is outside every cell */
+	int currentCell() const
+		{
+			return cameraCell;
+		}
+
+	unsigned int visibleCells() const
+		{
+			return cellsVisible;
+		}
+
+	/* Portals followed in the last update() */
+	unsigned int portalsFollowed() const
+		{
+			return portalsPassed;
+		}
+
+	/* The last update() ran out of steps and finished with the conservative flood */
+	bool overBudget() const
+		{
+			return budgetSpent;
+		}
+
+	size_t size() const
+		{
+			return scene.cells.size();
+		}
+
+private:
+	struct Plane
+	{
+		glm::vec3 normal;
+		float distance;
+	};
+
+	SceneDescription scene;
+	/* Portals of each cell, the last entry holds the ones of the outside */
+	std::vector<std::vector<int> > cellPortals;
+	/* The view volume of the portal chain being followed, one frustum plus 4 planes per portal */
+	std::vector<Plane> planes;
+	/* Cells on the portal chain being followed, a chain never enters the same cell twice */
+	std::vector<unsigned char> onPath;
+	/* Cells each object overlaps, objectCells[objectCellStart[i] .. objectCellEnd[i]) */
+	std::vector<int> objectCells;
+	std::vector<int> objectCellStart;
+	std::vector<int> objectCellEnd;
+	/* The queue of flood(), kept between frames */
+	std::vector<int> floodCells;
+	int cameraCell;
+	unsigned int portalsPassed;
+	unsigned int cellsVisible;
+	unsigned int visitBudget;
+	bool budgetSpent;
+
+	size_t slot(int cell) const
+		{
+			return cell < 0 ? scene.cells.size() : (size_t)cell;
+		}
+
+	/* The camera usually stays in its cell or moves to a neighbour, so those are tried before the rest */
+	int findCell(glm::vec3 point) const
+		{
+			if (cameraCell >= 0 && contains(cameraCell, point))
+				return cameraCell;
+			const std::vector<int> &neighbours = cellPortals[slot(cameraCell)];
+			for (size_t i = 0; i < neighbours.size(); i++)
+				{
+					const ScenePortal &portal = scene.portals[neighbours[i]];
+					for (int side = 0; side < 2; side++)
+						if (portal.cells[side] >= 0 && contains(portal.cells[side], point))
+							return portal.cells[side];
+				}
+			for (size_t c = 0; c < scene.cells.size(); c++)
+				if (contains((int)c, point))
+					return (int)c;
+			return -1;
+		}
+
+	bool contains(int cell, glm::vec3 point) const
+		{
+			const SceneCell &box = scene.cells[cell];
+			return glm::all(glm::greaterThanEqual(point, box.min)) && glm::all(glm::lessThanEqual(point, box.max));
+		}
+
+	void visit(int cell, glm::vec3 eye, int depth)
+		{
+			if (cell >= 0 && !visible[cell])
+				{
+					visible[cell] = 1;
+					cellsVisible++;
+				}
+			if (depth == PORTAL_MAX_DEPTH)
+				return;
+
+			onPath[slot(cell)] = 1;
+			const std::vector<int> &portals = cellPortals[slot(cell)];
+			for (size_t i = 0; i < portals.size(); i++)
+				{
+					const ScenePortal &portal = scene.portals[portals[i]];
+					int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+					/* Nothing is drawn outside the scene */
+					if (next < 0 || onPath[next])
+						continue;
+
+					glm::vec3 corners[4];
+					portalCorners(portal, corners);
+					bool doorway = inDoorway(portal, eye);
+					if (!doorway && !inside(corners))
+						continue;
+
+					if (portalsPassed == visitBudget)
+						{
+							budgetSpent = true;
+							break;
+						}
+					portalsPassed++;
+					size_t planeCount = planes.size();
+					if (!doorway)
+						narrow(portal, corners, eye);
+					visit(next, eye, depth + 1);
+					planes.resize(planeCount);
+				}
+			onPath[slot(cell)] = 0;
+		}
+
+	/* Breadth first from the camera cell and every cell visit() reached, through every portal in the camera
+		frustum. Each cell is queued once, so it never costs more than one look at every portal */
+	void flood()
+		{
+			floodCells.clear();
+			floodCells.push_back(cameraCell);
+			for (size_t c = 0; c < visible.size(); c++)
+				if (visible[c] && (int)c != cameraCell)
+					floodCells.push_back((int)c);
+			for (size_t q = 0; q < floodCells.size(); q++)
+				{
+					int cell = floodCells[q];
+					const std::vector<int> &portals = cellPortals[slot(cell)];
+					for (size_t i = 0; i < portals.size(); i++)
+						{
+							const ScenePortal &portal = scene.portals[portals[i]];
+							int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+							if (next < 0 || visible[next])
+								continue;
+							glm::vec3 corners[4];
+							portalCorners(portal, corners);
+							/* Only the camera frustum is left in planes once visit() has returned */
+							if (!inside(corners))
+								continue;
+							visible[next] = 1;
+							cellsVisible++;
+							floodCells.push_back(next);
+						}
+				}
+		}
+
+	/* The axis with no extent */
+	static int normalAxis(const ScenePortal &portal)
+		{
+			return portal.halfSize.x == 0.0f ? 0 : (portal.halfSize.y == 0.0f ? 1 : 2);
+		}
+
+	static void portalCorners(const ScenePortal &portal, glm::vec3 corners[4])
+		{
+			/* The two axes the rectangle spans */
+			int normal = normalAxis(portal);
+			int u = (normal + 1) % 3;
+			int v = (normal + 2) % 3;
+			static const float signs[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+			for (int i = 0; i < 4; i++)
+				{
+					corners[i] = portal.center;
+					corners[i][u] += signs[i][0] * portal.halfSize[u];
+					corners[i][v] += signs[i][1] * portal.halfSize[v];
+				}
+		}
+
+	/* The eye is in the opening, the view through it is the whole view */
+	static bool inDoorway(const ScenePortal &portal, glm::vec3 eye)
+		{
+			glm::vec3 offset = glm::abs(eye - portal.center);
+			int axis = normalAxis(portal);
+			for (int i = 0; i < 3; i++)
+				if (i == axis ? offset[i] >= PORTAL_EYE_DISTANCE : offset[i] > portal.halfSize[i])
+					return false;
+			return true;
+		}
+
+	/* false when every corner is behind one of the planes */
+	bool inside(const glm::vec3 corners[4]) const
+		{
+			for (size_t p = 0; p < planes.size(); p++)
+				{
+					int behind = 0;
+					for (int i = 0; i < 4; i++)
+						if (glm::dot(planes[p].normal, corners[i]) + planes[p].distance < 0.0f)
+							behind++;
+					if (behind == 4)
+						return false;
+				}
+			return true;
+		}
+
+	/* Add the planes through the eye and each edge of the portal, facing its centre */
+	void narrow(const ScenePortal &portal, const glm::vec3 corners[4], glm::vec3 eye)
+		{
+			for (int i = 0; i < 4; i++)
+				{
+					glm::vec3 normal = glm::cross(corners[i] - eye, corners[(i + 1) % 4] - eye);
+					float length = glm::length(normal);
+					if (length == 0.0f)
+						continue;
+					Plane plane = { normal / length, 0.0f };
+					plane.distance = -glm::dot(plane.normal, eye);
+					if (glm::dot(plane.normal, portal.center) + plane.distance < 0.0f)
+						{
+							plane.normal = -plane.normal;
+							plane.distance = -plane.distance;
+						}
+					planes.push_back(plane);
+				}
+		}
+};
+#endif
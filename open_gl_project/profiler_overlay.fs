@@ -0,0 +1,16 @@
+#version 460 core
+out vec4 FragColor;
+
+in vec2 Glyph;
+in vec4 Colour;
+
+/* one row of glyphs, coverage in the red channel */
+layout (binding = 0) uniform sampler2D font;
+
+void main()
+{
+	float coverage = Glyph.x < 0.0 ? 1.0 : texelFetch(font, ivec2(Glyph), 0).r;
+	if (coverage == 0.0)
+		discard;
+	FragColor = vec4(Colour.rgb, Colour.a * coverage);
+}
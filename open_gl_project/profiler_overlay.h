@@ -0,0 +1,186 @@
+#ifndef PROFILER_OVERLAY_H
+#define PROFILER_OVERLAY_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "shader_s.h"
+#include "stream_ring.h"
+#include "geometry_manager.h"
+#include "gpu_profiler.h"
+#include "overlay_font.h"
+#include "cpu_profiler.h"
+
+/* Characters of a row of the overlay, the scope name is cut to fit */
+#define PROFILER_OVERLAY_COLUMNS 34
+/* Rows below the title, scopes past the last one are not shown */
+#define PROFILER_OVERLAY_ROWS 40
+/* A bar this long is one 60 Hz frame of GPU time */
+#define PROFILER_OVERLAY_BAR_WIDTH 200.0f
+#define PROFILER_OVERLAY_BUDGET_MS (1000.0f / 60.0f)
+
+/* One corner of a glyph or rectangle: pixel position, font texel (x < 0 for none) and colour */
+struct OverlayVertex
+{
+	glm::vec2 position;
+	glm::vec2 glyph;
+	glm::vec4 colour;
+};
+
+/* Draws the rolling averages of a GpuProfiler over the top left corner of the window: every scope's
+	name indented by its nesting, its average in milliseconds and a bar against the 60 Hz frame budget.
+	The quads are written straight into the StreamRing each frame and drawn in one call */
+class ProfilerOverlay
+{
+public:
+	ProfilerOverlay(Shader &program, StreamRing &ring) : program(program), ring(ring)
+		{
+			screenSizeUniform = program.uniform("screenSize");
+
+			/* The glyphs side by side in one row, one byte of coverage per texel */
+			unsigned char atlas[OVERLAY_FONT_HEIGHT][OVERLAY_FONT_COUNT * OVERLAY_FONT_WIDTH];
+			for (int glyph = 0; glyph < OVERLAY_FONT_COUNT; glyph++)
+				for (int y = 0; y < OVERLAY_FONT_HEIGHT; y++)
+					for (int x = 0; x < OVERLAY_FONT_WIDTH; x++)
+						atlas[y][glyph * OVERLAY_FONT_WIDTH + x] = (OVERLAY_FONT[glyph][y] >> (OVERLAY_FONT_WIDTH - 1 - x)) & 1 ? 255 : 0;
+			glGenTextures(1, &fontTexture);
+			glBindTexture(GL_TEXTURE_2D, fontTexture);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, OVERLAY_FONT_COUNT * OVERLAY_FONT_WIDTH, OVERLAY_FONT_HEIGHT);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, OVERLAY_FONT_COUNT * OVERLAY_FONT_WIDTH, OVERLAY_FONT_HEIGHT, GL_RED, GL_UNSIGNED_BYTE, atlas);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			VertexAttribute attributes[] = { { 0, 2, 0 }, { 1, 2, 2 }, { 2, 4, 4 } };
+			VAO = ring.makeVertexArray(attributes, 3, 0);
+		}
+
+	/* Most of a ring region one frame of the overlay takes, to add to StreamRing::create() */
+	static GLsizeiptr frameBytes()
+		{
+			/* The background, two lines of text on the title row and a line, a bar and a budget mark on every other */
+			GLsizeiptr quads = 1 + 2 * PROFILER_OVERLAY_COLUMNS + PROFILER_OVERLAY_ROWS * (PROFILER_OVERLAY_COLUMNS + 2);
+			return quads * 6 * sizeof(OverlayVertex) + STREAM_RING_ALIGNMENT;
+		}
+
+	void draw(const GpuProfiler &profiler, int width, int height)
+		{
+			CPU_PROFILE_SCOPE("ProfilerOverlay::draw");
+			int rows = 0;
+			for (size_t i = 0; i < profiler.scopes.size() && rows < PROFILER_OVERLAY_ROWS; i++)
+				if (profiler.isCurrent(profiler.scopes[i]))
+					rows++;
+
+			GLintptr offset;
+			OverlayVertex *vertices = (OverlayVertex *)ring.allocate(frameBytes(), offset);
+			if (vertices == NULL)
+				return;
+			count = 0;
+
+			const float left = 8.0f;
+			const float top = 8.0f;
+			const float lineHeight = OVERLAY_FONT_HEIGHT + 2.0f;
+			const float barLeft = left + (PROFILER_OVERLAY_COLUMNS + 1) * OVERLAY_FONT_WIDTH;
+			rectangle(vertices, left - 4.0f, top - 4.0f, barLeft + PROFILER_OVERLAY_BAR_WIDTH + 12.0f, top + (rows + 1) * lineHeight + 2.0f,
+				glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+
+			char line[PROFILER_OVERLAY_COLUMNS + 1];
+			snprintf(line, sizeof(line), "GPU ms, %d frame average", GPU_PROFILER_WINDOW);
+			text(vertices, left, top, line, glm::vec4(1.0f));
+			if (profiler.dropped() > 0)
+				{
+					snprintf(line, sizeof(line), "%u late", profiler.dropped());
+					text(vertices, barLeft, top, line, glm::vec4(1.0f, 0.5f, 0.5f, 1.0f));
+				}
+
+			float y = top + lineHeight;
+			int shown = 0;
+			for (size_t i = 0; i < profiler.scopes.size() && shown < rows; i++)
+				{
+					const GpuScopeStats &scope = profiler.scopes[i];
+					if (!profiler.isCurrent(scope))
+						continue;
+					float milliseconds = (float)scope.average();
+					glm::vec4 colour = palette(i);
+
+					/* Name indented two characters per nesting level, the time right aligned after it */
+					int indent = scope.depth * 2;
+					snprintf(line, sizeof(line), "%*s%-*.*s%8.3f", indent, "", PROFILER_OVERLAY_COLUMNS - 8 - indent,
+						PROFILER_OVERLAY_COLUMNS - 9 - indent, scope.name.c_str(), milliseconds);
+					text(vertices, left, y, line, glm::vec4(1.0f));
+
+					float barWidth = glm::min(milliseconds / PROFILER_OVERLAY_BUDGET_MS, 1.0f) * PROFILER_OVERLAY_BAR_WIDTH;
+					rectangle(vertices, barLeft, y + 2.0f, barLeft + glm::max(barWidth, 1.0f), y + OVERLAY_FONT_HEIGHT - 1.0f, colour);
+					rectangle(vertices, barLeft + PROFILER_OVERLAY_BAR_WIDTH, y, barLeft + PROFILER_OVERLAY_BAR_WIDTH + 1.0f, y + lineHeight,
+						glm::vec4(1.0f, 1.0f, 1.0f, 0.5f));
+					y += lineHeight;
+					shown++;
+				}
+
+			/* Over everything, blended, and with the state the rest of the frame expects put back */
+			glDisable(GL_DEPTH_TEST);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			program.use();
+			program.setVec2(screenSizeUniform, glm::vec2((float)width, (float)height));
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, fontTexture);
+			glBindVertexArray(VAO);
+			glBindVertexBuffer(STREAM_RING_VERTEX_BINDING, ring.buffer(), offset, sizeof(OverlayVertex));
+			glDrawArrays(GL_TRIANGLES, 0, count);
+			glDisable(GL_BLEND);
+			glEnable(GL_DEPTH_TEST);
+		}
+
+private:
+	Shader &program;
+	StreamRing &ring;
+	GLint screenSizeUniform;
+	unsigned int fontTexture;
+	unsigned int VAO;
+	/* Vertices written this frame */
+	GLsizei count;
+
+	static glm::vec4 palette(size_t index)
+		{
+			static const glm::vec4 colours[6] = {
+				glm::vec4(0.35f, 0.75f, 1.0f, 1.0f), glm::vec4(1.0f, 0.65f, 0.25f, 1.0f), glm::vec4(0.5f, 0.9f, 0.4f, 1.0f),
+				glm::vec4(0.95f, 0.45f, 0.6f, 1.0f), glm::vec4(0.8f, 0.6f, 1.0f, 1.0f), glm::vec4(1.0f, 0.9f, 0.35f, 1.0f)
+			};
+			return colours[index % 6];
+		}
+
+	void quad(OverlayVertex *vertices, float x0, float y0, float x1, float y1, float u0, float v0, float u1, float v1, glm::vec4 colour)
+		{
+			OverlayVertex corners[4] = {
+				{ glm::vec2(x0, y0), glm::vec2(u0, v0), colour }, { glm::vec2(x1, y0), glm::vec2(u1, v0), colour },
+				{ glm::vec2(x1, y1), glm::vec2(u1, v1), colour }, { glm::vec2(x0, y1), glm::vec2(u0, v1), colour }
+			};
+			static const int order[6] = { 0, 1, 2, 0, 2, 3 };
+			for (int i = 0; i < 6; i++)
+				vertices[count++] = corners[order[i]];
+		}
+
+	void rectangle(OverlayVertex *vertices, float x0, float y0, float x1, float y1, glm::vec4 colour)
+		{
+			quad(vertices, x0, y0, x1, y1, -1.0f, -1.0f, -1.0f, -1.0f, colour);
+		}
+
+	void text(OverlayVertex *vertices, float x, float y, const char *characters, glm::vec4 colour)
+		{
+			for (int i = 0; characters[i] != '\0'; i++, x += OVERLAY_FONT_WIDTH)
+				{
+					int glyph = (unsigned char)characters[i] - OVERLAY_FONT_FIRST;
+					if (glyph <= 0 || glyph >= OVERLAY_FONT_COUNT)
+						continue;
+					float u = (float)(glyph * OVERLAY_FONT_WIDTH);
+					quad(vertices, x, y, x + OVERLAY_FONT_WIDTH, y + OVERLAY_FONT_HEIGHT, u, 0.0f, u + OVERLAY_FONT_WIDTH, (float)OVERLAY_FONT_HEIGHT, colour);
+				}
+		}
+};
+#endif
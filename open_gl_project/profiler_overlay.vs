@@ -0,0 +1,19 @@
+#version 460 core
+/* position in pixels from the top left corner of the window */
+layout (location = 0) in vec2 aPos;
+/* texel of the font atlas, negative for a plain coloured rectangle */
+layout (location = 1) in vec2 aGlyph;
+layout (location = 2) in vec4 aColour;
+
+out vec2 Glyph;
+out vec4 Colour;
+
+uniform vec2 screenSize;
+
+void main()
+{
+	Glyph = aGlyph;
+	Colour = aColour;
+	vec2 ndc = aPos / screenSize * 2.0 - 1.0;
+	gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+}
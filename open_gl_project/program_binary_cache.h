@@ -0,0 +1,187 @@
+#ifndef PROGRAM_BINARY_CACHE_H
+#define PROGRAM_BINARY_CACHE_H
+
+#include "glad.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+#include "shader_s.h"
+
+#define PROGRAM_BINARY_MAGIC "PBIN"
+#define PROGRAM_BINARY_VERSION 1
+
+/* Written in front of every binary, everything in it has to match before the binary is handed to the driver */
+struct ProgramBinaryHeader
+{
+	char magic[4];
+	uint32_t version;
+	/* Hash of the program's cache key, which includes the source hash */
+	uint64_t sourceHash;
+	/* Hash of GL_VENDOR, GL_RENDERER and GL_VERSION */
+	uint64_t driverHash;
+	uint32_t format;
+	uint32_t length;
+};
+
+/* Linked programs saved to disk with glGetProgramBinary and loaded back with glProgramBinary on the next launch.
+	One file per program, named "<key hash>-<driver hash>.bin", so a driver update or a different GPU simply
+	misses the cache and the program is compiled from source again. Binaries of any other driver are deleted
+	when the cache opens, and a binary that fails its checks is deleted before it is rebuilt */
+class ProgramBinaryCache
+{
+public:
+	/* False when the driver offers no binary formats or the directory can not be created */
+	bool enabled;
+
+	ProgramBinaryCache(const std::string &directory) : enabled(false), directory(directory)
+		{
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			if (formats <= 0)
+				return;
+
+			if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+				return;
+
+			driverHash = hashString(glString(GL_VENDOR), FNV_OFFSET);
+			driverHash = hashString(glString(GL_RENDERER), driverHash);
+			driverHash = hashString(glString(GL_VERSION), driverHash);
+			enabled = true;
+			removeStale();
+		}
+
+	/* Fill shader from the cached binary of key, false on a miss or when the binary is rejected */
+	bool load(const std::string &key, Shader &shader) const
+		{
+			if (!enabled)
+				return false;
+
+			uint64_t sourceHash = hashString(key, FNV_OFFSET);
+			std::string filePath = path(sourceHash);
+			FILE *file = fopen(filePath.c_str(), "rb");
+			if (file == NULL)
+				return false;
+
+			ProgramBinaryHeader header;
+			std::vector<char> binary;
+			bool valid = fread(&header, sizeof(header), 1, file) == 1
+				&& memcmp(header.magic, PROGRAM_BINARY_MAGIC, 4) == 0
+				&& header.version == PROGRAM_BINARY_VERSION
+				&& header.sourceHash == sourceHash
+				&& header.driverHash == driverHash
+				&& header.length > 0;
+			if (valid)
+				{
+					binary.resize(header.length);
+					valid = fread(&binary[0], 1, header.length, file) == header.length;
+				}
+			fclose(file);
+
+			if (!valid || !shader.loadBinary(header.format, &binary[0], (GLsizei)header.length))
+				{
+					/* Unusable, the source compile that follows writes a new one */
+					remove(filePath.c_str());
+					return false;
+				}
+			return true;
+		}
+
+	/* Save the linked binary of shader under key, shader has to be built with retrievableBinary set */
+	void store(const std::string &key, const Shader &shader) const
+		{
+			if (!enabled || !shader.isLinked())
+				return;
+
+			GLint length = 0;
+			glGetProgramiv(shader.ID, GL_PROGRAM_BINARY_LENGTH, &length);
+			if (length <= 0)
+				return;
+
+			std::vector<char> binary(length);
+			GLenum format = 0;
+			GLsizei written = 0;
+			glGetProgramBinary(shader.ID, length, &written, &format, &binary[0]);
+			if (written <= 0)
+				return;
+
+			ProgramBinaryHeader header;
+			memcpy(header.magic, PROGRAM_BINARY_MAGIC, 4);
+			header.version = PROGRAM_BINARY_VERSION;
+			header.sourceHash = hashString(key, FNV_OFFSET);
+			header.driverHash = driverHash;
+			header.format = format;
+			header.length = (uint32_t)written;
+
+			/* Write to a temporary name first so a crash never leaves a half written binary behind */
+			std::string finalPath = path(header.sourceHash);
+			std::string tempPath = finalPath + ".tmp";
+			FILE *file = fopen(tempPath.c_str(), "wb");
+			if (file == NULL)
+				return;
+			bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+				&& fwrite(&binary[0], 1, written, file) == (size_t)written;
+			ok = (fclose(file) == 0) && ok;
+			if (ok)
+				rename(tempPath.c_str(), finalPath.c_str());
+			else
+				remove(tempPath.c_str());
+		}
+
+	/* FNV-1a, shared with ShaderCache so both agree on what a source hash is */
+	static const uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+	static uint64_t hashString(const std::string &text, uint64_t hash)
+		{
+			for (size_t i = 0; i < text.size(); i++)
+				{
+					hash ^= (unsigned char)text[i];
+					hash *= 0x100000001b3ull;
+				}
+			return hash;
+		}
+
+private:
+	std::string directory;
+	uint64_t driverHash;
+
+	std::string path(uint64_t sourceHash) const
+		{
+			char name[48];
+			snprintf(name, sizeof(name), "%016llx-%016llx.bin", (unsigned long long)sourceHash, (unsigned long long)driverHash);
+			return directory + "/" + name;
+		}
+
+	/* Delete every binary not built by this driver, including ones named before the driver hash was in the name */
+	void removeStale() const
+		{
+			DIR *dir = opendir(directory.c_str());
+			if (dir == NULL)
+				return;
+			char suffix[32];
+			snprintf(suffix, sizeof(suffix), "-%016llx.bin", (unsigned long long)driverHash);
+			size_t suffixLength = strlen(suffix);
+			while (struct dirent *entry = readdir(dir))
+				{
+					size_t length = strlen(entry->d_name);
+					bool binary = length > 4 && strcmp(entry->d_name + length - 4, ".bin") == 0;
+					bool current = length > suffixLength && strcmp(entry->d_name + length - suffixLength, suffix) == 0;
+					if (binary && !current)
+						remove((directory + "/" + entry->d_name).c_str());
+				}
+			closedir(dir);
+		}
+
+	static std::string glString(GLenum name)
+		{
+			const GLubyte *value = glGetString(name);
+			return value != NULL ? std::string((const char *)value) : std::string();
+		}
+};
+#endif
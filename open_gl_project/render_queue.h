@@ -0,0 +1,257 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+#include "exhibit.h"
+#include "gpu_profiler.h"
+#include "cpu_profiler.h"
+
+/* Texture units whose bindings are tracked by GLStateCache */
+#define STATE_CACHE_TEXTURE_UNITS 16
+
+/* Only used by the 64 bit sort key, distances past the far plane all land in the last bucket */
+#define RENDER_QUEUE_FAR_PLANE 100.0f
+
+/* Bind calls made through GLStateCache during one frame, issued went to GL and avoided matched the current state */
+struct StateChangeStats
+{
+	unsigned int programsIssued;
+	unsigned int programsAvoided;
+	unsigned int vertexArraysIssued;
+	unsigned int vertexArraysAvoided;
+	unsigned int texturesIssued;
+	unsigned int texturesAvoided;
+	unsigned int otherIssued;
+	unsigned int otherAvoided;
+
+	unsigned int avoided() const
+		{
+			return programsAvoided + vertexArraysAvoided + texturesAvoided + otherAvoided;
+		}
+
+	unsigned int issued() const
+		{
+			return programsIssued + vertexArraysIssued + texturesIssued + otherIssued;
+		}
+};
+
+/* A shadow copy of the GL binding state, a bind is only passed on to GL when it changes something.
+	Code that binds behind the cache's back has to call invalidate() before going through it again */
+class GLStateCache
+{
+public:
+	StateChangeStats stats;
+
+	GLStateCache()
+		{
+			stats = StateChangeStats();
+			invalidate();
+		}
+
+	/* Forget the shadow state, the next bind of every kind will reach GL */
+	void invalidate()
+		{
+			program = UNKNOWN;
+			vertexArray = UNKNOWN;
+			activeUnit = UNKNOWN;
+			polygonMode = UNKNOWN;
+			for (int i = 0; i < STATE_CACHE_TEXTURE_UNITS; i++)
+				textures[i] = UNKNOWN;
+		}
+
+	void resetStats()
+		{
+			stats = StateChangeStats();
+		}
+
+	void useProgram(unsigned int ID)
+		{
+			if (program == ID)
+				{
+					stats.programsAvoided++;
+					return;
+				}
+			glUseProgram(ID);
+			program = ID;
+			stats.programsIssued++;
+		}
+
+	void bindVertexArray(unsigned int VAO)
+		{
+			if (vertexArray == VAO)
+				{
+					stats.vertexArraysAvoided++;
+					return;
+				}
+			glBindVertexArray(VAO);
+			vertexArray = VAO;
+			stats.vertexArraysIssued++;
+		}
+
+	/* Both glActiveTexture and glBindTexture are skipped when the unit already holds the texture */
+	void bindTexture2D(int unit, unsigned int texture)
+		{
+			if (textures[unit] == texture)
+				{
+					stats.texturesAvoided++;
+					return;
+				}
+			if (activeUnit != (unsigned int)unit)
+				{
+					glActiveTexture(GL_TEXTURE0 + unit);
+					activeUnit = unit;
+				}
+			glBindTexture(GL_TEXTURE_2D, texture);
+			textures[unit] = texture;
+			stats.texturesIssued++;
+		}
+
+	void setPolygonMode(GLenum mode)
+		{
+			if (polygonMode == mode)
+				{
+					stats.otherAvoided++;
+					return;
+				}
+			glPolygonMode(GL_FRONT_AND_BACK, mode);
+			polygonMode = mode;
+			stats.otherIssued++;
+		}
+
+private:
+	static const unsigned int UNKNOWN = 0xFFFFFFFFu;
+
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int activeUnit;
+	unsigned int polygonMode;
+	unsigned int textures[STATE_CACHE_TEXTURE_UNITS];
+};
+
+/* One draw of one exhibit, everything that depends on the frame is resolved when it is queued */
+struct DrawPacket
+{
+	/* From most to least significant: program 12 bits, VAO 12, texture unit 0 12, texture unit 1 12, depth 16.
+		GL names wider than their field wrap around, which only costs sort quality, never correctness */
+	uint64_t key;
+	const Exhibit *exhibit;
+	int state;
+	glm::mat4 model;
+};
+
+inline uint64_t makeSortKey(unsigned int program, unsigned int VAO, unsigned int texture0, unsigned int texture1, float depth)
+{
+	/* Front to back inside a state bucket so the depth test rejects more fragments */
+	float normalized = std::min(std::max(depth / RENDER_QUEUE_FAR_PLANE, 0.0f), 1.0f);
+	uint64_t depthBits = (uint64_t)(normalized * 65535.0f);
+
+	return ((uint64_t)(program & 0xFFF) << 52)
+		| ((uint64_t)(VAO & 0xFFF) << 40)
+		| ((uint64_t)(texture0 & 0xFFF) << 28)
+		| ((uint64_t)(texture1 & 0xFFF) << 16)
+		| depthBits;
+}
+
+inline bool packetKeyLess(const DrawPacket &a, const DrawPacket &b)
+{
+	return a.key < b.key;
+}
+
+/* Collects the draws of a frame, sorts them by state and submits them through a GLStateCache */
+class RenderQueue
+{
+public:
+	std::vector<DrawPacket> packets;
+
+	void clear()
+		{
+			packets.clear();
+		}
+
+	/* Queue every exhibit of the table, eye is the camera position used for the depth part of the key */
+	void push(const std::vector<Exhibit> &exhibits, double time, glm::vec3 eye)
+		{
+			for (size_t i = 0; i < exhibits.size(); i++)
+				push(exhibits[i], time, eye);
+		}
+
+	void push(const Exhibit &exhibit, double time, glm::vec3 eye)
+		{
+			DrawPacket packet;
+			packet.exhibit = &exhibit;
+			packet.state = exhibitState(exhibit);
+			packet.model = exhibitModelMatrix(exhibit, time);
+
+			unsigned int texture0 = exhibit.textureCount > 0 ? exhibit.textures[packet.state][0] : 0;
+			unsigned int texture1 = exhibit.textureCount > 1 ? exhibit.textures[packet.state][1] : 0;
+			float depth = glm::length(exhibit.position - eye);
+			packet.key = makeSortKey(exhibit.program->ID, exhibit.mesh.VAO, texture0, texture1, depth);
+
+			packets.push_back(packet);
+		}
+
+	void sort()
+		{
+			CPU_PROFILE_SCOPE("RenderQueue::sort");
+			/* Stable so packets with equal keys keep the table order */
+			std::stable_sort(packets.begin(), packets.end(), packetKeyLess);
+		}
+
+	/* The rest of the frame binds without the cache, so its shadow state is dropped on the way in.
+		With a profiler every exhibit's draw is timed as a scope of its name */
+	void submit(GLStateCache &state, double time, GpuProfiler *profiler = NULL) const
+		{
+			CPU_PROFILE_SCOPE("RenderQueue::submit");
+			state.invalidate();
+
+			for (size_t i = 0; i < packets.size(); i++)
+				{
+					const DrawPacket &packet = packets[i];
+					const Exhibit &exhibit = *packet.exhibit;
+
+					state.useProgram(exhibit.program->ID);
+					state.bindVertexArray(exhibit.mesh.VAO);
+
+					/* Exhibits whose vertex colours follow the interaction state read them from the ring,
+						only written when this frame's region still holds another state */
+					if (exhibit.vertices != NULL)
+						{
+							GLintptr offset = streamDynamicVertices(*exhibit.vertices, packet.state);
+							glBindVertexBuffer(STREAM_RING_VERTEX_BINDING, exhibit.vertices->ring->buffer(), offset, exhibit.vertices->stride);
+						}
+
+					for (int t = 0; t < exhibit.textureCount; t++)
+						state.bindTexture2D(t, exhibit.textures[packet.state][t]);
+
+					if (exhibit.prepare != NULL)
+						exhibit.prepare(exhibit, packet.state, time);
+
+					exhibit.program->setMat4(exhibit.modelUniform, packet.model);
+
+					/* Wireframe only applies to this exhibit */
+					bool wireframe = exhibit.wireframe != NULL && *exhibit.wireframe != 0;
+					state.setPolygonMode(wireframe ? GL_LINE : GL_FILL);
+
+					if (profiler != NULL)
+						profiler->begin(exhibit.name);
+					/* Meshes share their format's buffers, the offsets pick this one out */
+					if (exhibit.mesh.indexed)
+						glDrawElementsBaseVertex(GL_TRIANGLES, exhibit.mesh.count, GL_UNSIGNED_INT,
+							(void*)(exhibit.mesh.firstIndex * sizeof(unsigned int)), exhibit.mesh.baseVertex);
+					else
+						glDrawArrays(GL_TRIANGLES, exhibit.mesh.baseVertex, exhibit.mesh.count);
+					if (profiler != NULL)
+						profiler->end();
+				}
+
+			/* Leave filled polygons for the corridor */
+			state.setPolygonMode(GL_FILL);
+		}
+};
+#endif
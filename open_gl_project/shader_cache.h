@@ -0,0 +1,189 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <memory>
+#include <iostream>
+#include <chrono>
+
+#include "shader_s.h"
+#include "program_binary_cache.h"
+#include "asset_pack.h"
+
+/* Builds each distinct program once and hands out references to it.
+	A program is identified by its source paths, the preprocessor defines injected into it and a hash of the
+	final source, so two requests for the same files share one program while an edited file gets a new one.
+	With a binary directory, programs not seen yet this run are first looked up on disk. With an asset pack,
+	sources are read from the pack and only files missing from it from disk */
+class ShaderCache
+{
+public:
+	/* Requests made, programs compiled and linked from source and programs loaded from a saved binary */
+	unsigned int requests;
+	unsigned int builds;
+	unsigned int binaryLoads;
+	/* Time spent in get(), which is the whole shader part of startup */
+	double milliseconds;
+
+	/* binaryDirectory is where linked program binaries are kept between launches, nullptr to always compile.
+		pack has to outlive the cache */
+	ShaderCache(const char *binaryDirectory = nullptr, const AssetPack *pack = nullptr) : requests(0), builds(0), binaryLoads(0), milliseconds(0.0), pack(pack)
+		{
+			if (binaryDirectory != nullptr)
+				binaries.reset(new ProgramBinaryCache(binaryDirectory));
+		}
+
+	/* defines is a list of "#define ..." lines placed right after the #version line of every stage.
+		The returned reference stays valid for as long as the cache lives */
+	Shader &get(const char *vertexPath, const char *fragmentPath, const char *geometryPath = nullptr, const std::string &defines = "")
+		{
+			requests++;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			std::string vertexCode = injectDefines(readSource(vertexPath), defines);
+			std::string fragmentCode = injectDefines(readSource(fragmentPath), defines);
+			std::string geometryCode;
+			if (geometryPath != nullptr)
+				geometryCode = injectDefines(readSource(geometryPath), defines);
+
+			uint64_t hash = ProgramBinaryCache::hashString(vertexCode, ProgramBinaryCache::FNV_OFFSET);
+			hash = ProgramBinaryCache::hashString(fragmentCode, hash);
+			hash = ProgramBinaryCache::hashString(geometryCode, hash);
+
+			std::string key = makeKey(vertexPath, fragmentPath, geometryPath, defines, hash);
+			std::map<std::string, std::unique_ptr<Shader> >::iterator it = programs.find(key);
+			if (it != programs.end())
+				{
+					addTime(start);
+					return *it->second;
+				}
+
+			Shader *shader = new Shader();
+			if (binaries && binaries->load(key, *shader))
+				{
+					binaryLoads++;
+				}
+			else
+				{
+					/* Missing, stale or rejected binary, compile from source and refresh the saved copy */
+					shader->build(vertexCode.c_str(), fragmentCode.c_str(), geometryPath != nullptr ? geometryCode.c_str() : nullptr, binaries != nullptr);
+					builds++;
+					if (binaries)
+						binaries->store(key, *shader);
+				}
+			programs[key] = std::unique_ptr<Shader>(shader);
+
+			addTime(start);
+			return *shader;
+		}
+
+	/* The same for a compute program */
+	Shader &getCompute(const char *computePath, const std::string &defines = "")
+		{
+			requests++;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			std::string computeCode = injectDefines(readSource(computePath), defines);
+			uint64_t hash = ProgramBinaryCache::hashString(computeCode, ProgramBinaryCache::FNV_OFFSET);
+
+			/* No vertex stage, so the key can not collide with one of get() */
+			std::string key = makeKey("", computePath, nullptr, defines, hash);
+			std::map<std::string, std::unique_ptr<Shader> >::iterator it = programs.find(key);
+			if (it != programs.end())
+				{
+					addTime(start);
+					return *it->second;
+				}
+
+			Shader *shader = new Shader();
+			if (binaries && binaries->load(key, *shader))
+				{
+					binaryLoads++;
+				}
+			else
+				{
+					shader->buildCompute(computeCode.c_str(), binaries != nullptr);
+					builds++;
+					if (binaries)
+						binaries->store(key, *shader);
+				}
+			programs[key] = std::unique_ptr<Shader>(shader);
+
+			addTime(start);
+			return *shader;
+		}
+
+	/* Free every program, references handed out before are no longer valid */
+	void clear()
+		{
+			for (std::map<std::string, std::unique_ptr<Shader> >::iterator it = programs.begin(); it != programs.end(); ++it)
+				glDeleteProgram(it->second->ID);
+			programs.clear();
+		}
+
+	void printStats() const
+		{
+			std::cout << "Shader cache: " << programs.size() << " programs for " << requests << " requests, "
+				<< binaryLoads << " loaded from binaries, " << builds << " compiled, " << milliseconds << " ms" << std::endl;
+		}
+
+private:
+	std::map<std::string, std::unique_ptr<Shader> > programs;
+
+	std::unique_ptr<ProgramBinaryCache> binaries;
+	const AssetPack *pack;
+
+	/* Copied out of the mapping, defines get spliced in and GL wants null terminated strings anyway */
+	std::string readSource(const char *path) const
+		{
+			AssetView view;
+			if (pack != nullptr && pack->find(path, view))
+				return std::string((const char *)view.data, view.size);
+			return Shader::readSource(path);
+		}
+
+	void addTime(std::chrono::steady_clock::time_point start)
+		{
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			milliseconds += elapsed.count();
+		}
+
+	static std::string makeKey(const char *vertexPath, const char *fragmentPath, const char *geometryPath, const std::string &defines, uint64_t hash)
+		{
+			std::string key = vertexPath;
+			key += '|';
+			key += fragmentPath;
+			key += '|';
+			if (geometryPath != nullptr)
+				key += geometryPath;
+			key += '|';
+			key += defines;
+			key += '|';
+			key += std::to_string(hash);
+			return key;
+		}
+
+	/* GLSL wants #version first, so the defines go on the line after it */
+	static std::string injectDefines(const std::string &code, const std::string &defines)
+		{
+			if (defines.empty())
+				return code;
+
+			std::string block = defines;
+			if (block[block.size() - 1] != '\n')
+				block += '\n';
+
+			if (code.compare(0, 8, "#version") == 0)
+				{
+					size_t lineEnd = code.find('\n');
+					if (lineEnd == std::string::npos)
+						return code + "\n" + block;
+					return code.substr(0, lineEnd + 1) + block + code.substr(lineEnd + 1);
+				}
+
+			return block + code;
+		}
+};
+#endif
@@ -8,6 +8,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
 
 class Shader
 {
@@ -17,47 +18,48 @@ public:
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
     {
         /* 1. retrieve the vertex/fragment source code from filePath */
-        std::string vertexCode;
-        std::string fragmentCode;
+        std::string vertexCode = readSource(vertexPath);
+        std::string fragmentCode = readSource(fragmentPath);
         std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
+        // if geometry shader path is present, also load a geometry shader
+        if(geometryPath != nullptr)
+            geometryCode = readSource(geometryPath);
+        build(vertexCode.c_str(), fragmentCode.c_str(), geometryPath != nullptr ? geometryCode.c_str() : nullptr);
+    }
+    /* an empty program, filled in later with build(), used by ShaderCache which reads the sources itself */
+    Shader() : ID(0)
+    {
+    }
+    // read a whole shader file, an empty string is returned when it can not be read
+    // ------------------------------------------------------------------------
+    static std::string readSource(const char* path)
+    {
+        std::ifstream shaderFile;
         /* ensure ifstream objects can throw exceptions: */
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        shaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
         try 
         {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
+            // open file
+            shaderFile.open(path);
+            std::stringstream shaderStream;
+            // read file's buffer contents into stream
+            shaderStream << shaderFile.rdbuf();
+            // close file handler
+            shaderFile.close();
             // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
+            return shaderStream.str();
         }
         catch (std::ifstream::failure e)
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
+        return std::string();
+    }
+    // compile and link the program from source code, gShaderCode may be nullptr,
+    // retrievableBinary asks the driver to keep the linked binary around for glGetProgramBinary
+    // ------------------------------------------------------------------------
+    void build(const char* vShaderCode, const char* fShaderCode, const char* gShaderCode = nullptr, bool retrievableBinary = false)
+    {
         // 2. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
@@ -72,9 +74,8 @@ public:
         checkCompileErrors(fragment, "FRAGMENT");
         // if geometry shader is given, compile geometry shader
         unsigned int geometry;
-        if(geometryPath != nullptr)
+        if(gShaderCode != nullptr)
         {
-            const char * gShaderCode = geometryCode.c_str();
             geometry = glCreateShader(GL_GEOMETRY_SHADER);
             glShaderSource(geometry, 1, &gShaderCode, NULL);
             glCompileShader(geometry);
@@ -84,16 +85,58 @@ public:
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
+        if(gShaderCode != nullptr)
             glAttachShader(ID, geometry);
+        if(retrievableBinary)
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-        if(geometryPath != nullptr)
+        if(gShaderCode != nullptr)
             glDeleteShader(geometry);
-
+        // reflect every active uniform once so the setters never have to ask the driver
+        cacheUniformLocations();
+    }
+    // compile and link a compute program, the compute counterpart of build()
+    // ------------------------------------------------------------------------
+    void buildCompute(const char* cShaderCode, bool retrievableBinary = false)
+    {
+        unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &cShaderCode, NULL);
+        glCompileShader(compute);
+        checkCompileErrors(compute, "COMPUTE");
+        ID = glCreateProgram();
+        glAttachShader(ID, compute);
+        if(retrievableBinary)
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        glDeleteShader(compute);
+        cacheUniformLocations();
+    }
+    // create the program from a binary saved by glGetProgramBinary, returns false and leaves ID at 0
+    // when the driver rejects it (other GPU, driver update...), the caller then has to build() from source
+    // ------------------------------------------------------------------------
+    bool loadBinary(GLenum format, const void* binary, GLsizei length)
+    {
+        ID = glCreateProgram();
+        glProgramBinary(ID, format, binary, length);
+        if(!isLinked())
+        {
+            glDeleteProgram(ID);
+            ID = 0;
+            return false;
+        }
+        cacheUniformLocations();
+        return true;
+    }
+    bool isLinked() const
+    {
+        GLint success = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        return success == GL_TRUE;
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -101,66 +144,173 @@ public:
     { 
         glUseProgram(ID); 
     }
+    // uniform handles
+    // ------------------------------------------------------------------------
+    // returns the location of an active uniform from the table built at link time,
+    // resolve these once outside of the render loop and pass them to the setters below
+    GLint uniform(const std::string &name) const
+    {
+        ++frameLookups();
+        std::unordered_map<std::string, GLint>::const_iterator it = uniformLocations.find(name);
+        if (it == uniformLocations.end())
+            return -1;
+        return it->second;
+    }
+    // number of name based lookups since the last resetFrameLookups(), should stay at zero in the render loop
+    static unsigned int &frameLookups()
+    {
+        static unsigned int lookups = 0;
+        return lookups;
+    }
+    static void resetFrameLookups()
+    {
+        frameLookups() = 0;
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        setBool(uniform(name), value); 
+    }
+    void setBool(GLint location, bool value) const
+    {         
+        glUniform1i(location, (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        setInt(uniform(name), value); 
+    }
+    void setInt(GLint location, int value) const
+    { 
+        glUniform1i(location, value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        setFloat(uniform(name), value); 
+    }
+    void setFloat(GLint location, float value) const
+    { 
+        glUniform1f(location, value); 
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec2(uniform(name), value); 
+    }
+    void setVec2(GLint location, const glm::vec2 &value) const
+    { 
+        glUniform2fv(location, 1, &value[0]); 
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        setVec2(uniform(name), x, y); 
+    }
+    void setVec2(GLint location, float x, float y) const
+    { 
+        glUniform2f(location, x, y); 
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec3(uniform(name), value); 
+    }
+    void setVec3(GLint location, const glm::vec3 &value) const
+    { 
+        glUniform3fv(location, 1, &value[0]); 
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        setVec3(uniform(name), x, y, z); 
+    }
+    void setVec3(GLint location, float x, float y, float z) const
+    { 
+        glUniform3f(location, x, y, z); 
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        setVec4(uniform(name), value); 
+    }
+    void setVec4(GLint location, const glm::vec4 &value) const
+    { 
+        glUniform4fv(location, 1, &value[0]); 
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        setVec4(uniform(name), x, y, z, w); 
+    }
+    void setVec4(GLint location, float x, float y, float z, float w) 
+    { 
+        glUniform4f(location, x, y, z, w); 
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat2(uniform(name), mat);
+    }
+    void setMat2(GLint location, const glm::mat2 &mat) const
+    {
+        glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat3(uniform(name), mat);
+    }
+    void setMat3(GLint location, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        setMat4(uniform(name), mat);
+    }
+    void setMat4(GLint location, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // active uniform name -> location, filled once after linking
+    std::unordered_map<std::string, GLint> uniformLocations;
+
+    // walk the active uniforms of the linked program and store their locations,
+    // arrays of basic types are reported once as "name[0]" so every element is added as well
+    // ------------------------------------------------------------------------
+    void cacheUniformLocations()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::string name(maxLength > 0 ? maxLength : 1, '\0');
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, (GLuint)i, maxLength, &length, &size, &type, &name[0]);
+            std::string uniformName(name.c_str(), length);
+            GLint location = glGetUniformLocation(ID, uniformName.c_str());
+            // uniforms that live in a uniform block have no location
+            if (location == -1)
+                continue;
+            uniformLocations[uniformName] = location;
+            if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = uniformName.substr(0, uniformName.size() - 3);
+                uniformLocations[base] = location;
+                for (GLint element = 1; element < size; element++)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+                }
+            }
+        }
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,164 @@
+#ifndef STREAM_RING_H
+#define STREAM_RING_H
+
+#include "glad.h"
+
+#include <iostream>
+
+#include "geometry_manager.h"
+#include "cpu_profiler.h"
+
+/* Regions of the ring, one per frame the GPU may still be reading */
+#define STREAM_RING_FRAMES 3
+/* Vertex buffer binding index of the vertex arrays made by StreamRing::makeVertexArray() */
+#define STREAM_RING_VERTEX_BINDING 0
+/* Start of every region and reservation, covers the SSBO and UBO offset alignments of common drivers */
+#define STREAM_RING_ALIGNMENT 256
+
+/* One buffer mapped once for the life of the program and split into STREAM_RING_FRAMES regions, frame N
+	writes region N % STREAM_RING_FRAMES. A fence placed at the end of a frame is waited on before its
+	region is written again, so the CPU never writes what the GPU is reading and nothing is ever
+	reallocated or orphaned. The mapping is coherent, plain memcpy into it needs no flush.
+	Every region starts with the reserve()d blocks, which stay put from frame to frame, followed by
+	space allocate() hands out again every frame */
+class StreamRing
+{
+public:
+	StreamRing() : ID(0), mapped(NULL), reservedSize(0), regionSize(0), region(0), used(0), stalls(0), peakUsed(0)
+		{
+			for (int i = 0; i < STREAM_RING_FRAMES; i++)
+				fences[i] = 0;
+		}
+
+	/* Room for the same data in every region, returns its offset inside a region. Only before create() */
+	GLintptr reserve(GLsizeiptr bytes)
+		{
+			GLintptr offset = reservedSize;
+			reservedSize += aligned(bytes);
+			return offset;
+		}
+
+	/* Allocate and map the buffer, transientBytes is what allocate() may hand out per frame */
+	void create(GLsizeiptr transientBytes)
+		{
+			regionSize = reservedSize + aligned(transientBytes);
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glGenBuffers(1, &ID);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+			glBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * STREAM_RING_FRAMES, NULL, flags);
+			mapped = (unsigned char *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * STREAM_RING_FRAMES, flags);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			used = reservedSize;
+
+			std::cout << "Stream ring: " << STREAM_RING_FRAMES << " regions of " << regionSize / 1024.0 << " KB ("
+				<< reservedSize << " bytes reserved)" << std::endl;
+		}
+
+	/* Move on to the next region, waiting for the GPU to finish the frame that last used it */
+	void beginFrame()
+		{
+			CPU_PROFILE_SCOPE("StreamRing::beginFrame");
+			region = (region + 1) % STREAM_RING_FRAMES;
+			used = reservedSize;
+			if (fences[region] == 0)
+				return;
+
+			if (glClientWaitSync(fences[region], 0, 0) == GL_TIMEOUT_EXPIRED)
+				{
+					stalls++;
+					/* Flush in case the fence never reached the GPU, one second covers any frame it could still be on */
+					glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+				}
+			glDeleteSync(fences[region]);
+			fences[region] = 0;
+		}
+
+	/* Call after the last command reading this frame's region */
+	void endFrame()
+		{
+			fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			if (used > peakUsed)
+				peakUsed = used;
+		}
+
+	/* Space in this frame's region only, NULL when the region is full */
+	void *allocate(GLsizeiptr bytes, GLintptr &offset)
+		{
+			if (used + bytes > regionSize)
+				return NULL;
+
+			offset = region * regionSize + used;
+			used += aligned(bytes);
+			return mapped + offset;
+		}
+
+	/* Where a reserve()d block is in this frame's region */
+	GLintptr reservedOffset(GLintptr reservation) const
+		{
+			return region * regionSize + reservation;
+		}
+
+	void *reservedPointer(GLintptr reservation) const
+		{
+			return mapped + reservedOffset(reservation);
+		}
+
+	/* Index of this frame's region, what was written to the other ones is still there */
+	int currentRegion() const
+		{
+			return region;
+		}
+
+	/* A vertex array reading the attributes from the ring, the ring and the offset of the vertices are
+		bound per draw with glBindVertexBuffer(STREAM_RING_VERTEX_BINDING, ...). Indices stay in elementBuffer */
+	unsigned int makeVertexArray(const VertexAttribute *attributes, int attributeCount, unsigned int elementBuffer) const
+		{
+			unsigned int VAO;
+			glGenVertexArrays(1, &VAO);
+			glBindVertexArray(VAO);
+			for (int i = 0; i < attributeCount; i++)
+				{
+					glVertexAttribFormat(attributes[i].location, attributes[i].components, GL_FLOAT, GL_FALSE, attributes[i].offset * sizeof(float));
+					glVertexAttribBinding(attributes[i].location, STREAM_RING_VERTEX_BINDING);
+					glEnableVertexAttribArray(attributes[i].location);
+				}
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+			glBindVertexArray(0);
+			return VAO;
+		}
+
+	unsigned int buffer() const
+		{
+			return ID;
+		}
+
+	/* Frames that had to wait for the GPU before writing their region */
+	unsigned int stalledFrames() const
+		{
+			return stalls;
+		}
+
+	/* Most bytes of a region used by one frame, reserved blocks included */
+	GLsizeiptr peakBytes() const
+		{
+			return peakUsed;
+		}
+
+private:
+	unsigned int ID;
+	unsigned char *mapped;
+	GLsync fences[STREAM_RING_FRAMES];
+	GLsizeiptr reservedSize;
+	GLsizeiptr regionSize;
+	int region;
+	/* Bytes of the current region taken, reserved blocks included */
+	GLsizeiptr used;
+	unsigned int stalls;
+	GLsizeiptr peakUsed;
+
+	static GLsizeiptr aligned(GLsizeiptr bytes)
+		{
+			return (bytes + STREAM_RING_ALIGNMENT - 1) / STREAM_RING_ALIGNMENT * STREAM_RING_ALIGNMENT;
+		}
+};
+#endif
@@ -0,0 +1,305 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "glad.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <utility>
+#include <atomic>
+#include <thread>
+
+#include "texture_loader.h"
+#include "asset_pack.h"
+#include "filesystem.h"
+
+/* One GL texture shared by every acquire() of the same file or of a file with the same contents */
+struct TextureCacheEntry
+{
+	unsigned int textureID;
+	unsigned int references;
+	std::string path;
+	uint64_t contentHash;
+};
+
+/* Hands out reference counted textures, loading each distinct image only once.
+	A request is first matched by name, then by a hash of the file bytes, so a copy of an image under
+	another name also ends up on the same texture. Decoding and uploading is left to the TextureLoader.
+	Files come from the asset pack when one is given and holds them, otherwise from FileSystem::getPath().
+	Loose files are read and hashed in acquire() unless prefetch() already did that on worker threads */
+class TextureCache
+{
+public:
+	TextureCache(TextureLoader &loader, const AssetPack *pack = NULL) : loader(loader), pack(pack), requests(0), bakedLoads(0), packLoads(0), reported(false)
+		{
+		}
+
+	/* The texture of the file name, loaded on first use. Every call has to be matched by a release() */
+	unsigned int acquire(const std::string &name)
+		{
+			requests++;
+
+			std::unordered_map<std::string, unsigned int>::iterator byName = paths.find(name);
+			if (byName != paths.end())
+				{
+					entries[byName->second].references++;
+					return byName->second;
+				}
+
+			TextureSource source;
+			std::unordered_map<std::string, TextureSource>::iterator read = prefetched.find(name);
+			if (read != prefetched.end())
+				{
+					source = std::move(read->second);
+					if (!source.file.empty())
+						source.bytes = &source.file[0];
+					prefetched.erase(read);
+				}
+			else
+				findSource(name, source);
+
+			/* An unreadable file is never matched by content, it just keeps its placeholder */
+			if (source.bytes != NULL)
+				{
+					std::unordered_map<uint64_t, unsigned int>::iterator byContent = contents.find(source.contentHash);
+					if (byContent != contents.end())
+						{
+							entries[byContent->second].references++;
+							paths[name] = byContent->second;
+							return byContent->second;
+						}
+				}
+
+			unsigned int textureID;
+			if (source.mapped)
+				textureID = loader.load(name.c_str(), source.bytes, source.size);
+			else
+				textureID = loader.load(FileSystem::getPath(name).c_str(), std::move(source.file));
+			bakedLoads += source.baked ? 1 : 0;
+			packLoads += source.mapped ? 1 : 0;
+
+			TextureCacheEntry entry;
+			entry.textureID = textureID;
+			entry.references = 1;
+			entry.path = name;
+			entry.contentHash = source.contentHash;
+			entries[textureID] = entry;
+			paths[name] = textureID;
+			if (source.bytes != NULL)
+				contents[source.contentHash] = textureID;
+
+			return textureID;
+		}
+
+	/* Read and hash the loose files of names all at once, one thread per hardware thread, so the acquire() calls
+		that follow do no file I/O on the GL thread. Content sharing stays exact because it is still decided in
+		acquire(), before anyone holds the texture. Names already loaded or in the asset pack are skipped */
+	void prefetch(const char *const *names, size_t count)
+		{
+			std::vector<std::string> files;
+			for (size_t i = 0; i < count; i++)
+				{
+					std::string name = names[i];
+					AssetView view;
+					bool packed = pack != NULL && (pack->find(name, view) || pack->find(bakedPath(name), view));
+					if (paths.count(name) > 0 || prefetched.count(name) > 0 || packed)
+						continue;
+					bool listed = false;
+					for (size_t f = 0; f < files.size() && !listed; f++)
+						listed = files[f] == name;
+					if (!listed)
+						files.push_back(name);
+				}
+			if (files.empty())
+				return;
+
+			std::vector<TextureSource> sources(files.size());
+			std::atomic<size_t> next(0);
+			size_t threadCount = std::thread::hardware_concurrency();
+			if (threadCount == 0)
+				threadCount = 1;
+			if (threadCount > files.size())
+				threadCount = files.size();
+			std::vector<std::thread> readers;
+			for (size_t t = 0; t < threadCount; t++)
+				readers.push_back(std::thread([&]()
+					{
+						for (size_t i = next++; i < files.size(); i = next++)
+							readSource(files[i], sources[i]);
+					}));
+			for (size_t t = 0; t < readers.size(); t++)
+				readers[t].join();
+
+			for (size_t i = 0; i < files.size(); i++)
+				prefetched[files[i]] = std::move(sources[i]);
+		}
+
+	/* Drop one reference, the texture is deleted with the last one */
+	void release(unsigned int textureID)
+		{
+			std::unordered_map<unsigned int, TextureCacheEntry>::iterator it = entries.find(textureID);
+			if (it == entries.end())
+				return;
+
+			if (--it->second.references > 0)
+				return;
+
+			for (std::unordered_map<std::string, unsigned int>::iterator p = paths.begin(); p != paths.end(); )
+				{
+					if (p->second == textureID)
+						p = paths.erase(p);
+					else
+						++p;
+				}
+			std::unordered_map<uint64_t, unsigned int>::iterator c = contents.find(it->second.contentHash);
+			if (c != contents.end() && c->second == textureID)
+				contents.erase(c);
+
+			glDeleteTextures(1, &textureID);
+			entries.erase(it);
+		}
+
+	/* GPU memory the shared textures would have taken again had every request got its own copy */
+	size_t bytesSaved() const
+		{
+			size_t saved = 0;
+			for (std::unordered_map<unsigned int, TextureCacheEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+				saved += (size_t)(it->second.references - 1) * loader.textureBytes(it->first);
+			return saved;
+		}
+
+	/* Print the savings once every texture is uploaded, call once per frame after TextureLoader::update() */
+	void reportWhenLoaded()
+		{
+			if (reported || !loader.isDone())
+				return;
+
+			size_t resident = 0;
+			for (std::unordered_map<unsigned int, TextureCacheEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+				resident += loader.textureBytes(it->first);
+
+			std::cout << "Texture cache: " << entries.size() << " textures for " << requests << " requests (" << bakedLoads << " baked, "
+				<< packLoads << " from the asset pack), "
+				<< resident / (1024 * 1024) << " MB resident, " << bytesSaved() / (1024 * 1024) << " MB of GPU memory saved" << std::endl;
+			reported = true;
+		}
+
+private:
+	TextureLoader &loader;
+	const AssetPack *pack;
+	unsigned int requests;
+	/* Textures that came from a baked file, and from the asset pack */
+	unsigned int bakedLoads;
+	unsigned int packLoads;
+	bool reported;
+
+	std::unordered_map<unsigned int, TextureCacheEntry> entries;
+	std::unordered_map<std::string, unsigned int> paths;
+	std::unordered_map<uint64_t, unsigned int> contents;
+
+	/* Where the bytes of a texture come from */
+	struct TextureSource
+	{
+		TextureSource() : bytes(NULL), size(0), contentHash(0), mapped(false), baked(false)
+			{
+			}
+
+		/* Read from a loose file */
+		std::vector<unsigned char> file;
+		/* Points into file, into the pack mapping, or NULL when nothing could be read */
+		const unsigned char *bytes;
+		size_t size;
+		uint64_t contentHash;
+		bool mapped;
+		bool baked;
+	};
+
+	/* A baked KTX2 file replaces the image, unless the driver can not sample its format. The pack is
+		tried before loose files, its views are used in place without a copy */
+	void findSource(const std::string &name, TextureSource &source) const
+		{
+			source.bytes = NULL;
+			source.size = 0;
+			source.contentHash = 0;
+			source.mapped = false;
+			source.baked = false;
+
+			AssetView view;
+			if (pack != NULL && pack->find(bakedPath(name), view) && usableBaked(view.data, view.size))
+				source.baked = true;
+			else if (pack == NULL || !pack->find(name, view))
+				view.data = NULL;
+
+			if (view.data != NULL)
+				{
+					source.bytes = view.data;
+					source.size = view.size;
+					source.contentHash = view.contentHash;
+					source.mapped = true;
+					return;
+				}
+			readSource(name, source);
+		}
+
+	/* A loose file, baked if possible, with its hash. Touches nothing but source, so prefetch() runs it on any thread */
+	void readSource(const std::string &name, TextureSource &source) const
+		{
+			readFile(FileSystem::getPath(bakedPath(name)), source.file);
+			if (!source.file.empty() && usableBaked(&source.file[0], source.file.size()))
+				source.baked = true;
+			else
+				{
+					source.file.clear();
+					readFile(FileSystem::getPath(name), source.file);
+				}
+
+			if (!source.file.empty())
+				{
+					source.bytes = &source.file[0];
+					source.size = source.file.size();
+					source.contentHash = assetPackHash(source.bytes, source.size);
+				}
+		}
+
+	/* Read by prefetch() and not acquired yet, bytes is pointed at file again when it is taken */
+	std::unordered_map<std::string, TextureSource> prefetched;
+
+	bool usableBaked(const unsigned char *bytes, size_t size) const
+		{
+			Ktx2Image baked;
+			return parseKtx2(bytes, size, baked) && loader.supportsCompressed(baked.vkFormat);
+		}
+
+	/* image.jpg -> image.ktx2, where the baker puts it */
+	static std::string bakedPath(const std::string &path)
+		{
+			size_t dot = path.find_last_of('.');
+			size_t slash = path.find_last_of('/');
+			if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+				return path + ".ktx2";
+			return path.substr(0, dot) + ".ktx2";
+		}
+
+	static void readFile(const std::string &path, std::vector<unsigned char> &file)
+		{
+			FILE *handle = fopen(path.c_str(), "rb");
+			if (handle == NULL)
+				return;
+
+			fseek(handle, 0, SEEK_END);
+			long size = ftell(handle);
+			fseek(handle, 0, SEEK_SET);
+			if (size > 0)
+				{
+					file.resize(size);
+					if (fread(&file[0], 1, size, handle) != (size_t)size)
+						file.clear();
+				}
+			fclose(handle);
+		}
+};
+#endif
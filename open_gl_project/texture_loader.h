@@ -0,0 +1,447 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include "glad.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+
+#include "stb_image.h"
+#include "ktx2.h"
+#include "cpu_profiler.h"
+
+/* Pixel unpack buffers cycled through by the uploads, one upload per buffer in flight */
+#define TEXTURE_LOADER_PBO_COUNT 4
+/* Textures uploaded per update(), keeps a frame from stalling when many decodes finish at once */
+#define TEXTURE_LOADER_UPLOADS_PER_FRAME 4
+
+/* A decode request, filled in by a worker and handed back to the GL thread */
+struct TextureJob
+{
+	unsigned int textureID;
+	std::string path;
+	/* The encoded file when the caller already read it, otherwise the worker reads path */
+	std::vector<unsigned char> file;
+	/* The encoded bytes, either file's or memory the caller keeps alive such as an asset pack mapping */
+	const unsigned char *bytes;
+	size_t size;
+	/* Baked KTX2 files skip decoding, their blocks are uploaded straight from file */
+	bool compressed;
+	Ktx2Image ktx2;
+	unsigned char *data;
+	int width;
+	int height;
+	int components;
+};
+
+/* Decodes images on worker threads and uploads them through a ring of PBOs on the GL thread.
+	load() returns a texture straight away holding a 1x1 placeholder texel, the real image replaces it
+	in one of the following update() calls, so the render loop can start before anything is decoded */
+class TextureLoader
+{
+public:
+	/* workerCount 0 uses one worker per hardware thread */
+	TextureLoader(unsigned int workerCount = 0) : pending(0), nextPBO(0), stopping(false), reported(false)
+		{
+			if (workerCount == 0)
+				workerCount = std::thread::hardware_concurrency();
+			if (workerCount == 0)
+				workerCount = 1;
+
+			/* stb_image keeps the flag in a global, it has to be set before any worker starts decoding */
+			stbi_set_flip_vertically_on_load(true);
+
+			for (int i = 0; i < TEXTURE_LOADER_PBO_COUNT; i++)
+				{
+					PBOs[i] = 0;
+					PBOSizes[i] = 0;
+					fences[i] = 0;
+				}
+			glGenBuffers(TEXTURE_LOADER_PBO_COUNT, PBOs);
+
+			GLint formatCount = 0;
+			glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formatCount);
+			if (formatCount > 0)
+				{
+					compressedFormats.resize(formatCount);
+					glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, &compressedFormats[0]);
+				}
+
+			start = std::chrono::steady_clock::now();
+			for (unsigned int i = 0; i < workerCount; i++)
+				workers.push_back(std::thread(&TextureLoader::workerLoop, this));
+		}
+
+	~TextureLoader()
+		{
+			stopWorkers();
+		}
+
+	/* Create the texture with its placeholder and queue the decode, must be called on the GL thread */
+	unsigned int load(const char *path)
+		{
+			TextureJob job;
+			job.bytes = NULL;
+			job.size = 0;
+			return queue(path, job);
+		}
+
+	/* Same as above for a file the caller has read already, path is only used in messages */
+	unsigned int load(const char *path, std::vector<unsigned char> file)
+		{
+			TextureJob job;
+			job.file.swap(file);
+			job.bytes = job.file.empty() ? NULL : &job.file[0];
+			job.size = job.file.size();
+			return queue(path, job);
+		}
+
+	/* Same again without a copy, bytes has to stay valid until the texture is uploaded */
+	unsigned int load(const char *path, const unsigned char *bytes, size_t size)
+		{
+			TextureJob job;
+			job.bytes = bytes;
+			job.size = size;
+			return queue(path, job);
+		}
+
+	/* Upload decoded images, call once per frame on the GL thread. Returns true once every texture is in */
+	bool update(int maxUploads = TEXTURE_LOADER_UPLOADS_PER_FRAME)
+		{
+			CPU_PROFILE_SCOPE("TextureLoader::update");
+			for (int uploads = 0; uploads < maxUploads; uploads++)
+				{
+					TextureJob job;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						if (decoded.empty())
+							break;
+						job = std::move(decoded.front());
+						decoded.pop_front();
+					}
+
+					if (job.compressed)
+						uploadCompressed(job);
+					else
+						upload(job);
+					stbi_image_free(job.data);
+
+					std::lock_guard<std::mutex> lock(mutex);
+					pending--;
+				}
+
+			bool done = isDone();
+			if (done && !reported)
+				{
+					std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+					std::cout << "Textures: all loaded on " << workers.size() << " worker threads after " << elapsed.count() << " ms" << std::endl;
+					reported = true;
+				}
+
+			return done;
+		}
+
+	/* Block until every queued texture is uploaded, for when placeholders are not acceptable */
+	void finish()
+		{
+			while (!update(TEXTURE_LOADER_PBO_COUNT))
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+	bool isDone()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return pending == 0;
+		}
+
+	/* GL internal format of a KTX2 block format, 0 for anything else */
+	static GLenum compressedFormat(uint32_t vkFormat)
+		{
+			if (vkFormat == KTX2_VK_FORMAT_BC1_RGB_UNORM_BLOCK)
+				return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			if (vkFormat == KTX2_VK_FORMAT_BC3_UNORM_BLOCK)
+				return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			if (vkFormat == KTX2_VK_FORMAT_BC7_UNORM_BLOCK)
+				return GL_COMPRESSED_RGBA_BPTC_UNORM;
+			return 0;
+		}
+
+	/* Whether the driver takes baked files of this format, otherwise the caller should load the source image */
+	bool supportsCompressed(uint32_t vkFormat) const
+		{
+			/* Core profiles may leave formats out of GL_COMPRESSED_TEXTURE_FORMATS, so trust the version and extensions first */
+			if (vkFormat == KTX2_VK_FORMAT_BC7_UNORM_BLOCK && (GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_texture_compression_bptc))
+				return true;
+			if (vkFormat != KTX2_VK_FORMAT_BC7_UNORM_BLOCK && GLAD_GL_EXT_texture_compression_s3tc)
+				return true;
+
+			GLenum format = compressedFormat(vkFormat);
+			for (size_t i = 0; i < compressedFormats.size(); i++)
+				if ((GLenum)compressedFormats[i] == format)
+					return true;
+			return false;
+		}
+
+	/* Approximate GPU memory of an uploaded texture including its mipmaps, 0 while it is still a placeholder */
+	size_t textureBytes(unsigned int textureID) const
+		{
+			std::unordered_map<unsigned int, size_t>::const_iterator it = uploadedBytes.find(textureID);
+			if (it == uploadedBytes.end())
+				return 0;
+			return it->second;
+		}
+
+	/* Free the GL side, has to run while the context is still current */
+	void shutdown()
+		{
+			stopWorkers();
+
+			for (size_t i = 0; i < decoded.size(); i++)
+				stbi_image_free(decoded[i].data);
+			decoded.clear();
+
+			for (int i = 0; i < TEXTURE_LOADER_PBO_COUNT; i++)
+				if (fences[i] != 0)
+					{
+						glDeleteSync(fences[i]);
+						fences[i] = 0;
+					}
+			glDeleteBuffers(TEXTURE_LOADER_PBO_COUNT, PBOs);
+		}
+
+private:
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable wake;
+	/* Waiting for a worker */
+	std::deque<TextureJob> jobs;
+	/* Decoded, waiting for the GL thread */
+	std::deque<TextureJob> decoded;
+	/* Queued and not uploaded yet */
+	unsigned int pending;
+
+	unsigned int PBOs[TEXTURE_LOADER_PBO_COUNT];
+	GLsizeiptr PBOSizes[TEXTURE_LOADER_PBO_COUNT];
+	/* Signalled once the upload from the matching PBO has been consumed */
+	GLsync fences[TEXTURE_LOADER_PBO_COUNT];
+	int nextPBO;
+
+	/* GL_COMPRESSED_TEXTURE_FORMATS of the driver */
+	std::vector<GLint> compressedFormats;
+
+	/* Filled on the GL thread as uploads complete */
+	std::unordered_map<unsigned int, size_t> uploadedBytes;
+
+	bool stopping;
+	bool reported;
+	std::chrono::steady_clock::time_point start;
+
+	unsigned int queue(const char *path, TextureJob &job)
+		{
+			unsigned int textureID;
+			glGenTextures(1, &textureID);
+			glBindTexture(GL_TEXTURE_2D, textureID);
+
+			/* Mid gray until the image arrives, no mipmaps yet so the min filter can not ask for them */
+			unsigned char placeholder[4] = { 128, 128, 128, 255 };
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+			job.textureID = textureID;
+			job.path = path;
+			job.compressed = false;
+			job.data = NULL;
+			job.width = job.height = job.components = 0;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				jobs.push_back(std::move(job));
+				pending++;
+			}
+			wake.notify_one();
+
+			return textureID;
+		}
+
+	void workerLoop()
+		{
+			CPU_PROFILE_THREAD("texture worker");
+			for (;;)
+				{
+					TextureJob job;
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+						if (stopping)
+							return;
+						job = std::move(jobs.front());
+						jobs.pop_front();
+					}
+
+					{
+						CPU_PROFILE_SCOPE("TextureLoader decode");
+						if (job.bytes == NULL)
+							job.data = stbi_load(job.path.c_str(), &job.width, &job.height, &job.components, 0);
+						else if (isKtx2(job.bytes, job.size))
+							{
+								/* Nothing to decode, only check the level index, the data stays where it is */
+								job.compressed = parseKtx2(job.bytes, job.size, job.ktx2);
+							}
+						else
+							job.data = stbi_load_from_memory(job.bytes, (int)job.size, &job.width, &job.height, &job.components, 0);
+					}
+					if (!job.compressed)
+						{
+							std::vector<unsigned char>().swap(job.file);
+							job.bytes = NULL;
+							job.size = 0;
+						}
+
+					std::lock_guard<std::mutex> lock(mutex);
+					decoded.push_back(std::move(job));
+				}
+		}
+
+	void stopWorkers()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_all();
+			for (size_t i = 0; i < workers.size(); i++)
+				if (workers[i].joinable())
+					workers[i].join();
+		}
+
+	/* Wait for the GPU to be done with the oldest buffer of the ring, then bind it with room for size bytes */
+	int acquirePBO(GLsizeiptr size)
+		{
+			int slot = nextPBO;
+			nextPBO = (nextPBO + 1) % TEXTURE_LOADER_PBO_COUNT;
+			if (fences[slot] != 0)
+				{
+					glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+					glDeleteSync(fences[slot]);
+					fences[slot] = 0;
+				}
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBOs[slot]);
+			if (PBOSizes[slot] < size)
+				{
+					glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+					PBOSizes[slot] = size;
+				}
+			return slot;
+		}
+
+	/* Every level of a baked file in one copy, the level offsets in the PBO are the offsets in the file */
+	void uploadCompressed(const TextureJob &job)
+		{
+			GLenum format = compressedFormat(job.ktx2.vkFormat);
+			GLsizeiptr size = (GLsizeiptr)job.size;
+
+			int slot = acquirePBO(size);
+			void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			if (mapped != NULL)
+				{
+					memcpy(mapped, job.bytes, size);
+					glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				}
+			else
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			glBindTexture(GL_TEXTURE_2D, job.textureID);
+			size_t bytes = 0;
+			for (size_t level = 0; level < job.ktx2.levels.size(); level++)
+				{
+					const Ktx2Level &data = job.ktx2.levels[level];
+					GLsizei width = job.ktx2.width >> level ? job.ktx2.width >> level : 1;
+					GLsizei height = job.ktx2.height >> level ? job.ktx2.height >> level : 1;
+					/* An offset into the PBO, or client memory when the mapping failed */
+					const void *pixels = mapped != NULL ? (const void *)(uintptr_t)data.byteOffset : (const void *)(job.bytes + data.byteOffset);
+					glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, format, width, height, 0, (GLsizei)data.byteLength, pixels);
+					bytes += data.byteLength;
+				}
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			uploadedBytes[job.textureID] = bytes;
+
+			/* The file carries the whole chain, nothing to generate */
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)job.ktx2.levels.size() - 1);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+
+	void upload(const TextureJob &job)
+		{
+			if (job.data == NULL)
+				{
+					/* The placeholder stays */
+					std::cout << "Texture failed to load at path: " << job.path << std::endl;
+					return;
+				}
+
+			GLenum format = GL_RGB;
+			/* Sized, so the texture can be copied into immutable storage like the IndirectRenderer's layers */
+			GLenum internalFormat = GL_RGB8;
+			if (job.components == 1)
+				{
+					format = GL_RED;
+					internalFormat = GL_R8;
+				}
+			else if (job.components == 3)
+				{
+					format = GL_RGB;
+					internalFormat = GL_RGB8;
+				}
+			else if (job.components == 4)
+				{
+					format = GL_RGBA;
+					internalFormat = GL_RGBA8;
+				}
+
+			GLsizeiptr size = (GLsizeiptr)job.width * job.height * job.components;
+
+			int slot = acquirePBO(size);
+			void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			if (mapped != NULL)
+				{
+					memcpy(mapped, job.data, size);
+					glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				}
+
+			glBindTexture(GL_TEXTURE_2D, job.textureID);
+			/* With a PBO bound the last argument is an offset into it */
+			if (mapped != NULL)
+				glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, job.width, job.height, 0, format, GL_UNSIGNED_BYTE, 0);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			/* The driver refused the mapping, upload from client memory instead */
+			if (mapped == NULL)
+				glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, job.width, job.height, 0, format, GL_UNSIGNED_BYTE, job.data);
+
+			fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			/* The mipmap chain adds about a third */
+			uploadedBytes[job.textureID] = (size_t)size * 4 / 3;
+
+			glGenerateMipmap(GL_TEXTURE_2D);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+};
+#endif
@@ -3,8 +3,14 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
 
 out vec3 ourColor;
 
@@ -0,0 +1,130 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include "glad.h"
+#include <glm/glm.hpp>
+#include "cpu_profiler.h"
+
+/* Binding points, these are the same numbers as the layout(binding = N) qualifiers in the shaders */
+#define CAMERA_UBO_BINDING 0
+#define WALL_LIGHTS_UBO_BINDING 1
+#define FLOOR_LIGHTS_UBO_BINDING 2
+#define CELLING_LIGHTS_UBO_BINDING 3
+#define CLUSTER_GRID_UBO_BINDING 4
+
+/* The structs below mirror the std140 layout of the blocks in the shaders,
+	every vec3 is padded out to 16 bytes unless a float can fill its 4th component */
+
+/* uniform Camera: written once per frame and read by every program */
+struct CameraBlock
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec3 viewPos;
+	float padding;
+};
+
+struct DirLightBlock
+{
+	glm::vec3 direction;
+	float padding0;
+	glm::vec3 ambient;
+	float padding1;
+	glm::vec3 diffuse;
+	float padding2;
+	glm::vec3 specular;
+	float padding3;
+};
+
+/* The float members sit in the 4th component of the vec3 before them. std430 packs it the same way,
+	so this is also one element of the point light storage buffer, see ClusteredLights */
+struct PointLightBlock
+{
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	/* Past this distance the light adds less than one 8 bit step, it is not binned into clusters further away */
+	float radius;
+};
+
+/* uniform Lights: one copy for each of the wall, floor and celling shaders. The point lights are shared
+	by all three, each surface scales their colours by its own pointLightTint */
+struct LightBlock
+{
+	DirLightBlock dirLight;
+	glm::vec3 pointLightTint;
+	float padding;
+};
+
+/* uniform ClusterGrid: how a fragment finds its cluster, written when the projection or window size changes */
+struct ClusterGridBlock
+{
+	glm::mat4 inverseProjection;
+	/* Pixels covered by one cluster column */
+	glm::vec2 tileSize;
+	/* slice = log(-viewZ) * sliceScale + sliceBias */
+	float sliceScale;
+	float sliceBias;
+	float zNear;
+	float zFar;
+	GLuint lightCount;
+	float padding;
+};
+
+/* Catch a struct drifting away from the std140 layout at compile time */
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock does not match the std140 Camera block");
+static_assert(sizeof(DirLightBlock) == 64, "DirLightBlock does not match the std140 DirLight struct");
+static_assert(sizeof(PointLightBlock) == 64, "PointLightBlock does not match the std140 PointLight struct");
+static_assert(sizeof(LightBlock) == 80, "LightBlock does not match the std140 Lights block");
+static_assert(sizeof(ClusterGridBlock) == 96, "ClusterGridBlock does not match the std140 ClusterGrid block");
+
+/* Thin wrapper around a GL_UNIFORM_BUFFER object */
+class UniformBuffer
+{
+public:
+	unsigned int ID;
+	GLsizeiptr size;
+
+	/* Allocate the storage once, the contents are written with update() */
+	UniformBuffer(GLsizeiptr size) : size(size)
+		{
+			glGenBuffers(1, &ID);
+			glBindBuffer(GL_UNIFORM_BUFFER, ID);
+			glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		}
+
+	/* Attach the whole buffer to a binding point */
+	void bind(GLuint binding) const
+		{
+			glBindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+		}
+
+	/* Attach part of the buffer to a binding point, offset must be aligned, see alignedSize() */
+	void bindRange(GLuint binding, GLintptr offset, GLsizeiptr rangeSize) const
+		{
+			glBindBufferRange(GL_UNIFORM_BUFFER, binding, ID, offset, rangeSize);
+		}
+
+	void update(GLintptr offset, GLsizeiptr dataSize, const void *data) const
+		{
+			CPU_PROFILE_SCOPE("UniformBuffer::update");
+			glBindBuffer(GL_UNIFORM_BUFFER, ID);
+			glBufferSubData(GL_UNIFORM_BUFFER, offset, dataSize, data);
+		}
+
+	/* Round a block size up to the offset alignment the driver requires for bindRange() */
+	static GLsizeiptr alignedSize(GLsizeiptr blockSize)
+		{
+			GLint alignment = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			if (alignment <= 0)
+				return blockSize;
+			return (blockSize + alignment - 1) / alignment * alignment;
+		}
+};
+#endif
@@ -2,20 +2,45 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+/* one matrix per corridor segment, and the segments drawn this frame; instance i is segment drawnSegments[i], see InstanceBuffer */
+layout (std430, binding = 8) readonly buffer SegmentModels
+{
+	mat4 segmentModels[];
+};
+layout (std430, binding = 9) readonly buffer DrawnSegments
+{
+	uint drawnSegments[];
+};
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
+/* where this segment's light list starts in ObjectLightIndices and how long it is */
+flat out uint ObjectLightFirst;
+flat out uint ObjectLightCount;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+/* per frame camera data, shared by every program */
+layout (std140, binding = 0) uniform Camera
+{
+	mat4 projection;
+	mat4 view;
+	vec3 viewPos;
+};
+
+/* first index and count of the light list of every drawn segment, instance i is the i-th one, filled by LightCuller */
+layout (std430, binding = 6) readonly buffer ObjectLightRanges
+{
+	uvec2 objectLightRanges[];
+};
 
 void main()
 {
+    mat4 model = segmentModels[drawnSegments[gl_InstanceID]];
     FragPos = vec3(model * vec4(aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;  
     TexCoords = aTexCoords;
+    ObjectLightFirst = objectLightRanges[gl_InstanceID].x;
+    ObjectLightCount = objectLightRanges[gl_InstanceID].y;
 
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file